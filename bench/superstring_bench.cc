@@ -0,0 +1,773 @@
+// superstring_bench.cc - Microbenchmarks for the superstring public methods.
+// @kwegner
+
+/*
+MIT License
+
+Copyright (c) 2018 Kristen Wegner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+// Usage: superstring_bench [--filter text] [--min-time seconds] [--json path|-]
+//
+// Runs each method family over inputs of several sizes, and prints the time per call and the
+// throughput over the input. With --json, also writes the results as a JSON document, so that
+// runs of two versions can be diffed; for -, the document goes to stdout and the table to
+// stderr. --filter keeps only the benchmarks whose "family/name" contains text.
+
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "superstring.hh"
+
+
+namespace
+{
+	// Accumulates benchmark results, so that the optimizer cannot discard the work.
+	volatile size_t sink_ = 0;
+
+	// A single benchmark measurement.
+	struct result
+	{
+		std::string family;
+		std::string name;
+		size_t size;
+		unsigned long long iterations;
+		double nanoseconds;
+		double megabytes;
+	};
+
+	// Command line options.
+	struct options
+	{
+		const char* filter = nullptr;
+		const char* json = nullptr;
+		double min_time = 0.1;
+		FILE* log = stdout;
+	};
+
+	// Generates size characters of deterministic text: lower-case words separated by spaces,
+	// with a comma every few words, and padded with whitespace at both ends for trim.
+	std::string make_text(size_t size)
+	{
+		std::string result;
+		result.reserve(size);
+
+		uint32_t state = 0x2545F491U;
+		size_t words = 0;
+
+		if (size >= 4)
+			result.append("  ");
+
+		while (result.length() + 2 < size)
+		{
+			state = state * 1664525U + 1013904223U;
+			size_t length = 2 + (state >> 28) % 8;
+
+			for (size_t i = 0; i < length && result.length() + 2 < size; ++i)
+			{
+				state = state * 1664525U + 1013904223U;
+				result.push_back(char('a' + (state >> 24) % 26));
+			}
+
+			if (result.length() + 2 < size)
+				result.push_back((++words % 5) == 0 ? ',' : ' ');
+		}
+
+		while (result.length() < size)
+			result.push_back(' ');
+
+		return result;
+	}
+
+	// Runs and reports benchmarks, collecting their results.
+	class runner
+	{
+	private:
+
+		const options& _options;
+		std::vector<result> _results;
+
+	public:
+
+		explicit runner(const options& value) : _options(value) { }
+
+		const std::vector<result>& results() const { return _results; }
+
+		// Times body, which returns a value to keep, over batches of doubling size until one
+		// batch runs for at least the minimum time. Size is the input length in bytes.
+		template <typename F>
+		void operator()(const char* family, const char* name, size_t size, F body)
+		{
+			if (_options.filter != nullptr)
+			{
+				std::string key = std::string(family) + "/" + name;
+
+				if (key.find(_options.filter) == std::string::npos)
+					return;
+			}
+
+			typedef std::chrono::steady_clock clock;
+
+			unsigned long long count = 1;
+			double seconds = 0.0;
+
+			for (;;)
+			{
+				size_t keep = 0;
+				auto start = clock::now();
+
+				for (unsigned long long i = 0; i < count; ++i)
+					keep += size_t(body());
+
+				seconds = std::chrono::duration<double>(clock::now() - start).count();
+				sink_ = sink_ + keep;
+
+				if (seconds >= _options.min_time)
+					break;
+
+				double scale = seconds > 0.0 ? (_options.min_time * 1.25) / seconds : 100.0;
+
+				count = (unsigned long long)(count * std::min(std::max(scale, 2.0), 100.0));
+			}
+
+			result r;
+			r.family = family;
+			r.name = name;
+			r.size = size;
+			r.iterations = count;
+			r.nanoseconds = seconds * 1e9 / double(count);
+			r.megabytes = size > 0 ? (double(size) * double(count)) / seconds / 1e6 : 0.0;
+
+			std::fprintf(_options.log, "%-10s %-48s %6zu %14.1f ns %10.1f MB/s\n", family, name, size, r.nanoseconds, r.megabytes);
+			std::fflush(_options.log);
+
+			_results.push_back(r);
+		}
+	};
+
+	// Writes value as a quoted JSON string.
+	void write_json_string(FILE* file, const std::string& value)
+	{
+		std::fputc('"', file);
+
+		for (char c : value)
+		{
+			if (c == '"' || c == '\\')
+				std::fprintf(file, "\\%c", c);
+			else if ((unsigned char)c < 0x20)
+				std::fprintf(file, "\\u%04X", unsigned(c));
+			else std::fputc(c, file);
+		}
+
+		std::fputc('"', file);
+	}
+
+	// Writes the results as a JSON document, with build details for comparing runs.
+	bool write_json(const char* path, const std::vector<result>& results)
+	{
+		bool console = std::strcmp(path, "-") == 0;
+		FILE* file = console ? stdout : std::fopen(path, "w");
+
+		if (file == nullptr)
+			return false;
+
+#if defined(__AVX2__)
+		const char* simd = "avx2";
+#elif defined(__SSSE3__)
+		const char* simd = "ssse3";
+#else
+		const char* simd = "none";
+#endif
+
+#if defined(__VERSION__)
+		const char* compiler = __VERSION__;
+#elif defined(_MSC_FULL_VER)
+		const std::string version = std::to_string(_MSC_FULL_VER);
+		const char* compiler = version.c_str();
+#else
+		const char* compiler = "unknown";
+#endif
+
+		std::fprintf(file, "{\n  \"context\": {\n    \"compiler\": ");
+		write_json_string(file, compiler);
+		std::fprintf(file, ",\n    \"standard\": %ld,\n    \"simd\": \"%s\"\n  },\n  \"benchmarks\": [", long(__cplusplus), simd);
+
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const result& r = results[i];
+
+			std::fprintf(file, "%s\n    { \"family\": ", i ? "," : "");
+			write_json_string(file, r.family);
+			std::fprintf(file, ", \"name\": ");
+			write_json_string(file, r.name);
+			std::fprintf(file, ", \"size\": %zu, \"iterations\": %llu, \"ns_per_op\": %.3f, \"mb_per_s\": %.3f }",
+				r.size, r.iterations, r.nanoseconds, r.megabytes);
+		}
+
+		std::fprintf(file, "\n  ]\n}\n");
+
+		if (!console)
+			std::fclose(file);
+
+		return true;
+	}
+
+	// Tokenization: split, split_with and tokens, into copies, views and tables.
+	void bench_split(runner& run, size_t size)
+	{
+		const super::string text(make_text(size).c_str());
+		std::vector<super::string> copies;
+		std::vector<super::string_view> views;
+		super::string_table table;
+
+		run("split", "split(char, vector<string>&)", size, [&] { copies.clear(); return text.split(',', copies); });
+		run("split", "split(const char*, vector<string>&)", size, [&] { copies.clear(); return text.split(" ,", copies); });
+		run("split", "split(const char*)", size, [&] { return text.split(" ,").size(); });
+		run("split", "split(const char*, vector<string_view>&)", size, [&] { views.clear(); return text.split(" ,", views); });
+		run("split", "split(const char*, string_table&)", size, [&] { table.clear(); return text.split(" ,", table); });
+		run("split", "split_with(const char*, vector<string>&)", size, [&] { copies.clear(); return text.split_with(" ,", copies, " "); });
+		run("split", "split_with(const char*, vector<string_view>&)", size, [&] { views.clear(); return text.split_with(" ,", views, " "); });
+		run("split", "tokens(const char*)", size, [&] { size_t n = 0; for (const auto& t : text.tokens(" ,")) n += t.length(); return n; });
+		run("split", "string_view::split(const char*, vector&)", size, [&] { views.clear(); return super::string_view(text).split(" ,", views); });
+	}
+
+	// Counting characters and substrings, against a split to count them.
+	void bench_count(runner& run, size_t size)
+	{
+		const super::string text(make_text(size).c_str());
+		const super::searcher comma(", ");
+		std::vector<super::string_view> views;
+		std::vector<size_t> offsets;
+
+		run("count", "split(char, vector<string_view>&).size()", size, [&] { views.clear(); return text.split(',', views); });
+		run("count", "std::count", size, [&] { return size_t(std::count(text.begin(), text.end(), ',')); });
+		run("count", "count(char)", size, [&] { return text.count(','); });
+		run("count", "count(const char*)", size, [&] { return text.count(" ,"); });
+		run("count", "count(const searcher&)", size, [&] { return text.count(comma); });
+		run("count", "find_all(const searcher&, vector<size_t>&)", size, [&] { offsets.clear(); return text.find_all(comma, offsets); });
+	}
+
+	// Trimming, in place on a copy and as copies.
+	void bench_trim(runner& run, size_t size)
+	{
+		const super::string text(make_text(size).c_str());
+
+		run("trim", "trim() const", size, [&] { return text.trim().length(); });
+		run("trim", "trim_left() const", size, [&] { return text.trim_left().length(); });
+		run("trim", "trim_right() const", size, [&] { return text.trim_right().length(); });
+		run("trim", "trim(const char*) const", size, [&] { return text.trim(" ,").length(); });
+		run("trim", "string_view::trim()", size, [&] { return super::string_view(text).trim().length(); });
+		run("trim", "substring(size_t, size_t)", size, [&] { return text.substring(size / 4, size / 2).length(); });
+		run("trim", "left(size_t)", size, [&] { return text.left(size / 2).length(); });
+		run("trim", "right(size_t)", size, [&] { return text.right(size / 2).length(); });
+		run("trim", "clone()", size, [&] { return text.clone().length(); });
+	}
+
+	// Case and character transformation.
+	void bench_case(runner& run, size_t size)
+	{
+		const super::string text(make_text(size).c_str());
+		super::string work(text);
+
+		run("case", "to_upper() const", size, [&] { return text.to_upper().length(); });
+		run("case", "to_lower() const", size, [&] { return text.to_lower().length(); });
+		run("case", "to_upper() in place", size, [&] { return work.to_upper().length(); });
+		run("case", "reverse() const", size, [&] { return text.reverse().length(); });
+		run("case", "trim().to_lower().replace_all() chain", size, [&] { return text.trim().to_upper().to_lower().replace_all("a", "b").length(); });
+	}
+
+	// Comparison, searching and replacement.
+	void bench_compare(runner& run, size_t size)
+	{
+		const std::string raw(make_text(size));
+		const super::string text(raw.c_str());
+		std::string other(raw);
+		other[other.length() - 3] = '#';
+		const super::string near(other.c_str());
+
+		run("compare", "compare_to(const char*)", size, [&] { return size_t(text.compare_to(near.c_str()) + 2); });
+		run("compare", "reverse_compare_to(const char*)", size, [&] { return size_t(text.reverse_compare_to(near.c_str()) + 2); });
+		run("compare", "starts_with(const char*)", size, [&] { return size_t(text.starts_with(near.c_str())); });
+		run("compare", "starts_with(const char*, true)", size, [&] { return size_t(text.starts_with(near.c_str(), true)); });
+		run("compare", "ends_with(const char*)", size, [&] { return size_t(text.ends_with("zz")); });
+		run("compare", "index_of(char)", size, [&] { return size_t(text.index_of('#') + 2); });
+		run("compare", "last_index_of(char)", size, [&] { return size_t(text.last_index_of('#') + 2); });
+		run("compare", "index_of(const string_view&)", size, [&] { return size_t(text.index_of("zq#x") + 2); });
+		run("compare", "last_index_of(const string_view&)", size, [&] { return size_t(text.last_index_of("zq#x") + 2); });
+		run("compare", "std::string::find(const char*)", size, [&] { return raw.find("zq#x") + 2; });
+		run("compare", "std::string::rfind(const char*)", size, [&] { return raw.rfind("zq#x") + 2; });
+		run("compare", "consists_of(const char*)", size, [&] { return size_t(text.consists_of("abcdefghijklmnopqrstuvwxyz ,")); });
+		run("compare", "replace(const char*, const char*) const", size, [&] { return text.replace("a", "xy").length(); });
+		run("compare", "replace_all(const char*, const char*) const", size, [&] { return text.replace_all("a", "xy").length(); });
+	}
+
+	// Edit distance, which is quadratic, so only at smaller sizes.
+	void bench_distance(runner& run, size_t size)
+	{
+		if (size > 1024)
+			return;
+
+		const std::string raw(make_text(size));
+		const super::string text(raw.c_str());
+		std::string other(raw);
+		std::reverse(other.begin(), other.end());
+
+		run("distance", "distance(const std::string&)", size, [&] { return size_t(text.distance(other)); });
+	}
+
+	// Hashing.
+	void bench_hash(runner& run, size_t size)
+	{
+		const super::string text(make_text(size).c_str());
+
+		run("hash", "hash_code(low)", size, [&] { return size_t(text.hash_code()); });
+		run("hash", "hash_code(both)", size, [&] { return size_t(text.hash_code(super::hash_code_part::both)); });
+		run("hash", "string_view::hash_code()", size, [&] { return size_t(super::string_view(text).hash_code()); });
+	}
+
+	// Regular expression matching and parsing.
+	void bench_match(runner& run, size_t size)
+	{
+		const super::string text(make_text(size).c_str());
+		super::string_table table;
+		std::vector<super::string_view> matches;
+
+		run("match", "match(const char*)", size, [&] { return size_t(text.match("[a-z]+,")); });
+		run("match", "match(const char*, true)", size, [&] { return size_t(text.match("[A-Z]+,", true)); });
+		run("match", "match(const char*) literal absent", size, [&] { return size_t(text.match("user_id=[0-9]+")); });
+		run("match", "match_all(const char*)", size, [&] { return text.match_all("[a-z]+,").size(); });
+		run("match", "match_all(const char*, string_table&)", size, [&] { table.clear(); return text.match_all("[a-z]+,", table); });
+		run("match", "match_all(const char*, vector<string_view>&)", size, [&] { matches.clear(); return text.match_all("[a-z]+,", matches); });
+		run("match", "match_each(const char*) first only", size, [&] { for (const auto& m : text.match_each("[a-z]+,")) return m.view().size(); return size_t(0); });
+
+		super::pattern words("[a-z]+,");
+		std::vector<super::string_view> views;
+
+		run("match", "pattern::matches(string_view)", size, [&] { return size_t(words.matches(text)); });
+		run("match", "pattern::find_all(string_view, vector<string_view>&)", size, [&] { views.clear(); return words.find_all(text, views); });
+
+		if (size == 16)
+			run("match", "regex_cache::get(const char*) hit", 0, [&] { return size_t(super::regex_cache::get("[a-z]+,")->mark_count()) + 1; });
+	}
+
+	// Regular expression replacement, against std::regex_replace.
+	void bench_rewrite(runner& run, size_t size)
+	{
+		const std::string raw(make_text(size));
+		const super::string text(raw.c_str());
+		const std::regex regex("([a-z]+),");
+		super::pattern words("([a-z]+),");
+
+		run("rewrite", "std::regex_replace", size, [&] { return std::regex_replace(raw, regex, "<$1>;").length(); });
+		run("rewrite", "replace_all(pattern, const char*)", size, [&] { super::string copy(text); return copy.replace_all(words, "<$1>;"); });
+		run("rewrite", "replace_all(pattern, callback)", size, [&] { super::string copy(text); return copy.replace_all(words, [](const super::match_range::match& m) { return m.group(1); }); });
+	}
+
+	// The DFA engine against std::regex, searching text for each expression of a small corpus of
+	// the shapes match is used with, and on a pathological expression which backtracks badly.
+	void bench_regex(runner& run, size_t size)
+	{
+		static const char* const corpus[] = { "[a-z]+,", "(ab|cd|ef)[a-z]*q", "^ +[a-z]+ ", "[a-z]{9}", "[0-9]+", "z[a-z]*,$" };
+
+		const std::string text = make_text(size);
+		const char* first = text.data();
+		const char* last = first + text.length();
+
+		for (const char* expression : corpus)
+		{
+			const std::regex regex(expression, std::regex_constants::extended);
+			const super::regex_dfa dfa(expression, std::regex_constants::extended);
+			const std::string name = std::string(" /") + expression + "/";
+
+			run("regex", ("std::regex_search" + name).c_str(), size, [&] { return size_t(std::regex_search(first, last, regex)); });
+			run("regex", ("regex_dfa::search" + name).c_str(), size, [&] { return size_t(dfa.search(first, first, last)); });
+		}
+
+		const std::string repeated(size, 'a');
+		const super::regex_dfa pathological("(a|aa)*b", std::regex_constants::extended);
+
+		if (size <= 16) // Exponential in size.
+		{
+			const std::regex regex("(a|aa)*b", std::regex_constants::extended);
+			run("regex", "std::regex_search /(a|aa)*b/ on a...", size, [&] { return size_t(std::regex_search(repeated, regex)); });
+		}
+
+		run("regex", "regex_dfa::search /(a|aa)*b/ on a...", size, [&] { return size_t(pathological.search(repeated.data(), repeated.data(), repeated.data() + size)); });
+	}
+
+	// Scanning for 2,000 keywords at once, against a find per keyword.
+	void bench_keywords(runner& run, size_t size)
+	{
+		const super::string text(make_text(size).c_str());
+		std::vector<std::string> keywords;
+		uint32_t state = 0x9E3779B9U;
+
+		for (size_t i = 0; i < 2000; ++i)
+		{
+			std::string keyword;
+
+			for (size_t length = 4 + i % 6; keyword.length() < length; )
+			{
+				state = state * 1664525U + 1013904223U;
+				keyword.push_back(char('a' + (state >> 24) % 26));
+			}
+
+			keywords.push_back(keyword);
+		}
+
+		const super::keyword_set set(keywords);
+		const super::keyword_set caseless(keywords, true);
+		std::vector<super::keyword_set::match> matches;
+		std::vector<uint64_t> mask;
+
+		run("keywords", "std::string::find per keyword", size, [&]
+		{
+			size_t found = 0;
+			for (const std::string& keyword : keywords)
+				found += text.find(keyword) != std::string::npos ? 1 : 0;
+			return found;
+		});
+
+		run("keywords", "keyword_set::find_mask", size, [&] { return set.find_mask(text, mask); });
+		run("keywords", "keyword_set::find_mask caseless", size, [&] { return caseless.find_mask(text, mask); });
+		run("keywords", "keyword_set::find_all", size, [&] { matches.clear(); return set.find_all(text, matches); });
+		run("keywords", "keyword_set::find_first", size, [&] { super::keyword_set::match first; return size_t(set.find_first(text, first)); });
+
+		if (size == 16)
+			run("keywords", "keyword_set(2000 keywords)", 0, [&] { return super::keyword_set(keywords).states(); });
+	}
+
+	// A searcher built once, against std::string::find, for needles of each algorithm: short
+	// ones for the packed-pair filter, a long one for Horspool, and a long one over a small
+	// alphabet for Two-Way, searched in a haystack of the same alphabet.
+	void bench_searcher(runner& run, size_t size)
+	{
+		const std::string raw(make_text(size));
+		std::string dna(size, 'a');
+
+		for (size_t i = 0; i < size; ++i)
+			dna[i] = "acgt"[(i * 2654435761U >> 13) % 4];
+
+		const std::string needles[] = { "zq#x", "the quick brown fox, jumps", std::string(48, 'q') + "rstuvwxyz#", "acgtacgtaaccggttacgtacgtaaccggttacgtacgtaaccggtta#" };
+
+		for (const std::string& needle : needles)
+		{
+			const std::string& haystack = needle[0] == 'a' ? dna : raw;
+			const super::searcher finder(needle);
+			const std::string name = " /" + std::to_string(needle.length()) + "/";
+			static const char* const names[] = { "empty", "byte", "pair", "horspool", "two_way" };
+
+			run("searcher", ("std::string::find" + name).c_str(), size, [&] { return haystack.find(needle) + 2; });
+			run("searcher", ("searcher::find " + std::string(names[int(finder.chosen())]) + name).c_str(), size, [&] { return finder.find(super::string_view(haystack)) + 2; });
+		}
+	}
+
+	// Literal replace_all on a 1 MB input at several densities of hits, against the previous
+	// loop of std::string::replace, which shifts the tail once per hit.
+	void bench_replace(runner& run)
+	{
+		const size_t size = size_t(1) << 20;
+		const size_t spacings[] = { 16, 256, 4096 };
+
+		for (size_t spacing : spacings)
+		{
+			std::string raw(make_text(size));
+
+			for (size_t i = 0; i + 4 <= size; i += spacing)
+				raw.replace(i, 4, "<b/>");
+
+			const super::string text(raw.c_str());
+			const std::string density = " every " + std::to_string(spacing);
+
+			run("replace", ("std::string::replace loop" + density).c_str(), size, [&]
+			{
+				std::string copy(raw);
+				for (size_t p = 0; (p = copy.find("<b/>", p)) != std::string::npos; p += 9)
+					copy.replace(p, 4, "<br/><br>");
+				return copy.length();
+			});
+			run("replace", ("replace_all(const char*, const char*) const" + density).c_str(), size, [&] { return text.replace_all("<b/>", "<br/><br>").length(); });
+			run("replace", ("replace_all(const char*, const char*) same length" + density).c_str(), size, [&] { super::string copy(text); return copy.replace_all("<b/>", "<i/>").length(); });
+		}
+	}
+
+	// Sanitizing with a dictionary of 32 literal replacements, one replace_all per key against a
+	// replacer applying all of them in one pass.
+	void bench_dictionary(runner& run, size_t size)
+	{
+		const super::string text(make_text(size).c_str());
+		std::vector<std::pair<std::string, std::string>> pairs;
+
+		for (char c = 'a'; c < 'a' + 26; ++c)
+			pairs.emplace_back(std::string(1, c) + "q", std::string("<") + c + ">");
+
+		pairs.emplace_back(",", "&#44;");
+		pairs.emplace_back("  ", " ");
+		pairs.emplace_back("the", "THE");
+		pairs.emplace_back("ing", "ING");
+		pairs.emplace_back("zz", "Z");
+		pairs.emplace_back("xy", "YX");
+
+		const super::replacer replacements(pairs);
+
+		run("dictionary", "replace_all(const char*, const char*) per key", size, [&]
+		{
+			super::string copy(text);
+			for (const auto& pair : pairs)
+				copy.replace_all(pair.first.c_str(), pair.second.c_str());
+			return copy.length();
+		});
+		run("dictionary", "replace_all(const replacer&)", size, [&] { super::string copy(text); return copy.replace_all(replacements); });
+	}
+
+	// Filtering keys by wildcard pattern, against the same pattern written as a regex for match.
+	void bench_glob(runner& run)
+	{
+		static const char* const parts[] = { "user", "order", "session", "cache", "audit" };
+		static const char* const suffixes[] = { ".log", ".tmp", ".json", ".log.1" };
+
+		std::vector<std::string> keys;
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 10000; ++i)
+		{
+			state = state * 1664525U + 1013904223U;
+			keys.push_back(std::string(parts[(state >> 24) % 5]) + "-" + std::to_string((state >> 8) % 100) + "-" + std::to_string(i) + suffixes[(state >> 16) % 4]);
+		}
+
+		const super::glob logs("*.log");
+		const super::glob users("user-?\?-*");
+		const super::glob caseless("USER-?\?-*.LOG", true);
+		std::vector<size_t> found;
+		size_t bytes = 0;
+
+		for (const std::string& key : keys)
+			bytes += key.length();
+
+		run("glob", "glob::filter *.log", bytes, [&] { found.clear(); return logs.filter(keys, found); });
+		run("glob", "glob::filter user-?\?-*", bytes, [&] { found.clear(); return users.filter(keys, found); });
+		run("glob", "glob::filter USER-?\?-*.LOG caseless", bytes, [&] { found.clear(); return caseless.filter(keys, found); });
+		run("glob", "match ^user-..-.*$ per key", bytes, [&] { size_t n = 0; for (const std::string& key : keys) n += super::string_view(key).match("^user-..-.*$"); return n; });
+	}
+
+	// match_all over a large input, sequentially and in parallel chunks.
+	void bench_parallel(runner& run)
+	{
+		const size_t size = size_t(16) << 20;
+		const super::string text(make_text(size).c_str());
+		std::vector<super::string_view> matches;
+		super::chunking chunks;
+
+		chunks.overlap = 64;
+
+		run("parallel", "match_all(const char*, vector<string_view>&)", size, [&] { matches.clear(); return text.match_all("[a-z]+,", matches); });
+		run("parallel", "match_all(const char*, vector<string_view>&, chunking)", size, [&] { matches.clear(); return text.match_all("[a-z]+,", matches, chunks); });
+	}
+
+	// Parsing captured groups into typed values, on a short fixed record.
+	void bench_parse(runner& run)
+	{
+		const super::string record("id=12345 name=superstring ratio=0.75");
+		const size_t length = record.length();
+
+		run("match", "parse(const char*, int&, string&, double&)", length, [&]
+		{
+			int id = 0;
+			super::string name;
+			double ratio = 0.0;
+			return record.parse("id=([0-9]+) name=([a-z]+) ratio=([0-9.]+)", id, name, ratio) + size_t(id);
+		});
+
+		run("match", "parse(true, const char*, int&, double&)", length, [&]
+		{
+			int id = 0;
+			double ratio = 0.0;
+			return record.parse(true, "id=([0-9]+) name=[a-z]+ ratio=([0-9.]+)", id, ratio) + size_t(id);
+		});
+
+		run("match", "parse_format(const char*, int&, string&, double&)", length, [&]
+		{
+			int id = 0;
+			super::string name;
+			double ratio = 0.0;
+			return record.parse_format("id={} name={} ratio={}", id, name, ratio) + size_t(id);
+		});
+
+		run("match", "parse_format(true, const char*, int&, double&)", length, [&]
+		{
+			int id = 0;
+			double ratio = 0.0;
+			std::string name;
+			return record.parse_format(true, "id={} name={} ratio={}", id, name, ratio) + size_t(id);
+		});
+
+		super::pattern fields("id=([0-9]+) name=([a-z]+) ratio=([0-9.]+)");
+
+		run("match", "pattern::parse(string_view, int&, string&, double&)", length, [&]
+		{
+			int id = 0;
+			super::string name;
+			double ratio = 0.0;
+			return fields.parse(record, id, name, ratio) + size_t(id);
+		});
+
+#ifdef SUPERSTRING_STATIC_REGEX
+		run("match", "parse<\"...\">(int&, string&, double&)", length, [&]
+		{
+			int id = 0;
+			super::string name;
+			double ratio = 0.0;
+			return record.parse<"id=([0-9]+) name=([a-z]+) ratio=([0-9.]+)">(id, name, ratio) + size_t(id);
+		});
+
+		run("match", "parse<\"...\", true>(int&, double&)", length, [&]
+		{
+			int id = 0;
+			double ratio = 0.0;
+			return record.parse<"id=([0-9]+) name=[a-z]+ ratio=([0-9.]+)", true>(id, ratio) + size_t(id);
+		});
+#endif
+	}
+
+	// Escaping and unescaping.
+	void bench_escape(runner& run, size_t size)
+	{
+		const super::string text(make_text(size).c_str());
+		const super::string url(text.escape(super::string::escaping::url));
+		const super::string entities(text.escape(super::string::escaping::entities));
+
+		run("escape", "escape(json) const", size, [&] { return text.escape(super::string::escaping::json).length(); });
+		run("escape", "escape(url) const", size, [&] { return text.escape(super::string::escaping::url).length(); });
+		run("escape", "escape(rfc3986) const", size, [&] { return text.escape(super::string::escaping::rfc3986).length(); });
+		run("escape", "escape(entities) const", size, [&] { return text.escape(super::string::escaping::entities).length(); });
+		run("escape", "escape(regex) const", size, [&] { return text.escape(super::string::escaping::regex).length(); });
+		run("escape", "unescape(url) const", size, [&] { return url.unescape(super::string::escaping::url).length(); });
+		run("escape", "unescape(entities) const", size, [&] { return entities.unescape(super::string::escaping::entities).length(); });
+	}
+
+	// Validation, numeric conversion and numeric appends, on short fixed inputs.
+	void bench_numeric(runner& run)
+	{
+		const super::string integer("-1234567890");
+		const super::string hexadecimal("0x7FFFABCD");
+		const super::string real("-12345.678e-3");
+		const super::string boolean("true");
+
+		run("numeric", "is_decimal_integer()", integer.length(), [&] { return size_t(integer.is_decimal_integer()); });
+		run("numeric", "is_decimal_float()", real.length(), [&] { return size_t(real.is_decimal_float()); });
+		run("numeric", "is_hexadecimal_integer()", hexadecimal.length(), [&] { return size_t(hexadecimal.is_hexadecimal_integer()); });
+		run("numeric", "parse_integer(unsigned long long&, bool&)", integer.length(), [&] { unsigned long long v = 0; bool n = false; integer.parse_integer(v, n); return size_t(v); });
+		run("numeric", "parse_float(long double&)", real.length(), [&] { long double v = 0; real.parse_float(v); return size_t(v < 0); });
+		run("numeric", "to_int()", integer.length(), [&] { return size_t(integer.to_int()); });
+		run("numeric", "to_ullong() hexadecimal", hexadecimal.length(), [&] { return size_t(hexadecimal.to_ullong()); });
+		run("numeric", "to_double()", real.length(), [&] { return size_t(real.to_double() < 0); });
+		run("numeric", "to_bool()", boolean.length(), [&] { return size_t(boolean.to_bool()); });
+
+		super::string out;
+
+		run("numeric", "append(int)", 0, [&] { out.clear(); return out.append(-1234567).length(); });
+		run("numeric", "append(unsigned long long)", 0, [&] { out.clear(); return out.append(18446744073709551615ULL).length(); });
+		run("numeric", "append(double)", 0, [&] { out.clear(); return out.append(3.14159265358979).length(); });
+		run("numeric", "append(const char*, ...)", 0, [&] { out.clear(); return size_t(out.append("%d:%s", 42, "answer")) + out.length(); });
+		run("numeric", "format(const char*, ...)", 0, [&] { return size_t(out.format("%s-%08X", "key", 0xBEEFU)) + out.length(); });
+	}
+
+	// Compact storage.
+	void bench_compact(runner& run, size_t size)
+	{
+		const super::string text(make_text(size).c_str());
+		super::compact_string compact;
+
+		run("compact", "compact_string::assign(const string_view&)", size, [&] { compact.assign(text); return compact.length(); });
+		run("compact", "compact_string::view()", size, [&] { return compact.view().length(); });
+		run("compact", "compact_string::to_string()", size, [&] { return compact.to_string().length(); });
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	options opts;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+			opts.filter = argv[++i];
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			opts.json = argv[++i];
+		else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+			opts.min_time = std::atof(argv[++i]);
+		else
+		{
+			std::fprintf(stderr, "Usage: %s [--filter text] [--min-time seconds] [--json path|-]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (opts.json != nullptr && std::strcmp(opts.json, "-") == 0)
+		opts.log = stderr; // Keep stdout for the document.
+
+	runner run(opts);
+
+	const size_t sizes[] = { 16, 256, 4096 };
+
+	for (size_t size : sizes)
+	{
+		bench_split(run, size);
+		bench_count(run, size);
+		bench_trim(run, size);
+		bench_case(run, size);
+		bench_compare(run, size);
+		bench_distance(run, size);
+		bench_hash(run, size);
+		bench_match(run, size);
+		bench_regex(run, size);
+		bench_rewrite(run, size);
+		bench_keywords(run, size);
+		bench_dictionary(run, size);
+		bench_searcher(run, size);
+		bench_escape(run, size);
+		bench_compact(run, size);
+	}
+
+	bench_parse(run);
+	bench_numeric(run);
+	bench_parallel(run);
+	bench_replace(run);
+	bench_glob(run);
+
+	if (opts.json != nullptr && !write_json(opts.json, run.results()))
+	{
+		std::fprintf(stderr, "Cannot write %s\n", opts.json);
+		return 1;
+	}
+
+	return 0;
+}
@@ -39,6 +39,10 @@ SOFTWARE.
 #include <stdarg.h>
 #include <wchar.h>
 
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
 #include <string>
 #include <sstream>
 #include <iostream>
@@ -51,37 +55,57 @@ SOFTWARE.
 #include <regex>
 #include <mutex>
 #include <map>
+#include <list>
+#include <atomic>
+#include <unordered_map>
+#include <thread>
+#include <exception>
 
-#include "string.hh"
+#include "superstring.hh"
 
 
 namespace super
 {
-	string::string() : base_type(), _null(false) { }
+	template <typename Alloc>
+	basic_string<Alloc>::basic_string() : base_type(), _null(false) { }
 
-	string::string(size_t size, char initial) : _null(false), base_type(size, initial) { }
+	template <typename Alloc>
+	basic_string<Alloc>::basic_string(size_t size, char initial) : base_type(size, initial), _null(false) { }
 
-	string::string(const std::string& value) : base_type(value), _null(false) { }
+	template <typename Alloc>
+	basic_string<Alloc>::basic_string(const std::string& value) : base_type(value), _null(false) { }
 
-	string::string(const string& value) : base_type(), _null(value._null)
+	template <typename Alloc>
+	basic_string<Alloc>::basic_string(const basic_string<Alloc>& value) : base_type(value.get_allocator()), _null(value._null)
 	{
 		if (!_null) 
 			base_type::operator=(value);
 	}
 
-	string::string(string&& value) : base_type(), _null(value._null)
+	template <typename Alloc>
+	basic_string<Alloc>::basic_string(basic_string<Alloc>&& value) noexcept : base_type(std::move(value)), _null(value._null)
 	{
-		if (!_null)
-			base_type::operator=(value);
+		value._null = false;
 	}
 
-	string::string(const char* value) : base_type(), _null(value == nullptr)
+	template <typename Alloc>
+	basic_string<Alloc>::basic_string(const char* value) : base_type(), _null(value == nullptr)
 	{
 		if (!_null)
 			base_type::operator=(value);
 	}
 
-	string& string::assign(const string& value)
+	template <typename Alloc>
+	basic_string<Alloc>::basic_string(const string_view& value) : base_type(value.data(), value.length()), _null(value.is_null()) { }
+
+	template <typename Alloc>
+	basic_string<Alloc>::basic_string(const Alloc& allocator) : base_type(allocator), _null(false) { }
+
+	template <typename Alloc>
+	basic_string<Alloc>::basic_string(const string_view& value, const Alloc& allocator) : base_type(value.data(), value.length(), allocator), _null(value.is_null()) { }
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::assign(const basic_string<Alloc>& value)
 	{
 		if (value._null)
 		{
@@ -97,7 +121,8 @@ namespace super
 		return *this;
 	}
 
-	string& string::assign(const std::string& value)
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::assign(const std::string& value)
 	{
 		_null = false;
 		base_type::operator=(value);
@@ -105,7 +130,8 @@ namespace super
 		return *this;
 	}
 
-	string& string::assign(const char* value)
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::assign(const char* value)
 	{
 		if (value == nullptr)
 		{
@@ -121,7 +147,8 @@ namespace super
 		return *this;
 	}
 
-	string& string::operator=(const char* value)
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::operator=(const char* value)
 	{
 		_null = (value == nullptr);
 
@@ -132,7 +159,8 @@ namespace super
 		return *this;
 	}
 
-	string& string::operator=(const string& value)
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::operator=(const basic_string<Alloc>& value)
 	{
 		_null = value._null;
 
@@ -143,7 +171,8 @@ namespace super
 		return *this;
 	}
 
-	string& string::operator=(const std::string& value)
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::operator=(const std::string& value)
 	{
 		_null = false;
 
@@ -152,176 +181,86 @@ namespace super
 		return *this;
 	}
 
-	string& string::operator=(string&& value)
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::operator=(basic_string<Alloc>&& value)
 	{
+		if (this == &value)
+			return *this;
+
 		_null = value._null;
 
-		if (!_null) 
-			base_type::operator=(value);
-		else base_type::clear();
+		base_type::operator=(std::move(value));
 
 		value.clear();
 
 		return *this;
 	}
 
-	string& string::operator=(std::string&& value)
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::operator=(std::string&& value)
 	{
 		_null = false;
 
-		base_type::operator=(value);
+		base_type::operator=(std::move(value));
 
 		value.clear();
 
 		return *this;
 	}
 
-	string::operator const char*() const
+	template <typename Alloc>
+	basic_string<Alloc>::operator const char*() const
 	{
 		if (_null) 
 			return nullptr;
 		else return base_type::c_str();
 	}
 
-	string::operator const std::string() const { return *this; }
+	template <typename Alloc>
+	basic_string<Alloc>::operator const std::string() const { return std::string(base_type::data(), base_type::length()); }
 
 	// Compares this instance with value, from left to right, returning the relative difference.
 	// Returns 1 if this is greater than value, -1 if value is greater than this, else 0 if they are equal.
-	int string::compare_to(const std::string& value) const
+	template <typename Alloc>
+	int basic_string<Alloc>::compare_to(const std::string& value) const
 	{
 		return compare_to(value.c_str());
 	}
 
 	// Compares this instance with value, from left to right, returning the relative difference.
 	// Returns 1 if this is greater than value, -1 if value is greater than this, else 0 if they are equal.
-	int string::compare_to(const char* value) const
+	template <typename Alloc>
+	int basic_string<Alloc>::compare_to(const char* value) const
 	{
-		if (value == nullptr)
-		{
-			if (_null) 
-				return 0;
-			else return 1;
-		}
-
-		if (_null) 
-			return -1;
-
-		const char* p = base_type::c_str();
-		const char* q = value;
-
-		for (; *p && *q; ++p, ++q)
-		{
-			int d = *p - *q;
-
-			if (d != 0)
-				return d;
-		}
-
-		if (*p && !*q) 
-			return 1;
-		else if (!*p && *q) 
-			return -1;
-		else return 0;
+		return string_view(*this).compare_to(value);
 	}
 
 	// Compares this instance with value, from right to left, returning the relative difference.
 	// Returns 1 if this is greater than value, -1 if value is greater than this, else 0 if they are equal.
-	int string::reverse_compare_to(const std::string& value) const
+	template <typename Alloc>
+	int basic_string<Alloc>::reverse_compare_to(const std::string& value) const
 	{
 		return reverse_compare_to(value.c_str());
 	}
 
 	// Compares this instance with value, from right to left, returning the relative difference.
 	// Returns 1 if this is greater than value, -1 if value is greater than this, else 0 if they are equal.
-	int string::reverse_compare_to(const char* value) const
+	template <typename Alloc>
+	int basic_string<Alloc>::reverse_compare_to(const char* value) const
 	{
-		if (value == nullptr)
-		{
-			if (_null) 
-				return 0;
-			else return 1;
-		}
-
-		if (_null)
-			return -1;
-
-		size_t m = _null ? 0 : base_type::length();
-		size_t n = std::strlen(value);
-
-		const char *p_end = c_str(), *p = p_end + (m - 1);
-		const char* q_end = value, *q = q_end + (n - 1);
-
-		for (; p >= p_end && q >= q_end; --p, --q)
-		{
-			int d = *p - *q;
-
-			if (d != 0)
-				return d;
-		}
-
-		if (p > p_end && q <= q_end) 
-			return 1;
-		else if (p <= p_end && q > q_end) 
-			return -1;
-		else return 0;
+		return string_view(*this).reverse_compare_to(value);
 	}
 
 	// Computes the Levenshtein distance between this and value.
-	unsigned long long string::distance(const std::string& value) const
+	template <typename Alloc>
+	unsigned long long basic_string<Alloc>::distance(const std::string& value) const
 	{
-		size_t m = value.length();
-		size_t n = length();
-
-		if (_null || n == 0) return m;
-		else if (m == 0) return n;
-
-		m++, n++;
-
-		std::vector<std::vector<unsigned long long>> delta(n);
-		
-		for (size_t i = 0; i < n; ++i)
-		{
-			delta[i].resize(m);
-			delta[i][0] = i;
-		}
-
-		for (size_t i = 0; i < m; ++i)
-			delta[0][i] = i;
-
-		const char* const pp = base_type::c_str();
-		const char* const qq = value.c_str();
-
-		for (size_t i = 1; i < n; ++i)
-		{
-			const char p = pp[i - 1];
-
-			for (size_t j = 1; j < m; ++j)
-			{
-				const char q = qq[j - 1];
-
-				unsigned long long cost = std::min(delta[i - 1][j] + 1, 
-					std::min(delta[i][j - 1] + 1, delta[i - 1][j - 1] + ((p == q) ? 0 : 1)));
-
-				if (i > 2 && j > 2)
-				{
-					unsigned long long t = delta[i - 2][j - 2] + 1;
-
-					if (pp[i - 2] != q) t++;
-					if (p != qq[j - 2]) t++;
-
-					if (cost > t) 
-						cost = t;
-				}
-
-				delta[i][j] = cost;
-			}
-		}
-		
-		return delta[n - 1][m - 1];
+		return string_view(*this).distance(value);
 	}
 
 	// Nullifies this instance.
-	string& string::nullify()
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::nullify()
 	{
 		_null = true;
 		base_type::clear();
@@ -330,7 +269,8 @@ namespace super
 	}
 
 	// Clears this instance.
-	string& string::clear()
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::clear()
 	{
 		_null = false;
 		base_type::clear();
@@ -339,35 +279,38 @@ namespace super
 	}
 
 	// Clones this instance.
-	string string::clone() const
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::clone() const
 	{
-		if (_null) 
-			return string(nullptr);
-		else return string(*this);
+		return basic_string(string_view(*this), base_type::get_allocator());
 	}
 
 	// True if this has a length of one.
-	bool string::is_char() const
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_char() const
 	{
-		return (!_null || base_type::length() == 1);
+		return !_null && base_type::length() == 1;
 	}
 
 	// Gets the first character, or '\0'.
-	char string::head() const
+	template <typename Alloc>
+	char basic_string<Alloc>::head() const
 	{
 		if (is_empty()) return '\0';
 		return base_type::operator[](0);
 	}
 
 	// Gets the last character, or '\0'.
-	char string::tail() const
+	template <typename Alloc>
+	char basic_string<Alloc>::tail() const
 	{
 		if (is_empty()) return '\0';
 		return base_type::operator[](base_type::length() - 1);
 	}
 
 	// Returns true if value is one of the characters in chars, excluding the null terminator.
-	bool string::is_one_of(char value, const char* chars)
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_one_of(char value, const char* chars)
 	{
 		if (chars == nullptr || !*chars) return false;
 
@@ -379,7 +322,8 @@ namespace super
 	}
 
 	// Gets the length of this instance in characters, or zero if null.
-	size_t string::length() const
+	template <typename Alloc>
+	size_t basic_string<Alloc>::length() const
 	{
 		if (_null) 
 			return 0;
@@ -387,24 +331,28 @@ namespace super
 	}
 
 	// True if the string is marked as null.
-	bool string::is_null() const 
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_null() const 
 	{ 
 		return _null || base_type::c_str() == nullptr; 
 	}
 
 	// True if the string is null or zero-length.
-	bool string::is_empty() const 
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_empty() const 
 	{ 
 		return _null || base_type::length() == 0; 
 	}
 
 	// True if the string is not null and not zero-length.
-	bool string::non_empty() const 
+	template <typename Alloc>
+	bool basic_string<Alloc>::non_empty() const 
 	{ 
 		return !_null && base_type::length() > 0; 
 	}
 
-	string string::substring(size_t start, size_t count /*= std::string::npos*/) const
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::substring(size_t start, size_t count /*= std::string::npos*/) const
 	{
 		if (is_empty())
 			return clone();
@@ -412,17 +360,17 @@ namespace super
 		size_t n = base_type::length();
 
 		if (start >= n)
-			return string(nullptr);
+			return basic_string(nullptr);
 
-		if (count != base_type::npos)
-			if ((start + count) > n)
-				count = base_type::npos;
+		if (count > n - start)
+			count = n - start;
 
-		return string(base_type::substr(start, count));
+		return basic_string(string_view(base_type::data() + start, count), base_type::get_allocator());
 	}
 
 	// Trims leading whitespace, in place.
-	string& string::trim_left()
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::trim_left() &
 	{
 		if (is_empty())
 			return *this;
@@ -439,15 +387,24 @@ namespace super
 	}
 
 	// Copies this and trims leading whitespace.
-	string string::trim_left() const 
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::trim_left() const &
 	{
 		if (is_empty())
 			return clone();
 		else return clone().trim_left();
 	}
 
+	// Trims leading whitespace from this temporary, in place, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::trim_left() &&
+	{
+		return std::move(trim_left());
+	}
+
 	// Trims leading occurences of the specified characters, in place.
-	string& string::trim_left(const char* chars)
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::trim_left(const char* chars) &
 	{
 		if (is_empty() || chars == nullptr)
 			return *this;
@@ -464,7 +421,8 @@ namespace super
 	}
 
 	// Copies this and trims leading whitespace.
-	string string::trim_left(const char* chars) const 
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::trim_left(const char* chars) const &
 	{
 		if (is_empty())
 			return clone();
@@ -472,8 +430,16 @@ namespace super
 		return clone().trim_left(chars);
 	}
 
+	// Trims leading occurences of the specified characters from this temporary, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::trim_left(const char* chars) &&
+	{
+		return std::move(trim_left(chars));
+	}
+
 	// Trims following whitespace, in place.
-	string& string::trim_right()
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::trim_right() &
 	{
 		if (is_empty())
 			return *this;
@@ -490,7 +456,8 @@ namespace super
 	}
 
 	// Copies this and trims following whitespace.
-	string string::trim_right() const 
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::trim_right() const &
 	{
 		if (is_empty())
 			return clone();
@@ -498,8 +465,16 @@ namespace super
 		return clone().trim_right();
 	}
 
+	// Trims following whitespace from this temporary, in place, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::trim_right() &&
+	{
+		return std::move(trim_right());
+	}
+
 	// Trims following occurences of the specified characters, in place.
-	string& string::trim_right(const char* chars)
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::trim_right(const char* chars) &
 	{
 		if (is_empty() || chars == nullptr)
 			return *this;
@@ -516,15 +491,24 @@ namespace super
 	}
 
 	// Copies this and trims following occurences of the specified characters.
-	string string::trim_right(const char* chars) const 
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::trim_right(const char* chars) const &
 	{
 		if (is_empty()) 
 			return clone();
 		else return clone().trim_right(chars);
 	}
 
+	// Trims following occurences of the specified characters from this temporary, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::trim_right(const char* chars) &&
+	{
+		return std::move(trim_right(chars));
+	}
+
 	// Trims all leading and following whitespace, in place.
-	string& string::trim() 
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::trim() &
 	{
 		if (is_empty())
 			return *this;
@@ -532,15 +516,24 @@ namespace super
 	}
 
 	// Copies this and trims all leading and following whitespace.
-	string string::trim() const 
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::trim() const &
 	{
 		if (is_empty()) 
 			return clone();
 		else return clone().trim();
 	}
 
+	// Trims all leading and following whitespace from this temporary, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::trim() &&
+	{
+		return std::move(trim());
+	}
+
 	// Trims all leading and following occurences of the specified characters, in place.
-	string& string::trim(const char* chars)
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::trim(const char* chars) &
 	{
 		if (is_empty() || chars == nullptr) 
 			return *this;
@@ -548,15 +541,24 @@ namespace super
 	}
 
 	// Copies this and trims all leading and following occurences of the specified characters.
-	string string::trim(const char* chars) const
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::trim(const char* chars) const &
 	{
 		if (is_empty())
 			return clone();
 		else return clone().trim(chars);
 	}
 
+	// Trims all leading and following occurences of the specified characters from this temporary, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::trim(const char* chars) &&
+	{
+		return std::move(trim(chars));
+	}
+
 	// Transforms this to upper-case, in place.
-	string& string::to_upper()
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::to_upper() &
 	{
 		if (is_empty()) 
 			return *this;
@@ -568,15 +570,24 @@ namespace super
 	}
 
 	// Copies this and transforms it to upper-case.
-	string string::to_upper() const
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::to_upper() const &
 	{
 		if (is_empty())
 			return clone();
 		else return clone().to_upper();
 	}
 
+	// Transforms this temporary to upper-case, in place, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::to_upper() &&
+	{
+		return std::move(to_upper());
+	}
+
 	// Transforms this to lower-case, in place.
-	string& string::to_lower()
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::to_lower() &
 	{
 		if (is_empty())
 			return *this;
@@ -588,15 +599,24 @@ namespace super
 	}
 
 	// Copies this and transforms it to lower-case.
-	string string::to_lower() const
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::to_lower() const &
 	{
 		if (is_empty())
 			return clone();
 		else return clone().to_lower();
 	}
 
+	// Transforms this temporary to lower-case, in place, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::to_lower() &&
+	{
+		return std::move(to_lower());
+	}
+
 	// Transforms this using the specified method, in place.
-	string& string::transform(char (*method)(char))
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::transform(char (*method)(char)) &
 	{
 		if (is_empty() || method == nullptr) 
 			return *this;
@@ -607,15 +627,24 @@ namespace super
 	}
 
 	// Copies this and transforms it using the specified method.
-	string string::transform(char (*method)(char)) const
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::transform(char (*method)(char)) const &
 	{
 		if (is_empty() || method == nullptr)
 			return clone();
 		else return clone().transform(method);
 	}
 
+	// Transforms this temporary using the specified method, in place, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::transform(char (*method)(char)) &&
+	{
+		return std::move(transform(method));
+	}
+
 	// Reverses this, in place.
-	string& string::reverse()
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::reverse() &
 	{
 		if (is_empty())
 			return *this;
@@ -626,131 +655,172 @@ namespace super
 	}
 
 	// Copies this and reverses it.
-	string string::reverse() const
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::reverse() const &
 	{
 		if (is_empty())
 			return clone();
 		else return clone().reverse(); 
 	}
 
-	// True if this is composed only of the given characters (excluding the terminating null).
-	bool string::consists_of(const char* chars) const
+	// Reverses this temporary, in place, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::reverse() &&
 	{
-		if (chars == nullptr || is_empty())
-			return false;
-
-		for (const char* p = base_type::c_str(); *p; ++p)
-			if (!is_one_of(*p, chars))
-				return false;
+		return std::move(reverse());
+	}
 
-		return true;
+	// True if this is composed only of the given characters (excluding the terminating null).
+	template <typename Alloc>
+	bool basic_string<Alloc>::consists_of(const char* chars) const
+	{
+		return string_view(*this).consists_of(chars);
 	}
 
 	// True if this starts with value. If insensitive is true, then compare caseless.
-	bool string::starts_with(const char* value, bool insensitive /*= false*/) const
+	template <typename Alloc>
+	bool basic_string<Alloc>::starts_with(const char* value, bool insensitive /*= false*/) const
 	{
-		if (_null && value == nullptr)
-			return true;
-		else if (value == nullptr)
-			return false;
-
-		string prefix(value);
-
-		if (base_type::length() < prefix.length())
-			return false;
-
-		string substring(base_type::substr(0, prefix.length()));
-
-		if (insensitive)
-		{
-			substring.to_lower();
-			prefix.to_lower();
-		}
-
-		return substring.compare_to(prefix.c_str()) == 0;
+		return string_view(*this).starts_with(value, insensitive);
 	}
 
 	// True if this ends with value. If insensitive is true, then compare caseless.
-	bool string::ends_with(const char* value, bool insensitive /*= false*/) const
+	template <typename Alloc>
+	bool basic_string<Alloc>::ends_with(const char* value, bool insensitive /*= false*/) const
 	{
-		if (_null && value == nullptr)
-			return true;
-		else if (value == nullptr) 
-			return false;
-
-		string suffix(value);
-
-		size_t m = base_type::length();
-		size_t n = suffix.length();
-
-		if (m < n)
-			return false;
-
-		string substring(base_type::substr(m - n, m));
-
-		if (insensitive)
-		{
-			substring.to_lower();
-			suffix.to_lower();
-		}
-
-		return substring.compare_to(suffix.c_str()) == 0;
+		return string_view(*this).ends_with(value, insensitive);
 	}
 
 	// Finds the first index of value, starting at the optional position.
 	// Returns the index, or -1 if not found.
-	int string::index_of(char value, size_t start /*= std::string::npos*/) const
+	template <typename Alloc>
+	int basic_string<Alloc>::index_of(char value, size_t start /*= std::string::npos*/) const
 	{
-		if (is_empty()) 
-			return -1;
+		return string_view(*this).index_of(value, start);
+	}
 
-		size_t n = base_type::length();
+	// Finds the first index of value, from right to left, starting at the optional offset from end.
+	// Returns the index, or -1 if not found.
+	template <typename Alloc>
+	int basic_string<Alloc>::last_index_of(char value, size_t start /*= std::string::npos*/) const
+	{
+		return string_view(*this).last_index_of(value, start);
+	}
 
-		if (n == 0 || start >= n) 
-			return -1;
+	// Finds the first index of the substring value, from left to right, starting at the optional
+	// offset. Returns the index, or -1 if not found.
+	template <typename Alloc>
+	int basic_string<Alloc>::index_of(const string_view& value, size_t start /*= std::string::npos*/) const
+	{
+		return string_view(*this).index_of(value, start);
+	}
+
+	// Finds the last index of the substring value, from right to left, starting at the optional
+	// offset from end. Returns the index, or -1 if not found.
+	template <typename Alloc>
+	int basic_string<Alloc>::last_index_of(const string_view& value, size_t start /*= std::string::npos*/) const
+	{
+		return string_view(*this).last_index_of(value, start);
+	}
 
-		const char* p = base_type::c_str();
+	// Finds the first offset of value at or after start. Returns the offset, or npos if not found.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::offset_of(char value, size_t start /*= 0*/) const
+	{
+		return string_view(*this).offset_of(value, start);
+	}
+
+	// Finds the first offset of value at or after start. Returns the offset, or npos if not found.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::offset_of(const string_view& value, size_t start /*= 0*/) const
+	{
+		return string_view(*this).offset_of(value, start);
+	}
 
-		if (start != base_type::npos)
-			p += start;
+	// Finds the last offset of value, skipping start characters from the end.
+	// Returns the offset, or npos if not found.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::last_offset_of(char value, size_t start /*= 0*/) const
+	{
+		return string_view(*this).last_offset_of(value, start);
+	}
 
-		for (int i = 0; *p; ++p, ++i)
-			if (*p == value) 
-				return i;
+	// Finds the last offset of value which ends at least start characters from the end.
+	// Returns the offset, or npos if not found.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::last_offset_of(const string_view& value, size_t start /*= 0*/) const
+	{
+		return string_view(*this).last_offset_of(value, start);
+	}
 
-		return -1;
+	// Finds the first offset of the needle of searcher at or after start.
+	// Returns the offset, or npos if not found.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::offset_of(const searcher& value, size_t start /*= 0*/) const
+	{
+		return value.find(*this, start);
 	}
 
-	// Finds the first index of value, from right to left, starting at the optional offset from end.
-	// Returns the index, or -1 if not found.
-	int string::last_index_of(char value, size_t start /*= std::string::npos*/) const
+	// True if this contains the substring value.
+	template <typename Alloc>
+	bool basic_string<Alloc>::contains(const string_view& value) const
 	{
-		if (is_empty())
-			return -1;
+		return string_view(*this).contains(value);
+	}
 
-		size_t n = base_type::length();
+	// True if this contains the needle of searcher.
+	template <typename Alloc>
+	bool basic_string<Alloc>::contains(const searcher& value) const
+	{
+		return value.find(*this) != base_type::npos;
+	}
 
-		if (start != base_type::npos && start >= n)
-			return -1;
+	// Counts the instances of the character value in this.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::count(char value) const
+	{
+		return string_view(*this).count(value);
+	}
 
-		const char* p = base_type::c_str();
-		const char* e = p + n;
+	// Counts the characters of this which are in set.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::count(const char* set) const
+	{
+		return string_view(*this).count(set);
+	}
 
-		e--;
+	// Counts the non-overlapping instances of the substring value in this.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::count(const string_view& value) const
+	{
+		return string_view(*this).count(value);
+	}
 
-		if (start != base_type::npos)
-			e -= start;
+	// Counts the non-overlapping instances of the needle of value in this.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::count(const searcher& value) const
+	{
+		return string_view(*this).count(value);
+	}
 
-		for (int i = n - 1; e > p; --e, --i)
-			if (*e == value)
-				return i;
+	// Appends the offsets of the non-overlapping instances of the substring value in this to offsets.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::find_all(const string_view& value, std::vector<size_t>& offsets) const
+	{
+		return string_view(*this).find_all(value, offsets);
+	}
 
-		return -1;
+	// Appends the offsets of the non-overlapping instances of the needle of value in this to offsets.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::find_all(const searcher& value, std::vector<size_t>& offsets) const
+	{
+		return string_view(*this).find_all(value, offsets);
 	}
 
 	// Replaces the first instance of value, in-place, with substitute. 
 	// Returns true if a replacement was made.
-	string& string::replace(const std::string& value, const std::string& substitute)
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::replace(const std::string& value, const std::string& substitute) &
 	{
 		if (is_empty())
 			return *this;
@@ -767,16 +837,25 @@ namespace super
 
 	// Copies and replaces the first instance of value with substitute. 
 	// Returns the modified copy.
-	string string::replace(const std::string& value, const std::string& substitute) const
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::replace(const std::string& value, const std::string& substitute) const &
 	{
 		if (is_empty())
 			return clone();
 		else return clone().replace(value, substitute);
 	}
 
+	// Replaces the first instance of value in this temporary with substitute, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::replace(const std::string& value, const std::string& substitute) &&
+	{
+		return std::move(replace(value, substitute));
+	}
+
 	// Replaces the first instance of value in this with substitute. 
 	// Returns true if a replacement was made.
-	string& string::replace(const char* value, const char* substitute)
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::replace(const char* value, const char* substitute) &
 	{
 		if (is_empty() || value == nullptr)
 			return *this;
@@ -788,1949 +867,4854 @@ namespace super
 
 	// Copies and replaces the first instance of value with substitute. 
 	// Returns the modified copy.
-	string string::replace(const char* value, const char* substitute) const
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::replace(const char* value, const char* substitute) const &
 	{
 		if (is_empty() || value == nullptr)
 			return clone();
 		else return clone().replace(value, substitute);
 	}
 
-	// Replaces all instances of value in this with replacement. 
-	// Returns the count of replacements made.
-	string& string::replace_all(const std::string& value, const std::string& replacement)
+	// Replaces the first instance of value in this temporary with substitute, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::replace(const char* value, const char* substitute) &&
 	{
-		if (is_empty())
-			return *this;
+		return std::move(replace(value, substitute));
+	}
 
-		size_t p = 0;
-		size_t m = replacement.length();
-		size_t n = value.length();
+	// Appends the offsets of the non-overlapping instances of the needle of value in source to
+	// offsets. Returns the count appended; an empty needle has no instances.
+	static size_t find_instances(const string_view& source, const searcher& value, std::vector<size_t>& offsets)
+	{
+		const size_t count = offsets.size();
+		const size_t n = value.length();
+		const char* first = source.begin();
+		const char* last = source.end();
 
-		while ((p = base_type::find(value, p)) != base_type::npos)
-		{
-			base_type::replace(p, n, replacement);
-			p += m;
-		}
+		if (n == 0)
+			return 0;
 
-		return *this;
-	}
+		while (size_t(last - first) >= n)
+		{
+			const char* p = value.find(first, last);
 
-	// Copies and replaces all instances of value in the copy with replacement. 
-	// Returns the modified copy.
-	string string::replace_all(const std::string& value, const std::string& replacement) const
-	{
-		if (is_empty())
-			return clone();
-		else return clone().replace_all(value, replacement);
-	}
+			if (p == last)
+				break;
 
-	// Replaces all instances of value in this with replacement. 
-	// Returns the count of replacements made.
-	string& string::replace_all(const char* value, const char* replacement)
-	{
-		if (is_empty() || value == nullptr)
-			return *this;
+			offsets.push_back(size_t(p - source.begin()));
+			first = p + n;
+		}
 
-		if (replacement == nullptr)
-			return replace_all(std::string(value), std::string());
-		else return replace_all(std::string(value), std::string(replacement));
+		return offsets.size() - count;
 	}
 
-	// Copies and replaces all instances of value in the copy with replacement. 
-	// Returns the modified copy.
-	string string::replace_all(const char* value, const char* replacement) const
+	// Finds the first of the literal needle, of length n, in [first, last), or last if none, by
+	// memchr for its first character, which C libraries vectorize, then a compare of the rest.
+	static const char* find_literal(const char* first, const char* last, const char* needle, size_t n)
 	{
-		if (is_empty() || value == nullptr)
-			return clone();
-		else return clone().replace_all(value, replacement);
-	}
+		while (size_t(last - first) >= n)
+		{
+			const char* p = (const char*)std::memchr(first, needle[0], size_t(last - first) - n + 1);
 
-	// Like strdup. Free with free().
-	inline static char* duplicate(const char* value)
-	{
-		if (value == nullptr)
-			return nullptr;
+			if (p == nullptr)
+				break;
 
-		size_t length = std::strlen(value) + 1;
-		char* result = (char*)std::malloc(length);
+			if (std::memcmp(p + 1, needle + 1, n - 1) == 0)
+				return p;
 
-		if (result == nullptr)
-			return nullptr;
+			first = p + 1;
+		}
 
-		return (char*)std::memcpy(result, value, length);
+		return last;
 	}
 
-	// Thread-safe tokenize, like strtok.
-	static char* tokenize(char* value, const char* delimiters, char** state)
+	// The offsets of the first instances found by count_instances, kept on the stack, so that
+	// a replacement with few instances allocates nothing but its result. Instances past these
+	// are only counted, and found again by write_replaced.
+	struct instance_offsets
 	{
-		char* temp; // Our working pointer.
+		static const size_t capacity = 32;
 
-		// Skip leading delimiters if new string.
-
-		if (value == nullptr)
-		{
-			value = *state;
+		size_t offsets[capacity];
+		size_t kept;
+	};
 
-			if (value == nullptr) // End?
-				return nullptr; // Return end of string indicator.
-		}
-		else value += std::strspn(value, delimiters); // Get the span of delimiters in value.
+	// Counts the non-overlapping instances, of length n, that find finds in source, keeping the
+	// offsets of the first of them in found. An empty needle has no instances.
+	template <typename Find>
+	static size_t count_instances(const string_view& source, size_t n, Find find, instance_offsets& found)
+	{
+		const char* first = source.begin();
+		const char* last = source.end();
+		size_t count = 0;
 
-		// Find end of segment.
+		found.kept = 0;
 
-		temp = std::strpbrk(value, delimiters); // Locate any of delimiters in value.
+		if (n == 0)
+			return 0;
 
-		if (temp != nullptr) // If located.
+		while (size_t(last - first) >= n)
 		{
-			// Found another delimiter, split string and save state.
+			const char* p = find(first, last);
+
+			if (p == last)
+				break;
+
+			if (count < instance_offsets::capacity)
+				found.offsets[found.kept++] = size_t(p - source.begin());
 
-			*temp = '\0'; // Terminate this segment.
-			*state = temp + 1;
+			++count;
+			first = p + n;
 		}
-		else *state = nullptr; // Last segment, remember that.
 
-		return value;
+		return count;
 	}
 
-	// Tokenizes this using the single delimiter, and appends the tokens to result vector.
-	// Returns the count of tokens appended.
-	size_t string::split(char delimiter, std::vector<string>& result) const
+	// Gets the length of source with count instances, of length n, replaced by m characters.
+	inline static size_t replaced_length(const string_view& source, size_t count, size_t n, size_t m)
 	{
-		if (delimiter == '\0') return 0;
-
-		char delimiters[2] = { delimiter, '\0' };
-
-		if (_null || base_type::length() == 0)
-			return 0;
-
-		char* temp = duplicate(base_type::c_str()); // Make a local writable copy.
-
-		if (temp == nullptr) return 0;
+		return source.length() - count * n + count * m;
+	}
 
-		char* state = nullptr;
-		char* token = tokenize(temp, delimiters, &state);
-		size_t count = 0;
+	// Writes source to result with each of the count instances counted into found, of length
+	// n, replaced by replacement, of length m, finding those past the kept offsets again.
+	// result has room for exactly replaced_length characters.
+	template <typename Find>
+	static void write_replaced(const string_view& source, size_t n, Find find, const instance_offsets& found, size_t count, const char* replacement, size_t m, char* result)
+	{
+		size_t copied = 0;
 
-		while (token != nullptr) // There are more tokens.
+		for (size_t i = 0; i < count; ++i)
 		{
-			result.push_back(string(token));
-			count++;
-			token = tokenize(nullptr, delimiters, &state);
-		}
+			const size_t offset = i < found.kept ? found.offsets[i] : size_t(find(source.begin() + copied, source.end()) - source.begin());
 
-		std::free(temp);
+			std::memcpy(result, source.begin() + copied, offset - copied);
+			result += offset - copied;
+			std::memcpy(result, replacement, m);
+			result += m;
+			copied = offset + n;
+		}
 
-		return count;
+		std::memcpy(result, source.begin() + copied, source.length() - copied);
 	}
 
-	// Tokenizes this using the single delimiter, and returns a vector of the tokens.
-	std::vector<string> string::split(char delimiter) const
+	// Replaces all instances, of length n, that find finds in target with replacement, of
+	// length m. A replacement of the same length is written in place as each instance is
+	// found; otherwise the instances are counted first, so that the result is sized exactly
+	// and written in one pass, rather than shifting the tail once per instance.
+	template <typename Alloc, typename Find>
+	static void replace_instances(basic_string<Alloc>& target, size_t n, Find find, const char* replacement, size_t m)
 	{
-		std::vector<string> result;
-
-		if (delimiter != '\0')
-			split(delimiter, result);
+		typedef typename basic_string<Alloc>::base_type base_type;
 
-		return result;
-	}
+		if (target.is_empty() || n == 0)
+			return;
 
-	// Tokenizes this using the delimiters, and appends the tokens to result vector.
-	// Returns the count of tokens appended.
-	size_t string::split(const char* delimiters, std::vector<string>& result) const
-	{
-		if (_null || base_type::length() == 0 || delimiters == nullptr || *delimiters == '\0')
-			return 0;
+		if (m == n)
+		{
+			char* data = &target.base_type::operator[](0);
+			char* last = data + target.length();
 
-		char* temp = duplicate(base_type::c_str()); // Make a local writable copy.
+			for (char* p = data; size_t(last - p) >= n; p += n)
+			{
+				p = const_cast<char*>(find(p, last));
 
-		if (temp == nullptr) return 0;
+				if (p == last)
+					break;
 
-		char* state = nullptr;
-		char* token = tokenize(temp, delimiters, &state);
-		size_t count = 0;
+				std::memcpy(p, replacement, m);
+			}
 
-		while (token != nullptr) // There are more tokens.
-		{
-			result.push_back(string(token));
-			count++;
-			token = tokenize(nullptr, delimiters, &state);
+			return;
 		}
 
-		std::free(temp);
+		const string_view source(target);
+		instance_offsets found;
+		const size_t count = count_instances(source, n, find, found);
 
-		return count;
-	}
+		if (count == 0)
+			return;
 
-	// Tokenizes this using the delimiters, and appends the tokens to result vector.
-	// Returns the count of tokens appended.
-	size_t string::split(const std::string& delimiters, std::vector<string>& result) const
-	{
-		if (delimiters.length() == 0)
-			return 0;
-		else return split(delimiters.c_str(), result);
+		base_type output(replaced_length(source, count, n, m), '\0', target.get_allocator());
+
+		write_replaced(source, n, find, found, count, replacement, m, &output[0]);
+		target.base_type::swap(output);
 	}
 
-	// Tokenizes this using the delimiters, and returns a vector of the tokens.
-	std::vector<string> string::split(const char* delimiters) const
+	// Copies source with all instances, of length n, that find finds replaced with replacement,
+	// of length m, writing the copy once with the replacements in place.
+	template <typename Alloc, typename Find>
+	static basic_string<Alloc> replaced_copy(const basic_string<Alloc>& source, size_t n, Find find, const char* replacement, size_t m)
 	{
-		std::vector<string> result;
+		typedef typename basic_string<Alloc>::base_type base_type;
 
-		if (delimiters != nullptr && *delimiters)
-			split(delimiters, result);
+		instance_offsets found;
+		const size_t count = source.is_empty() ? 0 : count_instances(source, n, find, found);
 
-		return result;
-	}
+		if (count == 0)
+			return source.clone();
 
-	// Tokenizes this using the delimiters, and returns a vector of the tokens.
-	std::vector<string> string::split(const std::string& delimiters) const
-	{
-		std::vector<string> result;
+		basic_string<Alloc> result(source.get_allocator());
 
-		if (delimiters.length() > 0)
-			split(delimiters.c_str(), result);
+		result.base_type::resize(replaced_length(source, count, n, m));
+		write_replaced(source, n, find, found, count, replacement, m, &result.base_type::operator[](0));
 
 		return result;
 	}
 
-	// Tokenizes this using the delimiters, and appends the tokens, and each encountered 
-	// delimiter as a separate string, to the result vector. Delimiters in omit, if non-null 
-	// will not be retained.
-	// Returns the count of tokens (including delimiters) captured.
-	size_t string::split_with(const char* delimiters, std::vector<string>& result, const char* omit /*= nullptr*/) const
+	// Replaces all instances of the needle of value in target with replacement, of length m.
+	template <typename Alloc>
+	static void replace_instances(basic_string<Alloc>& target, const searcher& value, const char* replacement, size_t m)
 	{
-		if (delimiters == nullptr || *delimiters == '\0' || is_empty())
-			return 0;
-		
-		char* copy;
-		char* temp = copy = duplicate(base_type::c_str()); // Make a local writable copy.
-
-		if (temp == nullptr) return 0;
+		replace_instances(target, value.length(), [&value](const char* first, const char* last) { return value.find(first, last); }, replacement, m);
+	}
 
-		char token[2] = { '\0', '\0' };
-		size_t count = 0;
+	// Replaces all instances of needle in target with replacement, of length m. A needle short
+	// enough for the packed-pair filter is found directly, rather than building a searcher for
+	// the one call.
+	template <typename Alloc>
+	static void replace_instances(basic_string<Alloc>& target, const string_view& needle, const char* replacement, size_t m)
+	{
+		if (needle.length() > searcher::pair_limit)
+			replace_instances(target, searcher(needle), replacement, m);
+		else replace_instances(target, needle.length(), [&needle](const char* first, const char* last) { return find_literal(first, last, needle.data(), needle.length()); }, replacement, m);
+	}
 
-		// Process any leading delimiters.
-		while (*temp && is_one_of(*temp, delimiters))
-		{
-			if (!(omit && is_one_of(*temp, omit))) // Add it if not omitted.
-			{
-				token[0] = *temp;
-				result.push_back(string(token));
-				++count;
-			}
+	// Copies source with all instances of the needle of value replaced with replacement, of length m.
+	template <typename Alloc>
+	static basic_string<Alloc> replaced_copy(const basic_string<Alloc>& source, const searcher& value, const char* replacement, size_t m)
+	{
+		return replaced_copy(source, value.length(), [&value](const char* first, const char* last) { return value.find(first, last); }, replacement, m);
+	}
 
-			++temp;
-		}
+	// Copies source with all instances of needle replaced with replacement, of length m, finding
+	// a short needle directly as replace_instances does.
+	template <typename Alloc>
+	static basic_string<Alloc> replaced_copy(const basic_string<Alloc>& source, const string_view& needle, const char* replacement, size_t m)
+	{
+		if (needle.length() > searcher::pair_limit)
+			return replaced_copy(source, searcher(needle), replacement, m);
+		else return replaced_copy(source, needle.length(), [&needle](const char* first, const char* last) { return find_literal(first, last, needle.data(), needle.length()); }, replacement, m);
+	}
 
-		while (*temp)
-		{
-			char* start = temp; // Mark token start.
+	// Replaces all instances of value in this with replacement, in one pass over an output sized
+	// exactly for the instances found, rather than shifting the tail once per instance.
+	// Returns this modified instance.
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::replace_all(const std::string& value, const std::string& replacement) &
+	{
+		if (!is_empty())
+			replace_instances(*this, string_view(value), replacement.data(), replacement.length());
 
-			++temp;
-			
-			while (*temp && !is_one_of(*temp, delimiters)) // Accumulate token characters.
-				++temp;
+		return *this;
+	}
 
-			bool ending = false; // Is there an ending token?
+	// Copies and replaces all instances of value in the copy with replacement, writing the copy
+	// once with the replacements in place, rather than cloning this and then replacing.
+	// Returns the modified copy.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::replace_all(const std::string& value, const std::string& replacement) const &
+	{
+		if (is_empty())
+			return clone();
+		else return replaced_copy(*this, string_view(value), replacement.data(), replacement.length());
+	}
 
-			if (*temp && is_one_of(*temp, delimiters)) 
-			{
-				token[0] = *temp; // Store any terminating delimiter.
-				ending = true;
-			}
+	// Replaces all instances of value in this temporary with replacement, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::replace_all(const std::string& value, const std::string& replacement) &&
+	{
+		return std::move(replace_all(value, replacement));
+	}
 
-			bool stop = (!*temp); // If we are at end.
+	// Replaces all instances of value in this with replacement. 
+	// Returns this modified instance.
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::replace_all(const char* value, const char* replacement) &
+	{
+		if (is_empty() || value == nullptr)
+			return *this;
 
-			*temp = 0; // Terminate and store the current non-delimiter token.
-			result.push_back(string(start));
-			++count;
+		replace_instances(*this, string_view(value), replacement == nullptr ? "" : replacement, replacement == nullptr ? 0 : std::strlen(replacement));
 
-			if (ending) // Keep any previously stored ending delimiter token.
-			{
-				if (!(omit && is_one_of(token[0], omit))) // Add it if not omitted.
-				{
-					result.push_back(string(token));
-					++count;
-				}
-			}
+		return *this;
+	}
 
-			if (stop) break; // At end so bail out.
+	// Copies and replaces all instances of value in the copy with replacement. 
+	// Returns the modified copy.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::replace_all(const char* value, const char* replacement) const &
+	{
+		if (is_empty() || value == nullptr)
+			return clone();
+		else return replaced_copy(*this, string_view(value), replacement == nullptr ? "" : replacement, replacement == nullptr ? 0 : std::strlen(replacement));
+	}
 
-			++temp; // Step over the null we made.
+	// Replaces all instances of value in this temporary with replacement, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::replace_all(const char* value, const char* replacement) &&
+	{
+		return std::move(replace_all(value, replacement));
+	}
 
-			while (*temp && is_one_of(*temp, delimiters)) // Process any trailing delimiters.
-			{
-				if (!(omit && is_one_of(*temp, omit))) // Add it if not omitted.
-				{
-					token[0] = *temp;
-					result.push_back(string(token));
-					++count;
-				}
+	// Replaces the first instance of the needle of value in this with substitute.
+	// Returns this modified instance.
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::replace(const searcher& value, const char* substitute) &
+	{
+		if (is_empty() || value.length() == 0)
+			return *this;
 
-				++temp;
-			}
-		}
+		size_t location = value.find(*this);
 
-		std::free(copy);
+		if (location != base_type::npos)
+			base_type::replace(location, value.length(), substitute == nullptr ? "" : substitute);
 
-		return count;
+		return *this;
 	}
 
-	// Tokenizes this using the delimiters, and appends the tokens, and each encountered 
-	// delimiter as a separate string, to the result vector.
-	// Returns the count of tokens (including delimiters) captured.
-	size_t string::split_with(const std::string& delimiters, std::vector<string>& result) const
+	// Copies and replaces the first instance of the needle of value with substitute.
+	// Returns the modified copy.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::replace(const searcher& value, const char* substitute) const &
 	{
-		size_t n = delimiters.length();
-		if (n == 0) return 0;
-		else if (n == 1)
-			return split_with(delimiters[0], result);
-		else return split_with(delimiters.c_str(), result);
+		return clone().replace(value, substitute);
 	}
 
-	// Tokenizes this using the delimiters, and returns a vector of the tokens, and each encountered 
-	// delimiter as a separate string, to the result vector.
-	std::vector<string> string::split_with(const char* delimiters, const char* omit /*= nullptr*/) const
+	// Replaces the first instance of the needle of value in this temporary with substitute, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::replace(const searcher& value, const char* substitute) &&
 	{
-		std::vector<string> result;
-
-		if (delimiters == nullptr || !*delimiters)
-			return result;
-
-		size_t n = std::strlen(delimiters);
-
-		if (n == 0)
-			return result;
-		else if (n == 1)
-			split_with(delimiters[0], result);
-		else split_with(delimiters, result, omit);
-
-		return result;
+		return std::move(replace(value, substitute));
 	}
 
-	// Tokenizes this using the delimiters, and returns a vector of the tokens, and each encountered 
-	// delimiter as a separate string, to the result vector.
-	std::vector<string> string::split_with(const std::string& delimiters) const
+	// Replaces all instances of the needle of value in this with replacement.
+	// Returns this modified instance.
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::replace_all(const searcher& value, const char* replacement) &
 	{
-		std::vector<string> result;
+		replace_instances(*this, value, replacement == nullptr ? "" : replacement, replacement == nullptr ? 0 : std::strlen(replacement));
 
-		size_t n = delimiters.length();
+		return *this;
+	}
 
-		if (n == 0) 
-			return result;
-		else if (n == 1) 
-			split_with(delimiters[0], result);
-		else split_with(delimiters.c_str(), result);
+	// Copies and replaces all instances of the needle of value in the copy with replacement.
+	// Returns the modified copy.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::replace_all(const searcher& value, const char* replacement) const &
+	{
+		return replaced_copy(*this, value, replacement == nullptr ? "" : replacement, replacement == nullptr ? 0 : std::strlen(replacement));
+	}
 
-		return result;
+	// Replaces all instances of the needle of value in this temporary with replacement, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::replace_all(const searcher& value, const char* replacement) &&
+	{
+		return std::move(replace_all(value, replacement));
 	}
 
-	// Tokenizes this using the single delimiter, and appends the tokens, and each encountered 
-	// delimiter as a separate string, to the result vector.
-	// Returns the count of tokens (including delimiters) captured.
-	size_t string::split_with(char delimiter, std::vector<string>& result) const
+	// Replaces the keys of replacements in this with their values. The occurrences are found
+	// first, so that the output is sized exactly and written in one pass.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::replace_all(const replacer& replacements)
 	{
-		if (delimiter == '\0' || is_empty())
+		if (is_empty())
 			return 0;
 
-		char* copy;
-		char* temp = copy = duplicate(base_type::c_str()); // Make a local writable copy.
-
-		if (temp == nullptr) return 0;
-
-		char token[2] = { delimiter, '\0' }; // Pre-fab delimiter token we will use.
-		size_t count = 0;
-
-		// Process any leading delimiters.
-		while (*temp && *temp == delimiter)
-		{
-			result.push_back(string(token));
-			++count;
-			++temp;
-		}
-
-		while (*temp)
-		{
-			char* start = temp; // Mark token start.
-
-			++temp;
-
-			while (*temp && *temp != delimiter) // Accumulate token characters.
-				++temp;
+		std::vector<keyword_set::match> found;
 
-			bool ending = false; // Is there an ending token?
-
-			if (*temp && *temp == delimiter)
-				ending = true;
-
-			bool stop = (!*temp); // If we are at end.
+		if (replacements.find(*this, found) == 0)
+			return 0;
 
-			*temp = 0; // Terminate and store the current non-delimiter token.
-			result.push_back(string(start));
-			++count;
+		size_t total = base_type::length();
 
-			if (ending) // Keep any previously stored ending delimiter token.
-			{
-				result.push_back(string(token));
-				++count;
-			}
+		for (const keyword_set::match& match : found)
+			total = total - match.view.length() + replacements.value(match.keyword).length();
 
-			if (stop) break; // At end so bail out.
+		base_type output(total, '\0', base_type::get_allocator());
+		char* out = &output[0];
+		const char* copied = base_type::data();
 
-			++temp; // Step over the null we made.
+		for (const keyword_set::match& match : found)
+		{
+			const std::string& value = replacements.value(match.keyword);
 
-			while (*temp && *temp == delimiter) // Process any trailing delimiters.
-			{
-				result.push_back(string(token));
-				++count;
-				++temp;
-			}
+			std::memcpy(out, copied, size_t(match.view.begin() - copied));
+			out += match.view.begin() - copied;
+			std::memcpy(out, value.data(), value.length());
+			out += value.length();
+			copied = match.view.end();
 		}
 
-		std::free(copy);
+		std::memcpy(out, copied, size_t(base_type::data() + base_type::length() - copied));
+		base_type::swap(output);
 
-		return count;
+		return found.size();
 	}
 
-	// Tokenizes this using the single delimiter, and returns a vector of the tokens
-	// with each separate delimiter as a string, in order.
-	std::vector<string> string::split_with(char delimiter) const
+	// Replaces the keys of replacements in this with their values, as with a replacer built from them.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::replace_all(const std::vector<std::pair<std::string, std::string>>& replacements)
 	{
-		std::vector<string> result;
-
-		if (delimiter != '\0')
-			split_with(delimiter, result);
-
-		return result;
+		return replace_all(replacer(replacements));
 	}
 
-	// Returns true if this is formatted as a decimal integer with an optional sign.
-	bool string::is_decimal_integer() const
-	{
-		if (_null || base_type::length() == 0) return false;
-		string value = trim();
-		if (value.length() == 0) return false;
-		char lead = value[0];
-		if (lead == '+' || lead == '-')
-			value = value.substr(1);
-		return (is_one_of(value[0], "123456789") && value.consists_of("0123456789"));
-	}
+#if defined(_MSC_VER)
+	inline static unsigned first_bit(uint32_t value) { unsigned long index; _BitScanForward(&index, value); return unsigned(index); }
+#else
+	inline static unsigned first_bit(uint32_t value) { return unsigned(__builtin_ctz(value)); }
+#endif
 
-	// Returns true if this is formatted as a decimal integer with a sign.
-	bool string::is_signed_decimal_integer() const
+	// An empty set.
+	char_set::char_set() : _ascii(true)
 	{
-		if (_null || base_type::length() == 0) return false;
-		string value = trim();
-		if (value.length() == 0) return false;
-		char lead = value[0];
-		if (lead != '+' && lead != '-') return false;
-		value = value.substr(1);
-		return is_one_of(value[0], "123456789") && value.consists_of("0123456789");
+		std::memset(_bits, 0, sizeof(_bits));
+		std::memset(_nibbles, 0, sizeof(_nibbles));
 	}
 
-	// Returns true if this is formatted as an unsigned decimal integer.
-	bool string::is_unsigned_decimal_integer() const
+	// The set of characters in chars, excluding the terminating null. A null chars is empty.
+	char_set::char_set(const char* chars) : char_set()
 	{
-		if (_null || base_type::length() == 0) return false;
-		string value = trim();
-		if (value.length() == 0) return false;
-		char lead = value[0];
-		if (lead == '+' || lead == '-') return false;
-		value = value.substr(1);
-		return is_one_of(value[0], "123456789") && value.consists_of("0123456789");
+		if (chars != nullptr)
+			for (const char* p = chars; *p; ++p)
+				add(*p);
 	}
 
-	// Returns true if this is formatted as a hexadecimal integer.
-	bool string::is_hexadecimal_integer() const
+	// The set of the single character value.
+	char_set::char_set(char value) : char_set()
 	{
-		if (_null || base_type::length() == 0) return false;
-		string value = trim().to_lower();
-		if (value.length() == 0) return false;
-		if (!value.starts_with("0x")) return false;
-		value = value.substring(2);
-		return value.consists_of("0123456789abcdef");
+		if (value != '\0')
+			add(value);
 	}
 
-	// Returns true if this is formatted as an octal integer with the "0" prefix.
-	bool string::is_octal_integer() const
+	// Adds value to the set. Each nibble table entry, indexed by the low nibble of a member, 
+	// has the bit for the member's high nibble set; this only covers ASCII, so non-ASCII sets
+	// are scanned with the membership table alone.
+	void char_set::add(char value)
 	{
-		if (_null || base_type::length() == 0) return false;
-		string value = trim();
-		if (length() == 0 || value[0] != '0') return false;
-		return value.consists_of("01234567");
-	}
+		const unsigned char c = (unsigned char)value;
 
-	// Returns true if this is formatted as a binary integer with the "0b" prefix.
-	bool string::is_binary_integer() const
-	{
-		if (_null || base_type::length() == 0) return false;
-		string value = trim().to_lower();
-		if (value.length() == 0 || !value.starts_with("0b")) return false;
-		value = value.substring(2);
-		return value.consists_of("01");
+		_bits[c >> 6] |= uint64_t(1) << (c & 63);
+
+		if (c < 0x80)
+			_nibbles[c & 0x0F] |= uint8_t(1U << (c >> 4));
+		else _ascii = false;
 	}
 
-	// Returns true if this is formatted as a decimal, hexadecimal, or octal integer.
-	bool string::is_integer() const
+#if defined(__AVX2__)
+
+	// Gets the bitmask of the members of the set among the 32 bytes at p.
+	inline static uint32_t member_mask(const __m256i& nibbles, const char* p)
 	{
-		if (_null || base_type::length() == 0) return false;
-		return 
-			is_decimal_integer() || 
-			is_hexadecimal_integer() || 
-			is_octal_integer() || 
-			is_binary_integer();
+		const __m256i low_mask = _mm256_set1_epi8(0x0F);
+		const __m256i high_bits = _mm256_setr_epi8(
+			1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+			1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+
+		__m256i v = _mm256_loadu_si256((const __m256i*)p);
+		__m256i rows = _mm256_shuffle_epi8(nibbles, _mm256_and_si256(v, low_mask));
+		__m256i bits = _mm256_shuffle_epi8(high_bits, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask));
+		__m256i misses = _mm256_cmpeq_epi8(_mm256_and_si256(rows, bits), _mm256_setzero_si256());
+
+		return ~uint32_t(_mm256_movemask_epi8(misses));
 	}
 
-	// Returns true if this is formatted as a boolean.
-	bool string::is_boolean() const
+	static const size_t char_set_step = 32;
+
+#elif defined(__SSSE3__)
+
+	// Gets the bitmask of the members of the set among the 16 bytes at p.
+	inline static uint32_t member_mask(const __m128i& nibbles, const char* p)
 	{
-		if (_null || base_type::length() == 0) return false;
-		string value = trim().to_lower();
-		return (value == "true" || value == "false" || value == "1" || value == "0");
+		const __m128i low_mask = _mm_set1_epi8(0x0F);
+		const __m128i high_bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+
+		__m128i v = _mm_loadu_si128((const __m128i*)p);
+		__m128i rows = _mm_shuffle_epi8(nibbles, _mm_and_si128(v, low_mask));
+		__m128i bits = _mm_shuffle_epi8(high_bits, _mm_and_si128(_mm_srli_epi16(v, 4), low_mask));
+		__m128i misses = _mm_cmpeq_epi8(_mm_and_si128(rows, bits), _mm_setzero_si128());
+
+		return ~uint32_t(_mm_movemask_epi8(misses)) & 0xFFFFU;
 	}
 
-	// Returns true if this is formatted as a decimal floating point value.
-	bool string::is_decimal_float() const
-	{
-		if (_null || base_type::length() == 0)  return false;
+	static const size_t char_set_step = 16;
 
-		string value = trim();
+#endif
 
-		if (value.length() == 0)
-			return false;
+	// Finds the first character in [first, last) which is a member, or last if none.
+	const char* char_set::find(const char* first, const char* last) const
+	{
+		const char* p = first;
 
-		value.to_lower();
+#if defined(__AVX2__) || defined(__SSSE3__)
+		if (_ascii)
+		{
+#if defined(__AVX2__)
+			const __m256i nibbles = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)_nibbles));
+#else
+			const __m128i nibbles = _mm_loadu_si128((const __m128i*)_nibbles);
+#endif
+			for (; size_t(last - p) >= char_set_step; p += char_set_step)
+			{
+				uint32_t mask = member_mask(nibbles, p);
 
-		if (value == "nan" || value == "qnan" || value == "snan")
-			return true;
+				if (mask != 0)
+					return p + first_bit(mask);
+			}
+		}
+#endif
 
-		char lead = value[0];
+		for (; p < last; ++p)
+			if (contains(*p))
+				return p;
 
-		if (lead == '+' || lead == '-')
-			value = value.substring(1);
+		return last;
+	}
 
-		if (value == "inf") return true;
+	// Finds the first character in [first, last) which is not a member, or last if none.
+	const char* char_set::find_not(const char* first, const char* last) const
+	{
+		const char* p = first;
 
-		int dot = value.index_of('.');
+		// Runs of delimiters are usually short, so test a few bytes before going wide.
+		for (size_t i = 0; i < 4 && p < last; ++i, ++p)
+			if (!contains(*p))
+				return p;
 
-		if (dot == -1) return false;
+#if defined(__AVX2__) || defined(__SSSE3__)
+		if (_ascii)
+		{
+#if defined(__AVX2__)
+			const __m256i nibbles = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)_nibbles));
+			const uint32_t full = 0xFFFFFFFFU;
+#else
+			const __m128i nibbles = _mm_loadu_si128((const __m128i*)_nibbles);
+			const uint32_t full = 0xFFFFU;
+#endif
+			for (; size_t(last - p) >= char_set_step; p += char_set_step)
+			{
+				uint32_t mask = member_mask(nibbles, p) ^ full;
+
+				if (mask != 0)
+					return p + first_bit(mask);
+			}
+		}
+#endif
 
-		string whole = value.substring(0, dot);
+		for (; p < last; ++p)
+			if (!contains(*p))
+				return p;
 
-		if (whole.non_empty() && (!is_one_of(whole[0], "123456789") || !whole.consists_of("0123456789")))
-			return false;
+		return last;
+	}
 
-		string fraction = value.substring(dot + 1, value.length() - dot);
-		string exponent;
+#if defined(_MSC_VER)
+	inline static unsigned last_bit(uint32_t value) { unsigned long index; _BitScanReverse(&index, value); return unsigned(index); }
+#else
+	inline static unsigned last_bit(uint32_t value) { return 31U - unsigned(__builtin_clz(value)); }
+#endif
 
-		int exp = fraction.index_of('e');
+	// Finds the last occurrence of value in [first, last), or null if none, as memrchr does,
+	// a vector at a time from the end.
+	static const char* find_last_byte(const char* first, const char* last, char value)
+	{
+#if defined(__AVX2__)
+		const __m256i values = _mm256_set1_epi8(value);
 
-		if (exp > -1)
+		for (; last - first >= 32; last -= 32)
 		{
-			exponent = fraction.substr(exp + 1);
-			fraction = fraction.substring(0, exp);
-		}
+			uint32_t mask = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(last - 32)), values)));
 
-		if (!fraction.consists_of("0123456789"))
-			return false;
+			if (mask != 0)
+				return last - 32 + last_bit(mask);
+		}
+#elif defined(__SSSE3__)
+		const __m128i values = _mm_set1_epi8(value);
 
-		if (exponent.non_empty())
+		for (; last - first >= 16; last -= 16)
 		{
-			if (exponent[0] == '+' || exponent[0] == '-')
-				exponent = exponent.substring(1);
+			uint32_t mask = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(last - 16)), values)));
 
-			return (is_one_of(exponent[0], "123456789") && exponent.consists_of("0123456789"));
+			if (mask != 0)
+				return last - 16 + last_bit(mask);
 		}
-		else return true;
+#endif
+
+		while (last > first)
+			if (*--last == value)
+				return last;
+
+		return nullptr;
 	}
 
-	// Returns true if this is formatted as a hexadecimal floating point value.
-	bool string::is_hexadecimal_float() const
+	// Two bytes sought together by the packed-pair filter: a at offset head and b at offset tail
+	// from a candidate, each compared with the bits of its fold set. Setting the 0x20 bit of a
+	// letter compares it caseless, since only its two cases share the result.
+	struct byte_pair
 	{
-		if (_null || base_type::length() == 0)  return false;
+		size_t head;
+		size_t tail;
+		unsigned char a;
+		unsigned char b;
+		unsigned char head_fold;
+		unsigned char tail_fold;
 
-		string value = trim();
+		inline bool admits(const char* p) const { return ((unsigned char)p[head] | head_fold) == a && ((unsigned char)p[tail] | tail_fold) == b; }
+	};
 
-		if (value.length() == 0)
-			return false;
+#if defined(__AVX2__)
 
-		value.to_lower();
+	static const size_t pair_step = 32;
 
-		if (value == "nan" || value == "qnan" || value == "snan")
-			return true;
+	// Gets the bitmask of the candidates among the 32 at p which pair admits.
+	inline static uint32_t pair_mask(const byte_pair& pair, const char* p)
+	{
+		__m256i x = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(p + pair.head)), _mm256_set1_epi8(char(pair.head_fold)));
+		__m256i y = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(p + pair.tail)), _mm256_set1_epi8(char(pair.tail_fold)));
 
-		char lead = value[0];
+		return uint32_t(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(char(pair.a))), _mm256_cmpeq_epi8(y, _mm256_set1_epi8(char(pair.b))))));
+	}
 
-		if (lead == '+' || lead == '-')
-			value = value.substring(1);
+#elif defined(__SSSE3__)
 
-		if (value == "inf") return true;
+	static const size_t pair_step = 16;
 
-		if (!value.starts_with("0x"))
-			return false;
+	// Gets the bitmask of the candidates among the 16 at p which pair admits.
+	inline static uint32_t pair_mask(const byte_pair& pair, const char* p)
+	{
+		__m128i x = _mm_or_si128(_mm_loadu_si128((const __m128i*)(p + pair.head)), _mm_set1_epi8(char(pair.head_fold)));
+		__m128i y = _mm_or_si128(_mm_loadu_si128((const __m128i*)(p + pair.tail)), _mm_set1_epi8(char(pair.tail_fold)));
 
-		value = value.substring(2);
+		return uint32_t(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(char(pair.a))), _mm_cmpeq_epi8(y, _mm_set1_epi8(char(pair.b))))));
+	}
 
-		int dot = value.index_of('.');
+#endif
 
-		if (dot == -1) return false;
+	// Finds the first candidate p in [first, end) which pair admits and for which verify(p)
+	// holds, or null if none. The bytes before end plus its larger offset must be readable. Two
+	// well-chosen bytes pass few candidates, so the filter runs a vector of candidates at once,
+	// and only those it passes are verified.
+	template <typename Verify>
+	static const char* find_pair(const byte_pair& pair, const char* first, const char* end, Verify verify)
+	{
+		const char* p = first;
 
-		string whole = value.substring(0, dot);
+#if defined(__AVX2__) || defined(__SSSE3__)
+		for (; size_t(end - p) >= pair_step; p += pair_step)
+			for (uint32_t mask = pair_mask(pair, p); mask != 0; mask &= mask - 1)
+				if (verify(p + first_bit(mask)))
+					return p + first_bit(mask);
+#endif
 
-		if (whole.non_empty() && !whole.consists_of("0123456789abcdef"))
-			return false;
+		for (; p < end; ++p)
+		{
+			if (pair.head_fold == 0)
+			{
+				// Jump to the next head byte, which memchr finds quickly.
+				p = (const char*)std::memchr(p + pair.head, pair.a, size_t(end - p));
 
-		string fraction = value.substring(dot + 1, value.length() - dot);
-		string exponent;
+				if (p == nullptr)
+					return nullptr;
 
-		int exp = fraction.index_of('p');
+				p -= pair.head;
+			}
 
-		if (exp > -1)
-		{
-			exponent = fraction.substr(exp + 1);
-			fraction = fraction.substring(0, exp);
+			if (pair.admits(p) && verify(p))
+				return p;
 		}
 
-		if (!fraction.consists_of("0123456789abcdef"))
-			return false;
+		return nullptr;
+	}
 
-		if (exponent.non_empty())
+	// Finds the last candidate p in [first, end) which pair admits and for which verify(p)
+	// holds, or null if none, as find_pair does but from the end.
+	template <typename Verify>
+	static const char* find_last_pair(const byte_pair& pair, const char* first, const char* end, Verify verify)
+	{
+#if defined(__AVX2__) || defined(__SSSE3__)
+		for (; size_t(end - first) >= pair_step; end -= pair_step)
 		{
-			if (exponent[0] == '+' || exponent[0] == '-')
-				exponent = exponent.substring(1);
+			const char* p = end - pair_step;
 
-			return exponent.consists_of("0123456789abcdef");
+			for (uint32_t mask = pair_mask(pair, p); mask != 0; mask &= ~(uint32_t(1) << last_bit(mask)))
+				if (verify(p + last_bit(mask)))
+					return p + last_bit(mask);
 		}
-		else return true;
-	}
+#endif
 
-	// Returns true if this is formatted as a decimal or hexadecimal floating point value.
-	bool string::is_float() const
-	{
-		return is_decimal_float() || is_hexadecimal_float();
-	}
+		while (end > first)
+		{
+			--end;
 
-	// Attempts to parse this as an integer value in binary, octal, decimal or hexadecimal format.
-	// Returns true if the operation succeeded.
-	// If the operation failed, result and negative will not be set.
-	bool string::parse_integer(unsigned long long& result, bool& negative) const
-	{
-		if (_null || base_type::length() == 0) return false;
+			if (pair.admits(end) && verify(end))
+				return end;
+		}
+
+		return nullptr;
+	}
 
-		string str = trim();
+#if defined(_MSC_VER)
+	inline static unsigned bit_count(uint32_t value) { return unsigned(__popcnt(value)); }
+#else
+	inline static unsigned bit_count(uint32_t value) { return unsigned(__builtin_popcount(value)); }
+#endif
 
-		if (str.length() == 0) return false;
+	// Counts the characters in [first, last) which are members, by the popcount of a vector's
+	// membership mask at a time.
+	size_t char_set::count(const char* first, const char* last) const
+	{
+		const char* p = first;
+		size_t result = 0;
 
-		if (str.is_binary_integer())
+#if defined(__AVX2__) || defined(__SSSE3__)
+		if (_ascii)
 		{
-			str = str.substring(2);
+#if defined(__AVX2__)
+			const __m256i nibbles = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)_nibbles));
+#else
+			const __m128i nibbles = _mm_loadu_si128((const __m128i*)_nibbles);
+#endif
+			for (; size_t(last - p) >= char_set_step; p += char_set_step)
+				result += bit_count(member_mask(nibbles, p));
+		}
+#endif
 
-			const char* start = str.c_str();
-			char* end = nullptr;
+		for (; p < last; ++p)
+			if (contains(*p))
+				++result;
 
-			unsigned long long val = strtoull(start, &end, 2);
+		return result;
+	}
 
-			if ((val == ULLONG_MAX || val == LLONG_MIN) && errno == ERANGE)
-				return false;
+	// Counts the instances of value in [first, last), by the popcount of a vector's equality mask
+	// at a time.
+	static size_t count_byte(const char* first, const char* last, char value)
+	{
+		size_t result = 0;
 
-			negative = false;
-			result = val;
+#if defined(__AVX2__)
+		const __m256i values = _mm256_set1_epi8(value);
 
-			return true;
-		}
-		else if (str.is_octal_integer())
-		{
-			str = str.substring(1);
+		for (; last - first >= 32; first += 32)
+			result += bit_count(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)first), values))));
+#elif defined(__SSSE3__)
+		const __m128i values = _mm_set1_epi8(value);
 
-			const char* start = str.c_str();
-			char* end = nullptr;
+		for (; last - first >= 16; first += 16)
+			result += bit_count(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)first), values))));
+#endif
 
-			unsigned long long val = strtoull(start, &end, 8);
+		for (; first < last; ++first)
+			if (*first == value)
+				++result;
 
-			if ((val == ULLONG_MAX || val == 0) && errno == ERANGE)
-				return false;
+		return result;
+	}
 
-			negative = false;
-			result = val;
+	// Skips a bracket expression at p, just past its '['. Returns the position past the closing
+	// ']', or null if there is none. Adds its members to set, and sets negated if it is negated;
+	// if it holds an escape or a class, which the prefilter does not read, clears read instead.
+	// Only ECMAScript escapes within brackets; in extended syntax a '\\' is a member.
+	static const char* prefilter_bracket(const char* p, bool ecma, bool* set, bool& negated, bool& read)
+	{
+		negated = *p == '^';
+		read = true;
 
-			return true;
+		if (negated) ++p;
+
+		if (*p == ']' && !ecma) // A leading ']' is a member, except in ECMAScript, where [] is empty.
+		{
+			set[(unsigned char)']'] = true;
+			++p;
 		}
-		else if (str.is_decimal_integer())
+
+		while (*p != ']')
 		{
-			bool neg = false;
+			if (*p == '\0')
+				return nullptr;
 
-			if (str[0] == '+' || str[0] == '-')
+			if (*p == '\\' && ecma)
 			{
-				neg = (str[0] == '-');
-				str = str.substring(1);
+				read = false;
+				if (*++p == '\0') return nullptr;
+				++p;
+				continue;
 			}
 
-			const char* start = str.c_str();
-			char* end = nullptr;
-
-			unsigned long long val = strtoull(start, &end, 10);
-
-			if ((val == ULLONG_MAX || val == 0) && errno == ERANGE)
-				return false;
-
-			negative = neg;
-			result = val;
+			if (*p == '[' && (p[1] == ':' || p[1] == '=' || p[1] == '.'))
+			{
+				const char close[3] = { p[1], ']', '\0' };
 
-			return true;
-		}
-		else if (str.is_hexadecimal_integer())
-		{
-			str = str.substring(2);
+				read = false;
+				p = std::strstr(p + 2, close);
+				if (p == nullptr) return nullptr;
+				p += 2;
+				continue;
+			}
 
-			const char* start = str.c_str();
-			char* end = nullptr;
-			unsigned long long val = strtoull(start, &end, 16);
+			unsigned char low = (unsigned char)*p++;
+			unsigned char high = low;
 
-			if ((val == ULLONG_MAX || val == 0) && errno == ERANGE)
-				return false;
+			if (*p == '-' && p[1] != ']' && p[1] != '\0')
+			{
+				if ((p[1] == '\\' && ecma) || p[1] == '[' || (unsigned char)p[1] < low)
+				{
+					read = false;
+					++p;
+					continue;
+				}
 
-			negative = false;
-			result = val;
+				high = (unsigned char)p[1];
+				p += 2;
+			}
 
-			return true;
+			for (unsigned c = low; c <= high; ++c)
+				set[c] = true;
 		}
 
-		return false;
+		return p + 1;
 	}
 
-	// Attempts to parse this as a floating point number.
-	// Returns true if the operation succeeded, and result will be set.
-	// If the operation failed, result will not be set.
-	bool string::parse_float(long double& result) const
+	// Skips a group at p, just past its '('. Returns the position past the closing ')', or
+	// null if there is none.
+	static const char* prefilter_group(const char* p, bool ecma)
 	{
-		if (_null || base_type::length() == 0) return false;
-
-		string str = trim();
-
-		if (str.length() == 0) return false;
-
-		str = str.to_lower();
+		bool set[256] = { };
+		bool negated = false, read = false;
 
-		if (str == "nan" || str == "qnan" || str == "nan?")
+		for (size_t depth = 1; *p != '\0';)
 		{
-			result = std::numeric_limits<long double>::quiet_NaN();
-			return true;
-		}
-		else if (str == "snan")
-		{
-			result = std::numeric_limits<long double>::signaling_NaN();
-			return true;
-		}
-		else if (str == "inf" || str == "+inf")
-		{
-			result = std::numeric_limits<long double>::infinity();
-			return true;
-		}
-		else if (str == "-inf")
-		{
-			result = -std::numeric_limits<long double>::infinity();
-			return true;
-		}
-
-		if (str.is_decimal_float() || str.is_hexadecimal_float())
-		{
-			const char* start = str.c_str();
-			char* end = nullptr;
-			long double val = strtold(start, &end);
-
-			if ((val == HUGE_VALL || val == 0.0L) && errno == ERANGE)
-				return false;
-
-			result = val;
-
-			return true;
+			switch (*p)
+			{
+			case '\\': if (*++p == '\0') return nullptr; ++p; break;
+			case '[': p = prefilter_bracket(p + 1, ecma, set, negated, read); if (p == nullptr) return nullptr; break;
+			case '(': ++depth; ++p; break;
+			case ')': ++p; if (--depth == 0) return p; break;
+			default: ++p;
+			}
 		}
 
-		return false;
+		return nullptr;
 	}
 
-	// Attempts to parse this as a boolean.
-	// Returns true if the operation succeeded, and result will be set.
-	// If the operation failed, result will not be set.
-	bool string::parse_boolean(bool& result) const
-	{
-		if (_null || base_type::length() == 0) return false;
+	// A prefilter which admits everything.
+	regex_prefilter::regex_prefilter() { }
 
-		string str = trim();
+	// Reads the top level of the expression, as a sequence of atoms, each optionally quantified.
+	// Runs of unquantified literal characters must appear in every match, and the longest is
+	// kept. The first atom, if required, gives the characters a match starts with. An alternation
+	// at the top level requires nothing, and anything else not understood ends the reading.
+	regex_prefilter::regex_prefilter(const char* expression, std::regex_constants::syntax_option_type flags)
+	{
+		using namespace std::regex_constants;
 
-		if (str.length() == 0) return false;
+		const syntax_option_type grammar = flags & (ECMAScript | basic | extended | awk | grep | egrep);
+		const bool ecma = grammar == ECMAScript || grammar == syntax_option_type();
 
-		str.to_lower();
+		if (expression == nullptr || (flags & icase) || !(ecma || grammar == extended))
+			return;
 
-		if (str == "true" || str == "1")
-		{
-			result = true;
-			return true;
-		}
-		else if (str == "false" || str == "0")
+		// Any top-level alternative may match alone.
+		for (const char* p = expression; *p != '\0';)
 		{
-			result = false;
-			return true;
+			bool set[256] = { };
+			bool negated = false, read = false;
+
+			switch (*p)
+			{
+			case '\\': if (*++p == '\0') return; ++p; break;
+			case '[': p = prefilter_bracket(p + 1, ecma, set, negated, read); if (p == nullptr) return; break;
+			case '(': p = prefilter_group(p + 1, ecma); if (p == nullptr) return; break;
+			case '|': return;
+			default: ++p;
+			}
 		}
-		else return false;
-	}
 
-	bool string::to_bool() const
-	{
-		if (_null || trim().length() == 0) 
-			return false;
-		else if (is_boolean())
-		{
-			bool boolean = false;
+		std::string run;
+		bool first = true;
 
-			if (parse_boolean(boolean)) 
-				return boolean;
-			else return false;
-		}
-		else if (is_float())
+		for (const char* p = expression; *p != '\0';)
 		{
-			long double real = 0.0L;
+			bool set[256] = { };
+			bool negated = false, read = true;
+			int literal = -1;
 
-			if (parse_float(real))
+			switch (*p)
 			{
-				if (std::isnan(real)) 
-					return false;
-				else if (real == std::numeric_limits<long double>::infinity()) 
-					return true;
-				else if (real == -std::numeric_limits<long double>::infinity()) 
-					return false;
-				else return real > 0.0L;
+			case '\\':
+			{
+				const char c = p[1];
+
+				if (ecma && (c == 'd' || c == 'w' || c == 's'))
+				{
+					for (unsigned i = 1; i < 256; ++i)
+						set[i] = c == 'd' ? std::isdigit(int(i)) != 0 : c == 'w' ? (std::isalnum(int(i)) != 0 || i == '_') : std::isspace(int(i)) != 0;
+				}
+				else if (c != '\0' && std::ispunct((unsigned char)c))
+					literal = (unsigned char)c;
+				else if (ecma && c != '\0' && std::strchr("nrtfv", c) != nullptr)
+					literal = c == 'n' ? '\n' : c == 'r' ? '\r' : c == 't' ? '\t' : c == 'f' ? '\f' : '\v';
+				else p = nullptr; // Not read.
+
+				if (p != nullptr) p += 2;
+				break;
+			}
+			case '[': p = prefilter_bracket(p + 1, ecma, set, negated, read); break;
+			case '(': p = prefilter_group(p + 1, ecma); break;
+			case '.': case '^': case '$': ++p; break;
+			case ')': case '*': case '+': case '?': case '{': p = nullptr; break;
+			default: literal = (unsigned char)*p++;
 			}
-			else return false;
-		}
-		else if (is_integer())
-		{
-			unsigned long long integer = 0ULL;
-			bool negative = false;
 
-			if (parse_integer(integer, negative))
+			if (p == nullptr)
+				break;
+
+			bool optional = false, repeated = false;
+
+			switch (*p)
 			{
-				if (negative) 
-					return false;
-				else return integer > 0ULL;
+			case '*': optional = repeated = true; ++p; break;
+			case '+': repeated = true; ++p; break;
+			case '?': optional = true; ++p; break;
+			case '{':
+				repeated = true;
+				optional = p[1] == '0' || p[1] == ',';
+				p = std::strchr(p, '}');
+				if (p != nullptr) ++p;
+				break;
 			}
-			else return false;
-		}
-		else return trim().length() > 0;
-	}
 
-	// Attempts to parse this as a numeric type, and cast it to the specified type.
-	// Returns the parsed numeric value cast to type, if parsed, else one of the arguments.
-	// Result may be one of zero, one, minimum, maximum, or nan depending upon the conversion.
-	template <class T>
-	inline static T parse_cast(const string& value, T zero, T one, T minimum, T maximum, T nan)
-	{
-		if (value.is_empty())
-			return nan;
-		else if (value.is_boolean())
-		{
-			bool boolean = false;
+			if (p == nullptr)
+				break;
 
-			if (value.parse_boolean(boolean))
-				return boolean ? one : zero;
-			else return nan;
-		}
-		else if (value.is_float())
-		{
-			long double real = 0.0L;
+			if (ecma && (optional || repeated) && *p == '?') // Lazy.
+				++p;
 
-			if (value.parse_float(real))
+			if (*p == '*' || *p == '+' || *p == '?' || *p == '{') // Stacked, as in a+*, which may be empty.
+				break;
+
+			if (first)
 			{
-				if (std::is_floating_point<T>::value)
-					return static_cast<T>(real);
-				else
+				first = false;
+
+				if (!optional && !negated && read)
 				{
-					if (std::isnan(real))
-						return nan;
-					else if (real == std::numeric_limits<long double>::infinity())
-						return maximum;
-					else if (real == -std::numeric_limits<long double>::infinity())
-						return minimum;
-					else if (real < long double(minimum))
-						return minimum;
-					else if (real > long double(maximum))
-						return maximum;
-					else return static_cast<T>(real);
+					if (literal > 0) set[literal] = true;
+
+					std::string chars;
+
+					for (unsigned i = 1; i < 256; ++i)
+						if (set[i]) chars.push_back(char(i));
+
+					_first = char_set(chars.c_str());
 				}
 			}
-			else return nan;
-		}
-		else if (value.is_integer())
-		{
-			unsigned long long integer = 0ULL;
-			bool negative = false;
 
-			if (value.parse_integer(integer, negative))
+			if (literal >= 0 && !optional)
+			{
+				run.push_back(char(literal));
+
+				if (repeated)
+				{
+					if (run.length() > _literal.length()) _literal = run;
+					run.assign(1, char(literal));
+				}
+			}
+			else
 			{
-				if (!negative && integer > unsigned long long(maximum))
-					return maximum;
-				else if (negative && integer > unsigned long long(maximum))
-					return minimum;
-				else if (negative)
-					return -static_cast<T>(integer);
-				else return static_cast<T>(integer);
+				if (run.length() > _literal.length()) _literal = run;
+				run.clear();
 			}
-			else return nan;
 		}
-		else return nan;
-	}
 
-	char string::to_char() const
-	{
-		if (is_empty()) return '\0';
-		else return base_type::operator[](0);
+		if (run.length() > _literal.length()) _literal = run;
 	}
 
-	unsigned char string::to_byte() const { return parse_cast<unsigned char>(*this, 0, 1, 0, 0xFF, 0); }
-	short string::to_short() const { return parse_cast<short>(*this, 0, 1, SHRT_MIN, SHRT_MAX, 0); }
-	unsigned short string::to_ushort() const { return parse_cast<unsigned short>(*this, 0, 1, 0, USHRT_MAX, 0); }
-	int string::to_int() const { return parse_cast<int>(*this, 0, 1, INT_MIN, INT_MAX, 0); }
-	unsigned int string::to_uint() const { return parse_cast<unsigned int>(*this, 0U, 1U, 0U, UINT_MAX, 0U); }
-	long string::to_long() const { return parse_cast<long>(*this, 0L, 1L, LONG_MIN, LONG_MAX, 0L); }
-	unsigned long string::to_ulong() const { return parse_cast<unsigned long>(*this, 0UL, 1UL, 0UL, ULONG_MAX, 0UL); }
-	long long string::to_llong() const { return parse_cast<long long>(*this, 0LL, 1LL, LLONG_MIN, LLONG_MAX, 0LL); }
-	unsigned long long string::to_ullong() const { return parse_cast<unsigned long long>(*this, 0ULL, 1ULL, 0ULL, ULLONG_MAX, 0ULL); }
-	float string::to_float() const { return parse_cast<float>(*this, 0.0F, 1.0F, FLT_MIN, FLT_MAX, NAN); }
-	double string::to_double() const { return parse_cast<double>(*this, 0.0, 1.0, DBL_MIN, DBL_MAX, NAN); }
-	long double string::to_ldouble() const { return parse_cast<double>(*this, 0.0L, 1.0L, LDBL_MIN, LDBL_MAX, NAN); }
-
-	string& string::append(const std::string& value)
+	// Finds the first position in [first, last) at which a match can start, or last if none.
+	const char* regex_prefilter::candidate(const char* first, const char* last) const
 	{
-		base_type::append(value);
-		_null = false;
+		const char* start = _first.empty() ? first : _first.find(first, last);
 
-		return *this;
+		if (!_literal.empty() && start != last && find_literal(start, last, _literal.data(), _literal.length()) == last)
+			return last;
+
+		return start;
 	}
 
-	string string::append(const char* value) const
+	// A set of bytes, as a 256-bit table.
+	struct regex_dfa_bytes
 	{
-		string result = clone();
-
-		if (value == nullptr || !*value) 
-			return result;
+		uint64_t bits[4];
 
-		result.append(std::string(value));
-		result._null = false;
+		inline bool contains(unsigned char c) const { return ((bits[c >> 6] >> (c & 63)) & 1) != 0; }
+		inline void insert(unsigned char c) { bits[c >> 6] |= uint64_t(1) << (c & 63); }
+	};
 
-		return result;
-	}
+	// A node of an expression's syntax tree: a set of bytes, an anchor, the empty string, the
+	// concatenation or alternation of count children listed from first, or the single child
+	// repeated min to max times, where max is negative if unbounded.
+	struct regex_dfa_term
+	{
+		enum kind_type { bytes, bol, eol, empty, concat, alternate, repeat } kind;
+		int set;
+		int first;
+		int count;
+		int min;
+		int max;
+	};
 
-	string string::append(const std::string& value) const
+	// An NFA instruction: match a byte of set and go to out, go to both out and alternative,
+	// go to out if at the start (bol) or end (eol) of the input, or accept.
+	struct regex_dfa_inst
 	{
-		string result = clone();
-
-		result.append(value);
-		result._null = false;
+		enum op_type { bytes, split, bol, eol, match } op;
+		int out;
+		int alternative;
+		int set;
+	};
 
-		return result;
-	}
+	// The limits on an expression compiled for the DFA: the group nesting, and the NFA size,
+	// which bounded repeats multiply. Larger expressions are left to std::regex.
+	static const size_t regex_dfa_depth_limit_ = 128;
+	static const size_t regex_dfa_size_limit_ = 16384;
 
-	string& string::append(char value)
+	// Parses the extended syntax as libstdc++ does, into a syntax tree, failing on whatever
+	// the DFA does not support: collating elements, equivalence classes, unrecognized escapes,
+	// and anything std::regex would have rejected.
+	class regex_dfa_parser
 	{
-		if (is_empty() && value == '\0')
-		{
-			_null = false;
+	public:
 
-			return *this;
-		}
+		std::vector<regex_dfa_term> terms;
+		std::vector<int> children;
+		std::vector<regex_dfa_bytes> sets;
 
-		base_type::push_back(value);
+	private:
 
-		return *this;
-	}
+		const std::ctype<char>& _ctype;
+		const char* _p;
+		bool _icase;
+		size_t _depth;
 
-	string string::append(char value) const
-	{
-		string result = clone();
+	public:
 
-		if (result.is_empty() && value == '\0')
+		regex_dfa_parser(const char* expression, bool icase)
+			: _ctype(std::use_facet<std::ctype<char>>(std::locale())), _p(expression), _icase(icase), _depth(0)
 		{
-			result._null = false;
+		}
 
-			return result;
+		// Parses the whole expression, returning its root term, or -1 if unsupported.
+		int parse()
+		{
+			int result = alternation();
+
+			return result >= 0 && *_p == '\0' ? result : -1;
 		}
 
-		result.push_back(value);
+	private:
 
-		return result;
-	}
+		int add(regex_dfa_term::kind_type kind, int set = -1, int min = 0, int max = 0)
+		{
+			regex_dfa_term term = { kind, set, 0, 0, min, max };
+			terms.push_back(term);
+			return int(terms.size() - 1);
+		}
 
-	string& string::prepend(const char* value)
-	{
-		if (value == nullptr || !*value)
-			return *this;
+		// Adds a concatenation or alternation of items, or the single item itself.
+		int add(regex_dfa_term::kind_type kind, const std::vector<int>& items)
+		{
+			if (items.size() == 1)
+				return items[0];
 
-		base_type::insert(0, value);
-		_null = false;
+			int result = add(kind);
+			terms[result].first = int(children.size());
+			terms[result].count = int(items.size());
+			children.insert(children.end(), items.begin(), items.end());
+			return result;
+		}
 
-		return *this;
-	}
+		// Adds a set of the bytes for which test is true.
+		template <typename Test>
+		int add_set(Test test)
+		{
+			regex_dfa_bytes set = { { 0, 0, 0, 0 } };
 
-	string& string::prepend(const std::string& value)
-	{
-		base_type::insert(0, value);
-		_null = false;
+			for (int c = 0; c < 256; ++c)
+			{
+				if (test(char(c)))
+					set.insert((unsigned char)c);
+			}
 
-		return *this;
-	}
+			sets.push_back(set);
+			return add(regex_dfa_term::bytes, int(sets.size() - 1));
+		}
 
-	string string::prepend(const char* value) const
-	{
-		string result = clone();
+		inline char translate(char c) const { return _icase ? _ctype.tolower(c) : c; }
 
-		if (value == nullptr || !*value)
-			return result;
+		// alternation: branch ('|' branch)*
+		int alternation()
+		{
+			if (++_depth > regex_dfa_depth_limit_)
+				return -1;
 
-		result.insert(0, value);
-		result._null = false;
+			std::vector<int> items;
 
-		return result;
-	}
+			for (;;)
+			{
+				int item = branch();
 
-	string string::prepend(const std::string& value) const
-	{
-		string result = clone();
+				if (item < 0)
+					return -1;
 
-		result.insert(0, value);
-		result._null = false;
+				items.push_back(item);
 
-		return result;
-	}
+				if (*_p != '|')
+					break;
 
-	string& string::prepend(char value)
-	{
-		if (is_empty() && value == '\0')
-		{
-			_null = false;
-			return *this;
+				++_p;
+			}
+
+			--_depth;
+			return add(regex_dfa_term::alternate, items);
 		}
 
-		base_type::insert(0, 1, value);
-		_null = false;
+		// branch: ('^' | '$' | atom quantifier*)*
+		int branch()
+		{
+			std::vector<int> items;
 
-		return *this;
-	}
+			for (char c = *_p; c != '\0' && c != '|' && c != ')'; c = *_p)
+			{
+				int item;
 
-	string string::prepend(char value) const
-	{
-		string result = clone();
+				if (c == '^' || c == '$')
+				{
+					++_p;
+					item = add(c == '^' ? regex_dfa_term::bol : regex_dfa_term::eol);
+				}
+				else
+				{
+					item = atom();
 
-		if (result.is_empty() && value == '\0')
-		{
-			result._null = false;
-			return result;
-		}
+					while (item >= 0 && (*_p == '*' || *_p == '+' || *_p == '?' || *_p == '{'))
+						item = quantifier(item);
 
-		result.insert(0, 1, value);
-		result._null = false;
+					if (item < 0)
+						return -1;
+				}
 
-		return result;
-	}
+				items.push_back(item);
+			}
 
-#if defined(_MSC_VER)
-#pragma intrinsic(_rotl64)
-#define rotl_64(a, n) _rotl64((a), n)
-#else
-#if defined(__clang__)
-#define rotl_64(a, n) __builtin_rotateleft64((a), n)
-#elif defined(__x86_64__)
-#define rotl_64(a, n) ({ u64 r; asm("rolq %1,%0" : "=r"(r) : "J"(n),"0"(a) : "cc"); r; })
-#else
-#define rotl_64(a, n) (((x) << (r)) | ((x) >> (64 - (r))))
-#endif
-#endif
+			return items.empty() ? add(regex_dfa_term::empty) : add(regex_dfa_term::concat, items);
+		}
 
-	inline static uint64_t fmix_64(uint64_t k)
-	{
-		k ^= k >> 33;
-		k *= UINT64_C(0xFF51AFD7ED558CCD);
-		k ^= k >> 33;
-		k *= UINT64_C(0xC4CEB9FE1A85EC53);
-		k ^= k >> 33;
+		int atom()
+		{
+			char c = *_p++;
 
-		return k;
-	}
+			switch (c)
+			{
+			case '(':
+			{
+				int result = alternation();
 
-	// The following is derived from MurmurHash3 written by Austin Appleby, and is placed in the public domain. 
-	// Austin Appleby disclaims copyright to this source code.
-	inline static void murmur3_x64_128(const void* value, const size_t bytes, const uint64_t seed, uint64_t* result)
-	{
-		const uint8_t* data = (const uint8_t*)value;
-		const size_t blocks = bytes / UINT64_C(16);
+				if (result < 0 || *_p != ')')
+					return -1;
 
-		uint64_t h1 = seed;
-		uint64_t h2 = seed;
+				++_p;
+				return result;
+			}
+			case '.':
+			{
+				const char null = translate('\0');
+				return add_set([&](char x) { return translate(x) != null; });
+			}
+			case '[':
+				return bracket();
+			case '\\':
+				c = *_p++;
 
-		const uint64_t c1 = UINT64_C(0x87C37B91114253D5);
-		const uint64_t c2 = UINT64_C(0x4CF5AD432745937F);
-		const uint64_t* block = (const uint64_t*)data;
+				if (c == '\0' || std::strchr(".[\\()*+?{|^$", c) == nullptr)
+					return -1;
 
-		for (size_t i = 0; i < blocks; ++i)
-		{
-			uint64_t k1 = block[i * 2 + 0];
-			uint64_t k2 = block[i * 2 + 1];
+				break;
+			case '*': case '+': case '?': case '{':
+				return -1;
+			}
 
-			k1 *= c1; k1 = rotl_64(k1, 31); k1 *= c2; h1 ^= k1;
-			h1 = rotl_64(h1, 27); h1 += h2; h1 = h1 * UINT64_C(5) + UINT64_C(0x52DCE729);
-			k2 *= c2; k2 = rotl_64(k2, 33); k2 *= c1; h2 ^= k2;
-			h2 = rotl_64(h2, 31); h2 += h1; h2 = h2 * UINT64_C(5) + UINT64_C(0x38495AB5);
+			const char value = translate(c);
+			return add_set([&](char x) { return translate(x) == value; });
 		}
 
-		const uint8_t* tail = (const uint8_t*)(data + blocks * 16);
+		// Applies the quantifier at _p to item, or returns -1 if it is malformed.
+		int quantifier(int item)
+		{
+			int min = 0;
+			int max = -1;
 
-		uint64_t k1 = UINT64_C(0);
-		uint64_t k2 = UINT64_C(0);
+			switch (*_p++)
+			{
+			case '+': min = 1; break;
+			case '?': max = 1; break;
+			case '{':
+				if (!count(min))
+					return -1;
 
-		switch (bytes & 15)
-		{
-		case 15: k2 ^= ((uint64_t)tail[14]) << 48;
-		case 14: k2 ^= ((uint64_t)tail[13]) << 40;
-		case 13: k2 ^= ((uint64_t)tail[12]) << 32;
-		case 12: k2 ^= ((uint64_t)tail[11]) << 24;
-		case 11: k2 ^= ((uint64_t)tail[10]) << 16;
-		case 10: k2 ^= ((uint64_t)tail[ 9]) <<  8;
-		case  9: k2 ^= ((uint64_t)tail[ 8]) <<  0;
+				max = min;
 
-			k2 *= c2; 
-			k2 = rotl_64(k2, 33); 
-			k2 *= c1; 
-			h2 ^= k2;
+				if (*_p == ',')
+				{
+					++_p;
+					max = -1;
 
-		case  8: k1 ^= ((uint64_t)tail[7]) << 56;
-		case  7: k1 ^= ((uint64_t)tail[6]) << 48;
-		case  6: k1 ^= ((uint64_t)tail[5]) << 40;
-		case  5: k1 ^= ((uint64_t)tail[4]) << 32;
-		case  4: k1 ^= ((uint64_t)tail[3]) << 24;
-		case  3: k1 ^= ((uint64_t)tail[2]) << 16;
-		case  2: k1 ^= ((uint64_t)tail[1]) <<  8;
-		case  1: k1 ^= ((uint64_t)tail[0]) <<  0;
+					if (*_p != '}' && !count(max))
+						return -1;
+				}
 
-			k1 *= c1; 
-			k1 = rotl_64(k1, 31); 
-			k1 *= c2; 
-			h1 ^= k1;
+				if (*_p++ != '}' || (max >= 0 && max < min))
+					return -1;
+			}
+
+			int result = add(regex_dfa_term::repeat, -1, min, max);
+			terms[result].first = int(children.size());
+			terms[result].count = 1;
+			children.push_back(item);
+			return result;
 		}
 
-		h1 ^= bytes;
-		h2 ^= bytes;
+		// Reads a repeat count, bounded by the NFA size limit.
+		bool count(int& value)
+		{
+			if (!_ctype.is(std::ctype_base::digit, *_p))
+				return false;
 
-		h1 += h2;
-		h2 += h1;
+			for (value = 0; _ctype.is(std::ctype_base::digit, *_p); ++_p)
+			{
+				value = value * 10 + (*_p - '0');
 
-		h1 = fmix_64(h1);
-		h2 = fmix_64(h2);
+				if (size_t(value) > regex_dfa_size_limit_)
+					return false;
+			}
 
-		h1 += h2;
-		h2 += h1;
+			return true;
+		}
 
-		result[0] = h1;
-		result[1] = h2;
-	}
+		// A token of a bracket expression.
+		enum bracket_token { token_char, token_dash, token_end, token_class, token_error };
 
-	// Computes a 64-bit hash code using the Murmur3 method, with the optional seed.
-	// Returns the specified qword part of the 128-bit result.
-	unsigned long long string::hash_code(hash_code_part part /*= hash_code_part::low*/, unsigned long long seed /*= 0*/) const
-	{
-		if (_null) // Special case 1.
-			return 0ULL;
+		// Scans the next token of a bracket expression, as libstdc++ does for extended syntax,
+		// where a backslash is an ordinary character, and ] is one if first.
+		bracket_token scan(bool& start, char& value, std::ctype_base::mask& mask, bool& word)
+		{
+			char c = *_p++;
+			bool first = start;
 
-		size_t n = base_type::length();
+			start = false;
 
-		if (n == 0) // Special case 2.
-			return ~0ULL;
+			if (c == '\0')
+				return token_error;
 
-		uint64_t result[2] = { 0, 0 };
+			if (c == '-')
+				return token_dash;
 
-		murmur3_x64_128(base_type::c_str(), n * sizeof(char), seed, result);
+			if (c == ']' && !first)
+				return token_end;
 
-		if (part == hash_code_part::both)
-			return result[0] ^ result[1];
-		else if (part == hash_code_part::high)
-			return result[1];
-		else if (part == hash_code_part::low)
-			return result[0];
-		else return result[0];
-	}
+			if (c == '[' && *_p == ':')
+			{
+				const char* name = ++_p;
 
-	// Formats to the specified buffer. Must be freed using free().
-	static bool do_format(char** result, const char* format, va_list ap)
-	{
-		if (format == nullptr || result == nullptr)
-			return false;
+				while (*_p != '\0' && !(_p[0] == ':' && _p[1] == ']'))
+					++_p;
 
-		*result = nullptr;
+				if (*_p == '\0')
+					return token_error;
 
-		size_t size = std::strlen(format);
-		char* buffer = (char*)std::malloc(size * 2);
+				std::string lower;
 
-		if (buffer == nullptr)
-			return false;
+				for (; name != _p; ++name)
+					lower.push_back(_ctype.tolower(*name));
 
-		buffer[0] = '\0';
+				_p += 2;
+				return class_mask(lower, mask, word) ? token_class : token_error;
+			}
 
-		va_list tp = ap;
-		int need = vsnprintf(buffer, size, format, tp);
+			if (c == '[' && (*_p == '.' || *_p == '='))
+				return token_error;
 
-		if (need < 0)
+			value = c;
+			return token_char;
+		}
+
+		// Looks up a character class by name, as regex_traits::lookup_classname does.
+		bool class_mask(const std::string& name, std::ctype_base::mask& mask, bool& word) const
 		{
-			std::free(buffer);
+			static const struct { const char* name; std::ctype_base::mask mask; } names[] =
+			{
+				{ "d", std::ctype_base::digit }, { "w", std::ctype_base::alnum }, { "s", std::ctype_base::space },
+				{ "alnum", std::ctype_base::alnum }, { "alpha", std::ctype_base::alpha }, { "blank", std::ctype_base::blank },
+				{ "cntrl", std::ctype_base::cntrl }, { "digit", std::ctype_base::digit }, { "graph", std::ctype_base::graph },
+				{ "lower", std::ctype_base::lower }, { "print", std::ctype_base::print }, { "punct", std::ctype_base::punct },
+				{ "space", std::ctype_base::space }, { "upper", std::ctype_base::upper }, { "xdigit", std::ctype_base::xdigit }
+			};
+
+			for (const auto& entry : names)
+			{
+				if (name == entry.name)
+				{
+					mask = entry.mask;
+					word = name == "w";
+
+					if (_icase && (mask == std::ctype_base::lower || mask == std::ctype_base::upper))
+						mask = std::ctype_base::alpha;
+
+					return true;
+				}
+			}
+
 			return false;
 		}
-		else if (need > size)
+
+		// Parses a bracket expression after its [, following the libstdc++ rules for where a -
+		// may appear in POSIX syntax.
+		int bracket()
 		{
-			size = need + 1;
-			char* temp = (char*)std::realloc(buffer, size);
+			struct range { char first; char last; };
 
-			if (temp == nullptr)
-			{
-				std::free(buffer);
-				return false;
-			}
-			else buffer = temp;
+			const bool negated = *_p == '^';
+			std::string chars;
+			std::vector<range> ranges;
+			std::vector<std::pair<std::ctype_base::mask, bool>> classes;
 
-			buffer[0] = '\0';
+			if (negated)
+				++_p;
 
-			tp = ap;
-			need = vsnprintf(buffer, size, format, tp);
+			enum { none, single, set } last = none;
+			char previous = '\0';
+			bool start = true;
+			char value;
+			std::ctype_base::mask mask;
+			bool word;
 
-			if (need < 0)
+			for (bool first = true;; first = false)
 			{
-				std::free(buffer);
-				return false;
-			}
-		}
+				bracket_token token = scan(start, value, mask, word);
 
-		*result = buffer;
+				if (token == token_error)
+					return -1;
 
-		return true;
-	}
+				if (first && token == token_dash)
+				{
+					token = token_char;
+					value = '-';
+				}
 
-	// Formats and appends to this using the specified format string, and optional arguments.
-	// Returns true if the operation succeeded, else false.
-	bool string::append(const char* format, ...)
-	{
-		va_list ap;
-		va_start(ap, format);
-		char* buffer = nullptr;
-		bool succeeded = do_format(&buffer, format, ap);
-		va_end(ap);
+				if (token == token_end)
+					break;
 
-		if (succeeded && buffer != nullptr)
-		{
-			base_type::append(buffer);
-			std::free(buffer);
+				if (token == token_class)
+				{
+					if (last == single)
+						chars.push_back(previous);
 
-			return true;
-		}
-		else return false;
-	}
+					classes.emplace_back(mask, word);
+					last = set;
+				}
+				else if (token == token_char)
+				{
+					if (last == single)
+						chars.push_back(previous);
 
-	// Attempts to format this using the specified format string, and optional arguments.
-	// Returns true if the operation succeeded, else false.
-	bool string::format(const char* format, ...)
-	{
-		va_list ap;
-		va_start(ap, format);
-		char* buffer = nullptr;
-		bool succeeded = do_format(&buffer, format, ap);
-		va_end(ap);
+					previous = value;
+					last = single;
+				}
+				else
+				{
+					token = scan(start, value, mask, word);
 
-		if (succeeded && buffer != nullptr)
-		{
-			base_type::operator=(buffer);
-			std::free(buffer);
+					if (token == token_end)
+					{
+						if (last == single)
+							chars.push_back(previous);
 
-			return true;
-		}
-		else return false;
-	}
+						previous = '-';
+						last = single;
+						break;
+					}
 
-	string& string::append(bool value)
-	{
-		static const char* true_str = "true";
-		static const char* false_str = "false";
-		base_type::append(value ? true_str : false_str);
-		return *this;
-	}
+					if (last != single || (token != token_char && token != token_dash))
+						return -1;
 
-	string& string::append(unsigned char value)
-	{
-		char buffer[4] = { '\0' };
-		snprintf(buffer, 4, "%u", value);
-		base_type::append(buffer);
-		return *this;
-	}
+					if (token == token_dash)
+						value = '-';
 
-	string& string::append(short value)
-	{
-		char buffer[8] = { '\0' };
-		snprintf(buffer, 8, "%d", value);
-		base_type::append(buffer);
-		return *this;
-	}
+					if (previous > value)
+						return -1;
 
-	string& string::append(unsigned short value)
-	{
-		char buffer[8] = { '\0' };
-		snprintf(buffer, 8, "%u", value);
-		base_type::append(buffer);
-		return *this;
-	}
+					ranges.push_back({ previous, value });
+					last = none;
+				}
+			}
 
-	string& string::append(int value)
-	{
-		char buffer[16] = { '\0' };
-		snprintf(buffer, 16, "%d", value);
-		base_type::append(buffer);
-		return *this;
-	}
+			if (last == single)
+				chars.push_back(previous);
 
-	string& string::append(unsigned int value)
-	{
-		char buffer[16] = { '\0' };
-		snprintf(buffer, 16, "%u", value);
-		base_type::append(buffer);
-		return *this;
-	}
+			for (char& c : chars)
+				c = translate(c);
 
-	string& string::append(long value)
-	{
-		char buffer[16] = { '\0' };
-		snprintf(buffer, 16, "%ld", value);
-		base_type::append(buffer);
-		return *this;
-	}
+			return add_set([&](char x)
+			{
+				bool found = chars.find(translate(x)) != std::string::npos;
 
-	string& string::append(unsigned long value)
-	{
-		char buffer[16] = { '\0' };
-		snprintf(buffer, 16, "%lu", value);
-		base_type::append(buffer);
-		return *this;
-	}
+				for (size_t i = 0; !found && i < ranges.size(); ++i)
+				{
+					const range& r = ranges[i];
 
-	string& string::append(long long value)
-	{
-		char buffer[32] = { '\0' };
-		snprintf(buffer, 32, "%lld", value);
-		base_type::append(buffer);
-		return *this;
-	}
+					if (_icase)
+					{
+						const char lower = _ctype.tolower(x);
+						const char upper = _ctype.toupper(x);
 
-	string& string::append(unsigned long long value)
-	{
-		char buffer[32] = { '\0' };
-		snprintf(buffer, 32, "%llu", value);
-		base_type::append(buffer);
-		return *this;
-	}
+						found = (r.first <= lower && lower <= r.last) || (r.first <= upper && upper <= r.last);
+					}
+					else found = r.first <= x && x <= r.last;
+				}
 
-	string& string::append(float value)
-	{
-		char buffer[32] = { '\0' };
-		snprintf(buffer, 32, "%f", value);
-		base_type::append(buffer);
-		return *this;
-	}
+				for (size_t i = 0; !found && i < classes.size(); ++i)
+					found = _ctype.is(classes[i].first, x) || (classes[i].second && x == '_');
 
-	string& string::append(double value)
-	{
-		char buffer[32] = { '\0' };
-		snprintf(buffer, 32, "%lf", value);
-		base_type::append(buffer);
-		return *this;
-	}
+				return found != negated;
+			});
+		}
+	};
 
-	string& string::append(long double value)
+	// Compiles a syntax tree into NFA instructions, forward or reversed, where the reversed NFA
+	// matches the reversed strings, with the anchors swapped.
+	class regex_dfa_compiler
 	{
-		char buffer[32] = { '\0' };
-		snprintf(buffer, 32, "%llf", value);
-		base_type::append(buffer);
-		return *this;
-	}
+	private:
 
-	// Appends count generated characters to this by calling the specified method count times, 
-	// unless method returns '\0', in which case it stops.
-	// Returns this after the generation completes.
-	string& string::generate(size_t count, char (*method)(size_t index))
-	{
-		if (method == nullptr)
-			return *this;
+		const regex_dfa_parser& _tree;
+		std::vector<regex_dfa_inst>& _code;
+		bool _reverse;
+		size_t _budget;
 
-		base_type::clear();
+	public:
 
-		for (size_t i = 0; i < count; ++i)
+		regex_dfa_compiler(const regex_dfa_parser& tree, std::vector<regex_dfa_inst>& code, bool reverse)
+			: _tree(tree), _code(code), _reverse(reverse), _budget(regex_dfa_size_limit_)
 		{
-			char c = method(i);
+		}
 
-			if (c == '\0')
-				return *this;
+		// Compiles term to continue at next, returning its entry, or -1 if over the size limit.
+		int compile(int term, int next)
+		{
+			if (next < 0 || _budget == 0 || _code.size() > regex_dfa_size_limit_)
+				return -1;
 
-			append(c);
-		}
+			--_budget;
 
-		return *this;
-	}
+			const regex_dfa_term& t = _tree.terms[size_t(term)];
+			const int* items = _tree.children.data() + t.first;
 
-	// Takes the left-hand count of characters as a substring.
-	string string::left(size_t count) const
-	{ 
-		size_t n = base_type::length();
+			switch (t.kind)
+			{
+			case regex_dfa_term::bytes: return emit(regex_dfa_inst::bytes, next, -1, t.set);
+			case regex_dfa_term::bol: return emit(_reverse ? regex_dfa_inst::eol : regex_dfa_inst::bol, next);
+			case regex_dfa_term::eol: return emit(_reverse ? regex_dfa_inst::bol : regex_dfa_inst::eol, next);
+			case regex_dfa_term::empty: return next;
+			case regex_dfa_term::concat:
+				for (int i = 0; i < t.count; ++i)
+					next = compile(items[_reverse ? i : t.count - 1 - i], next);
+
+				return next;
+			case regex_dfa_term::alternate:
+			{
+				int result = compile(items[0], next);
 
-		if (_null || n == 0 || count == 0) 
-			return string();
+				for (int i = 1; i < t.count && result >= 0; ++i)
+				{
+					int entry = compile(items[i], next);
+					result = entry < 0 ? -1 : emit(regex_dfa_inst::split, result, entry);
+				}
 
-		if (count > n) count = n;
+				return result;
+			}
+			case regex_dfa_term::repeat:
+			{
+				const int item = items[0];
 
-		return string(base_type::substr(0, count));
-	}
+				if (t.max < 0)
+				{
+					int loop = emit(regex_dfa_inst::split, -1, next);
+					int entry = compile(item, loop);
 
-	// Takes the right-hand count of characters as a substring.
-	string string::right(size_t count) const
-	{
-		size_t n = base_type::length();
+					if (entry < 0)
+						return -1;
 
-		if (_null || n == 0 || count == 0) 
-			return string();
+					_code[size_t(loop)].out = entry;
+					next = loop;
+				}
+				else
+				{
+					const int exit = next;
 
-		if (count > n) count = n;
+					for (int i = t.min; i < t.max && next >= 0; ++i)
+					{
+						int entry = compile(item, next);
+						next = entry < 0 ? -1 : emit(regex_dfa_inst::split, entry, exit);
+					}
+				}
 
-		size_t start = n - count;
+				for (int i = 0; i < t.min && next >= 0; ++i)
+					next = compile(item, next);
 
-		return string(base_type::substr(start, count));
-	}
+				return next;
+			}
+			}
 
-	std::vector<uint8_t> string::get_bytes() const
-	{
-		if (is_empty())
-			return std::vector<uint8_t>();
+			return -1;
+		}
 
-		const uint8_t m = 0xFF;
+	private:
 
-		std::vector<uint8_t> result;
+		int emit(regex_dfa_inst::op_type op, int out, int alternative = -1, int set = -1)
+		{
+			regex_dfa_inst inst = { op, out, alternative, set };
+			_code.push_back(inst);
+			return int(_code.size() - 1);
+		}
+	};
 
-		for (char c : *this)
-			result.push_back(uint8_t(c & m));
-		
-		return result;
-	}
+	// The automata a search runs: forward from a start, adding the start at each position, to
+	// find whether any match ends; forward from a fixed start, for the longest match; in reverse
+	// from the end, adding the start at each position, to find where matches begin; and forward
+	// from a fixed start, keeping the instructions in the order a backtracking search tries them,
+	// for the match it finds first.
+	enum regex_dfa_kind { regex_dfa_search, regex_dfa_longest, regex_dfa_reverse, regex_dfa_first, regex_dfa_kinds };
 
-	// Returns whether this matches the regular expression, using the flags:
-	// std::regex_constants::extended | std::regex_constants::nosubs.
-	// If caseless is true, or C++17 and multiline is true, adds these flags
-	// as well.
-	bool string::match(const char* expression, bool caseless /*= false*/
-#if __cplusplus > 201402L
-		, bool multiline /*= false*/
-#endif
-	) const
+	// The flags of a DFA state.
+	enum regex_dfa_flag : unsigned char
 	{
-		if (expression == nullptr || is_empty())
-			return false;
+		regex_dfa_accept = 1, // Contains the match instruction.
+		regex_dfa_accept_eol = 2, // Accepts at the end of the input.
+		regex_dfa_dead = 4 // Contains no instructions, so can never accept.
+	};
 
-		auto flags = std::regex_constants::extended;
+	// The states built so far for one automaton. A state is the sorted set of NFA instructions
+	// that consume a byte, accept, or wait for the end of the input. Transitions are indexed by
+	// state and byte class, and are -1 until first taken.
+	struct regex_dfa_automaton
+	{
+		std::unordered_map<std::string, int> index;
+		std::vector<std::vector<int>> states;
+		std::vector<unsigned char> flags;
+		std::vector<int> next;
+		int starts[4];
+		size_t flushes;
 
-		if (caseless) flags |= std::regex_constants::icase;
+		regex_dfa_automaton() : flushes(0) { std::fill(starts, starts + 4, -1); }
 
-#if __cplusplus > 201402L
-		if (multiline) flags |= std::regex_constants::multiline;
-#endif
-		
-		std::regex regex(expression, flags);
+		void flush()
+		{
+			index.clear();
+			states.clear();
+			flags.clear();
+			next.clear();
+			std::fill(starts, starts + 4, -1);
+			++flushes;
+		}
+	};
 
-		return std::regex_search(*this, regex);
-	}
+	// The NFA of an expression, forward and reversed, and its byte classes: bytes which every
+	// set either contains or not alike share a class, and so a column of the transitions.
+	struct regex_dfa::program
+	{
+		std::vector<regex_dfa_bytes> sets;
+		std::vector<regex_dfa_inst> code[2];
+		int start[2];
+		unsigned char classes[256];
+		size_t class_count;
 
-	// Matches the expression like in match above, and returns all of the matches, 
-	// or an empty vector if no matches or is_empty.
-	std::vector<string> string::match_all(const char* expression, bool caseless /*= false*/
-#if __cplusplus > 201402L
-		, bool multiline /*= false*/
-#endif
-	) const
+		// Caches not in use by a search.
+		std::mutex mutex;
+		std::vector<std::unique_ptr<cache>> pool;
+	};
+
+	// The states of the automata, and the scratch space to build new ones.
+	struct regex_dfa::cache
 	{
-		std::vector<string> result;
+		regex_dfa_automaton automata[regex_dfa_kinds];
+		std::vector<unsigned> marks;
+		unsigned generation;
+		std::vector<int> stack;
+		std::vector<int> seeds;
+		std::vector<int> list;
+		std::vector<int> closed;
 
-		if (expression == nullptr || is_empty())
-			return result;
+		cache() : generation(0) { }
+	};
 
-		auto flags = std::regex_constants::extended;
+	// Runs one automaton of a program, over a cache taken from the program's pool for the
+	// duration of a search, so that concurrent searches each build states in their own.
+	class regex_dfa::runner
+	{
+	private:
 
-		if (caseless) flags |= std::regex_constants::icase;
+		program& _program;
+		std::unique_ptr<cache> _owned;
+		cache& _cache;
+		regex_dfa_automaton& _automaton;
+		const std::vector<regex_dfa_inst>& _code;
+		const int _start;
+		const bool _unanchored;
+		const bool _ordered;
 
-#if __cplusplus > 201402L
-		if (multiline) flags |= std::regex_constants::multiline;
-#endif
+		static std::unique_ptr<cache> take(program& from)
+		{
+			std::lock_guard<std::mutex> lock(from.mutex);
+
+			if (from.pool.empty())
+				return std::unique_ptr<cache>(new cache());
+
+			std::unique_ptr<cache> result = std::move(from.pool.back());
+			from.pool.pop_back();
+			return result;
+		}
 
-		std::regex regex(expression, flags);
+	public:
+
+		runner(program& owner, regex_dfa_kind kind)
+			: _program(owner), _owned(take(owner)), _cache(*_owned), _automaton(_cache.automata[kind]),
+			_code(owner.code[kind == regex_dfa_reverse ? 1 : 0]), _start(owner.start[kind == regex_dfa_reverse ? 1 : 0]),
+			_unanchored(kind != regex_dfa_longest && kind != regex_dfa_first), _ordered(kind == regex_dfa_first)
+		{
+		}
 
-		auto begin = std::sregex_iterator(base_type::begin(), base_type::end(), regex);
-		auto end = std::sregex_iterator();
+		~runner()
+		{
+			std::lock_guard<std::mutex> lock(_program.mutex);
+			_program.pool.push_back(std::move(_owned));
+		}
 
-		if (std::distance(begin, end) > 0)
+		// Gets the start state, where bol and eol tell whether the start is at either end.
+		int start(bool bol, bool eol)
 		{
-			for (auto i = begin; i != end; ++i)
+			int& state = _automaton.starts[(bol ? 2 : 0) + (eol ? 1 : 0)];
+
+			if (state < 0)
 			{
-				auto m = *i;
+				_cache.seeds.assign(1, _start);
+				closure(bol, eol, _cache.list);
 
-				result.push_back(string(m.str()));
+				const int result = intern(_cache.list);
+				_automaton.starts[(bol ? 2 : 0) + (eol ? 1 : 0)] = result;
+				return result;
 			}
+
+			return state;
 		}
 
-		return result;
-	}
+		// Gets the start state without the match instruction, for a search which must not match
+		// empty there, so that the instructions after it are kept rather than cut.
+		int start_not_null(bool bol, bool eol)
+		{
+			_cache.seeds.assign(1, _start);
+			closure(bol, eol, _cache.list, false);
+			_cache.list.erase(std::remove_if(_cache.list.begin(), _cache.list.end(), [this](int i) { return _code[size_t(i)].op == regex_dfa_inst::match; }), _cache.list.end());
 
-	// Computes the total length of an escaped string.
-	inline static size_t escaped_length(const string& value)
-	{
-		size_t result = 0;
+			return intern(_cache.list);
+		}
 
-		for (const auto& ch : value)
+		inline unsigned char flags(int state) const { return _automaton.flags[size_t(state)]; }
+
+		// Gets the state of this automaton with the instructions of state in other.
+		inline int adopt(const runner& other, int state) { return intern(other._automaton.states[size_t(state)]); }
+
+		// Gets the state after state consumes c, building it on first use.
+		inline int step(int state, unsigned char c)
 		{
-			switch (ch)
-			{
-			case '"': case '\\': case '\b': case '\f': case '\n': case '\r': case '\t': 
-				result += 2; break;
-			default:
-				result++;
-				if (ch <= 0x1F && ch >= 0x00) 
-					result += 5;
-				break;
-			}
+			const size_t at = size_t(state) * _program.class_count + _program.classes[c];
+			const int result = _automaton.next[at];
+
+			return result >= 0 ? result : build(state, c, at);
 		}
 
-		return result;
-	}
+	private:
 
-	// Escapes this string using C-style or JSON escape sequences. Return *this.
-	inline static string escape_json(string& value)
-	{
-		size_t n = value.length();
+		int build(int state, unsigned char c, size_t at)
+		{
+			_cache.seeds.clear();
 
-		if (n == 0) return string(value);
+			for (int i : _automaton.states[size_t(state)])
+			{
+				const regex_dfa_inst& inst = _code[size_t(i)];
 
-		const size_t size = escaped_length(value);
+				if (inst.op == regex_dfa_inst::bytes && _program.sets[size_t(inst.set)].contains(c))
+					_cache.seeds.push_back(inst.out);
+			}
 
-		if (size == n) return string(value);
+			if (_unanchored)
+				_cache.seeds.push_back(_start);
 
-		size_t i = 0;
-		string result(size, '\\');
+			closure(false, false, _cache.list);
 
-		for (const auto& c : value)
+			const size_t flushes = _automaton.flushes;
+			const int result = intern(_cache.list);
+
+			if (_automaton.flushes == flushes)
+				_automaton.next[at] = result;
+
+			return result;
+		}
+
+		// Follows the jumps from the seeds, passing the anchors where bol or eol hold, into result.
+		// Unmet eol anchors are kept, as the end may yet come; unmet bol anchors are dropped, as
+		// the start never comes again. If ordered, result keeps the order the seeds and jumps are
+		// tried in, and if cut, ends at the first match, as what follows is tried only if it fails.
+		void closure(bool bol, bool eol, std::vector<int>& result, bool cut = true)
 		{
-			switch (c)
+			if (_cache.marks.size() < _code.size())
+				_cache.marks.resize(_code.size(), 0);
+
+			if (++_cache.generation == 0)
 			{
-			case  '"': result[i++] = '"'; i++; break;
-			case '\\': i += 2; break;
-			case '\b': result[i++] = 'b'; i++; break;
-			case '\f': result[i++] = 'f'; i++; break;
-			case '\n': result[i++] = 'n'; i++; break;
-			case '\r': result[i++] = 'r'; i++; break;
-			case '\t': result[i++] = 't'; i++; break;
-			default:
-				if (c >= 0x00 && c <= 0x1F)
+				std::fill(_cache.marks.begin(), _cache.marks.end(), 0);
+				_cache.generation = 1;
+			}
+
+			result.clear();
+			_cache.stack.assign(_cache.seeds.rbegin(), _cache.seeds.rend());
+
+			while (!_cache.stack.empty())
+			{
+				const int i = _cache.stack.back();
+				_cache.stack.pop_back();
+
+				if (_cache.marks[size_t(i)] == _cache.generation)
+					continue;
+
+				_cache.marks[size_t(i)] = _cache.generation;
+
+				const regex_dfa_inst& inst = _code[size_t(i)];
+
+				switch (inst.op)
 				{
-					snprintf(&result[i + 1], 6, "u%04X", int(c));
-					i += 6;
-					result[i] = '\\';
+				case regex_dfa_inst::bytes:
+					result.push_back(i);
+					break;
+				case regex_dfa_inst::match:
+					result.push_back(i);
+
+					if (_ordered && cut)
+						_cache.stack.clear();
+
+					break;
+				case regex_dfa_inst::split:
+					_cache.stack.push_back(inst.alternative);
+					_cache.stack.push_back(inst.out);
+					break;
+				case regex_dfa_inst::bol:
+					if (bol) _cache.stack.push_back(inst.out);
+					break;
+				case regex_dfa_inst::eol:
+					if (eol) _cache.stack.push_back(inst.out);
+					else result.push_back(i);
+					break;
 				}
-				else result[i++] = c;
-				break;
 			}
+
+			if (!_ordered)
+				std::sort(result.begin(), result.end());
 		}
 
-		return result;
-	}
+		// Gets the state of the instructions in list, adding it, and flushing the automaton first
+		// if it is full.
+		int intern(const std::vector<int>& list)
+		{
+			std::string key(reinterpret_cast<const char*>(list.data()), list.size() * sizeof(int));
+			auto found = _automaton.index.find(key);
 
-	inline static bool parse_octal(const char* src, size_t& i, size_t& n, char* dst, size_t& j)
+			if (found != _automaton.index.end())
+				return found->second;
+
+			if (_automaton.states.size() >= regex_dfa::state_limit)
+				_automaton.flush();
+
+			unsigned char flags = list.empty() ? regex_dfa_dead : 0;
+			bool waits = false;
+
+			for (int i : list)
+			{
+				if (_code[size_t(i)].op == regex_dfa_inst::match)
+					flags |= regex_dfa_accept | regex_dfa_accept_eol;
+				else if (_code[size_t(i)].op == regex_dfa_inst::eol)
+					waits = true;
+			}
+
+			if (waits && !(flags & regex_dfa_accept))
+			{
+				_cache.seeds = list;
+				closure(false, true, _cache.closed);
+
+				for (int i : _cache.closed)
+				{
+					if (_code[size_t(i)].op == regex_dfa_inst::match)
+						flags |= regex_dfa_accept_eol;
+				}
+			}
+
+			const int result = int(_automaton.states.size());
+
+			_automaton.index.emplace(std::move(key), result);
+			_automaton.states.push_back(list);
+			_automaton.flags.push_back(flags);
+			_automaton.next.resize(_automaton.next.size() + _program.class_count, -1);
+
+			return result;
+		}
+	};
+
+	// Compiles expression for the DFA, if flags and the expression are within its subset.
+	regex_dfa::regex_dfa(const char* expression, std::regex_constants::syntax_option_type flags)
 	{
-		if ((long(n) - long(i)) < 2 || !string::is_one_of(src[i], "0123567") || !string::is_one_of(src[i + 1], "0123567")) 
-			return false;
+		using namespace std::regex_constants;
 
-		dst[j] = ((src[i] - '0') * 8) + (src[i + 1] - '0');
+		if (expression == nullptr || (flags & ~(extended | icase | nosubs | optimize)) != syntax_option_type() || !(flags & extended))
+			return;
 
-		char buffer[4] = { src[i + 0], src[i + 1], '\0', '\0' };
+		regex_dfa_parser tree(expression, (flags & icase) != syntax_option_type());
+		const int root = tree.parse();
 
-		i += 2;
-		dst[j] = char(strtoul(buffer, nullptr, 8) & 0xFFU);
-		++j;
+		if (root < 0)
+			return;
 
-		return true;
+		std::unique_ptr<program> result(new program());
+
+		for (int direction = 0; direction < 2; ++direction)
+		{
+			regex_dfa_inst accept = { regex_dfa_inst::match, -1, -1, -1 };
+			result->code[direction].push_back(accept);
+			result->start[direction] = regex_dfa_compiler(tree, result->code[direction], direction != 0).compile(root, 0);
+
+			if (result->start[direction] < 0)
+				return;
+		}
+
+		// Bytes with the same membership in every set share a class.
+		std::map<std::vector<bool>, unsigned char> signatures;
+
+		for (int c = 0; c < 256; ++c)
+		{
+			std::vector<bool> signature(tree.sets.size());
+
+			for (size_t i = 0; i < tree.sets.size(); ++i)
+				signature[i] = tree.sets[i].contains((unsigned char)c);
+
+			auto found = signatures.emplace(std::move(signature), (unsigned char)signatures.size()).first;
+			result->classes[c] = found->second;
+		}
+
+		result->class_count = signatures.size();
+		result->sets = std::move(tree.sets);
+		_program = std::move(result);
 	}
 
-	inline static bool parse_hexadecimal(const char* src, size_t& i, size_t& n, char* dst, size_t& j)
+	regex_dfa::~regex_dfa() { }
+
+	// Returns whether a match lies within [at, last), running the search automaton until it
+	// first accepts.
+	bool regex_dfa::search(const char* first, const char* at, const char* last) const
 	{
-		if ((long(n) - long(i)) < 2) 
-			return false;
+		runner run(*_program, regex_dfa_search);
 
-		char buffer[4] = { src[i + 0], src[i + 1], '\0', '\0' };
+		int state = run.start(at == first, at == last);
 
-		i += 2;
-		dst[j] = char(strtoul(buffer, nullptr, 16) & 0xFFU);
-		++j;
+		for (; at != last; ++at)
+		{
+			if (run.flags(state) & regex_dfa_accept)
+				return true;
 
-		return true;
+			state = run.step(state, (unsigned char)*at);
+		}
+
+		return (run.flags(state) & regex_dfa_accept_eol) != 0;
 	}
 
-	inline static bool parse_unicode(const char* src, size_t& i, size_t& n, char* dst, size_t& j)
+	// Marks whether a match begins at each position of [at, last], running the reverse
+	// automaton from last, where the state at a position accepts if a match begins there.
+	void regex_dfa::starts(const char* first, const char* at, const char* last, std::vector<bool>& result, bool eol /*= true*/) const
 	{
-		if ((long(n) - long(i)) < 4) 
-			return false;
+		runner run(*_program, regex_dfa_reverse);
 
-		char buffer[8] = { src[i], src[i + 1], src[i + 2], src[i + 3], '\0', };
+		size_t i = size_t(last - at);
+		int state = run.start(eol, last == first);
 
-		i += 4;
-		*((unsigned short*)&dst[j]) = (strtoul(buffer, nullptr, 16) & 0xFFFFU);
-		++j, ++j;
+		result.assign(i + 1, false);
+		result[i] = (run.flags(state) & (last == first ? regex_dfa_accept_eol : regex_dfa_accept)) != 0;
 
-		return true;
+		while (i-- > 0)
+		{
+			state = run.step(state, (unsigned char)at[i]);
+			result[i] = (run.flags(state) & (at + i == first ? regex_dfa_accept_eol : regex_dfa_accept)) != 0;
+		}
 	}
 
-	// Removes UTF-8 C-style or JSON escapes from this.
-	inline static bool unescape_json(string& value, string& result)
+	// Gets the end of the longest match beginning at at, running the longest automaton until
+	// its state dies or the input ends.
+	const char* regex_dfa::longest(const char* first, const char* at, const char* last, bool eol /*= true*/) const
 	{
-		size_t n = value.length();
+		runner run(*_program, regex_dfa_longest);
 
-		if (n == 0) return string();
+		int state = run.start(at == first, eol && at == last);
+		const char* result = nullptr;
 
-		result.clear();
-		result.reserve(n);
+		for (;; ++at)
+		{
+			const unsigned char flags = run.flags(state);
 
-		const char* src = value.c_str();
-		char* dst = &result[0];
+			if (flags & (eol && at == last ? regex_dfa_accept_eol : regex_dfa_accept))
+				result = at;
+
+			if (at == last || (flags & regex_dfa_dead))
+				return result;
+
+			state = run.step(state, (unsigned char)*at);
+		}
+	}
+
+	// Gets the end of the match a backtracking search finds first at at, running the ordered
+	// automaton, in which a match cuts the instructions tried after it, until its state dies.
+	const char* regex_dfa::preferred(const char* first, const char* at, const char* last, bool eol /*= true*/, bool not_null /*= false*/) const
+	{
+		runner run(*_program, regex_dfa_first);
+
+		int state = not_null ? run.start_not_null(at == first, eol && at == last) : run.start(at == first, eol && at == last);
+		const char* result = nullptr;
 
-		for (size_t i = 0, j = 0; i < n; ++i)
+		for (;; ++at)
 		{
-			char c1 = src[i];
+			const unsigned char flags = run.flags(state);
 
-			if (c1 == '\\' && (i + 1) < n)
-			{
-				char c2 = src[i++];
+			if (flags & (eol && at == last ? regex_dfa_accept_eol : regex_dfa_accept))
+				result = at;
 
-				switch (c2)
-				{
-				case 'a': dst[j++] = 0x07; break;
-				case 'b': dst[j++] = 0x08; break;
-				case 'f': dst[j++] = 0x0C; break;
-				case 'n': dst[j++] = 0x0A; break;
-				case 'r': dst[j++] = 0x0D; break;
-				case 't': dst[j++] = 0x09; break;
-				case 'v': dst[j++] = 0x0B; break;
-				case '\\': dst[j++] = 0x5C; break;
-				case '\'': dst[j++] = 0x27; break;
-				case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
-					if (!parse_octal(src, i, n, dst, j)) 
-						return false; 
-					break;
-				case 'x': 
-					if (!parse_hexadecimal(src, i, n, dst, j)) 
-						return false; 
-					break;
-				case 'u': 
-					if (!parse_unicode(src, i, n, dst, j)) 
-						return false; 
-					break;
-				default: 
-					dst[j++] = c1, dst[j++] = c2; 
-					break;
-				}
-			}
-			else dst[j++] = c1;
-		}
+			if (at == last || (flags & regex_dfa_dead))
+				return result;
 
-		return true;
+			state = run.step(state, (unsigned char)*at);
+		}
 	}
 
-	static std::mutex string_escape_url_mutex_;
-	static bool string_escape_url_initialized_ = false;
-	static char string_escape_url_rfc3986_[256] = { 0 };
-	static char string_escape_url_html5_[256] = { 0 };
-	static const char string_escape_url_hex_[] = "0123456789ABCDEF";
-
-	void string_escape_url_initialize()
+	// Gets how far a match beginning in [at, end) can run, running the search automaton to the
+	// last of those starts, and then the longest automaton, which adds no more, until it dies.
+	const char* regex_dfa::reach(const char* first, const char* at, const char* end, const char* last) const
 	{
-		if (string_escape_url_initialized_)
-			return;
+		runner search(*_program, regex_dfa_search);
 
-		string_escape_url_mutex_.lock();
+		int state = search.start(at == first, at == last);
 
-		if (string_escape_url_initialized_)
+		for (; at + 1 < end; ++at)
+			state = search.step(state, (unsigned char)*at);
+
+		runner run(*_program, regex_dfa_longest);
+
+		state = run.adopt(search, state);
+
+		for (; at != last; ++at)
 		{
-			string_escape_url_mutex_.unlock();
-			return;
+			if (run.flags(state) & regex_dfa_dead)
+				return at;
+
+			state = run.step(state, (unsigned char)*at);
 		}
 
-		for (size_t i = 0; i < 256; ++i)
+		return (run.flags(state) & regex_dfa_dead) ? last : nullptr;
+	}
+
+	static std::atomic<unsigned long long> regex_cache_prefiltered_(0);
+	static std::atomic<unsigned long long> regex_cache_rejected_(0);
+
+	// Compiles expression, reads its prefilter, and compiles its DFA where it allows one.
+	regex_cache::compiled::compiled(const char* expression, std::regex_constants::syntax_option_type flags)
+		: regex(expression, flags), prefilter(expression, flags), dfa(expression, flags)
+	{
+	}
+
+	// Finds where a search of [first, last) should start, or returns null if ruled out.
+	const char* regex_cache::compiled::start(const char* first, const char* last) const
+	{
+		if (prefilter.is_trivial())
+			return first;
+
+		regex_cache_prefiltered_.fetch_add(1, std::memory_order_relaxed);
+
+		const char* result = prefilter.candidate(first, last);
+
+		if (result != last)
+			return result;
+
+		regex_cache_rejected_.fetch_add(1, std::memory_order_relaxed);
+
+		return nullptr;
+	}
+
+	// A cached, compiled expression, with the hash of its text and flags it is indexed by.
+	struct regex_cache_entry
+	{
+		std::string expression;
+		std::regex_constants::syntax_option_type flags;
+		unsigned long long hash;
+		std::shared_ptr<const regex_cache::compiled> regex;
+	};
+
+	// One lock stripe of the regex cache: an LRU list, most recently used first, with an index
+	// by hash, so that a lookup compares the expression in place rather than building a key.
+	struct regex_cache_shard
+	{
+		std::mutex mutex;
+		std::list<regex_cache_entry> entries;
+		std::unordered_multimap<unsigned long long, std::list<regex_cache_entry>::iterator> index;
+		unsigned long long hits = 0;
+		unsigned long long misses = 0;
+		unsigned long long evictions = 0;
+	};
+
+	static const size_t regex_cache_shard_count_ = 16;
+	static std::atomic<size_t> regex_cache_capacity_(256);
+
+	// Gets the shards, constructed on first use so that the cache works during static initialization.
+	static regex_cache_shard* regex_cache_shards()
+	{
+		static regex_cache_shard shards[regex_cache_shard_count_];
+		return shards;
+	}
+
+	// Gets the maximum count of entries per shard, which is zero only if caching is disabled.
+	inline static size_t regex_cache_shard_limit()
+	{
+		size_t n = regex_cache_capacity_.load(std::memory_order_relaxed);
+		return (n + regex_cache_shard_count_ - 1) / regex_cache_shard_count_;
+	}
+
+	// Finds the index entry of the list entry at entry, in the locked shard.
+	static std::unordered_multimap<unsigned long long, std::list<regex_cache_entry>::iterator>::iterator regex_cache_index(regex_cache_shard& shard, std::list<regex_cache_entry>::iterator entry)
+	{
+		auto range = shard.index.equal_range(entry->hash);
+
+		while (range.first->second != entry)
+			++range.first;
+
+		return range.first;
+	}
+
+	// Finds the entry for expression with flags in the locked shard, by their hash, or returns
+	// the end of its list.
+	static std::list<regex_cache_entry>::iterator regex_cache_find(regex_cache_shard& shard, const string_view& expression, std::regex_constants::syntax_option_type flags, unsigned long long hash)
+	{
+		auto range = shard.index.equal_range(hash);
+
+		for (auto i = range.first; i != range.second; ++i)
 		{
-			string_escape_url_rfc3986_[i] = 
-				std::isalnum(i) || i == '~' || i == '-' || i == '.' || i == '_' ? i : 0;
+			const regex_cache_entry& entry = *i->second;
 
-			string_escape_url_html5_[i] = 
-				std::isalnum(i) || i == '*' || i == '-' || i == '.' || i == '_' ? i : i == ' ' ? '+' : 0;
+			if (entry.flags == flags && entry.expression.length() == expression.length() && std::memcmp(entry.expression.data(), expression.data(), expression.length()) == 0)
+				return i->second;
 		}
 
-		string_escape_url_initialized_ = true;
-
-		string_escape_url_mutex_.unlock();
+		return shard.entries.end();
 	}
 
-	inline static void escape_url_hex(unsigned value, char* result)
+	// Evicts least recently used entries from the locked shard, down to limit.
+	inline static void regex_cache_trim(regex_cache_shard& shard, size_t limit)
 	{
-		result[0] = string_escape_url_hex_[value % 16U];
-		result[1] = string_escape_url_hex_[(value / 16U) % 16U];
+		while (shard.entries.size() > limit)
+		{
+			shard.index.erase(regex_cache_index(shard, std::prev(shard.entries.end())));
+			shard.entries.pop_back();
+			++shard.evictions;
+		}
 	}
 
-	inline static string escape_url(const char* table, string& value)
+	// Gets the compiled expression, compiling and caching it on a miss.
+	std::shared_ptr<const std::regex> regex_cache::get(const char* expression, std::regex_constants::syntax_option_type flags /*= std::regex_constants::ECMAScript*/)
 	{
-		string_escape_url_initialize();
+		std::shared_ptr<const compiled> result = get_compiled(expression, flags);
 
-		string result;
+		return std::shared_ptr<const std::regex>(result, &result->regex);
+	}
 
-		if (value.length() == 0)
-			return result;
+	// Gets the compiled expression with its prefilter, compiling and caching it on a miss.
+	std::shared_ptr<const regex_cache::compiled> regex_cache::get_compiled(const char* expression, std::regex_constants::syntax_option_type flags /*= std::regex_constants::ECMAScript*/)
+	{
+		if (expression == nullptr)
+			expression = "";
 
-		const char* s = value.c_str();
-		char temp[2];
+		const string_view text(expression);
+		const unsigned long long hash = text.hash_code(hash_code_part::low, static_cast<unsigned long long>(flags));
+		regex_cache_shard& shard = regex_cache_shards()[hash % regex_cache_shard_count_];
 
-		for (; *s; ++s) 
 		{
-			temp[0] = '\0';
+			std::lock_guard<std::mutex> lock(shard.mutex);
 
-			if (table[*s])
-				result.push_back(table[*s]);
-			else
+			auto found = regex_cache_find(shard, text, flags, hash);
+
+			if (found != shard.entries.end())
 			{
-				result.push_back('%');
-				escape_url_hex(*s, temp);
-				result.push_back(temp[0]);
-				result.push_back(temp[1]);
+				shard.entries.splice(shard.entries.begin(), shard.entries, found);
+				++shard.hits;
+				return found->regex;
 			}
+
+			++shard.misses;
+		}
+
+		// Compile without holding the lock. Throws std::regex_error if invalid.
+		std::shared_ptr<const compiled> regex = std::make_shared<const compiled>(expression, flags);
+		const size_t limit = regex_cache_shard_limit();
+
+		if (limit == 0) // Caching is disabled.
+			return regex;
+
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		auto found = regex_cache_find(shard, text, flags, hash);
+
+		if (found != shard.entries.end()) // Another thread compiled it meanwhile.
+		{
+			shard.entries.splice(shard.entries.begin(), shard.entries, found);
+			return found->regex;
+		}
+
+		shard.entries.push_front(regex_cache_entry { std::string(expression), flags, hash, regex });
+		shard.index.emplace(hash, shard.entries.begin());
+		regex_cache_trim(shard, limit);
+
+		return regex;
+	}
+
+	// Gets the hit, miss and eviction counts, and the count of cached expressions.
+	regex_cache::statistics regex_cache::stats()
+	{
+		statistics result = { 0, 0, 0, 0, regex_cache_prefiltered_.load(std::memory_order_relaxed), regex_cache_rejected_.load(std::memory_order_relaxed) };
+		regex_cache_shard* shards = regex_cache_shards();
+
+		for (size_t i = 0; i < regex_cache_shard_count_; ++i)
+		{
+			std::lock_guard<std::mutex> lock(shards[i].mutex);
+
+			result.hits += shards[i].hits;
+			result.misses += shards[i].misses;
+			result.evictions += shards[i].evictions;
+			result.size += shards[i].entries.size();
 		}
 
 		return result;
 	}
 
-	const char* escape_entities_table_[] =
+	// Removes all cached expressions, and resets the counters.
+	void regex_cache::clear()
 	{
-		"nbsp",
-		"iexcl",
-		"cent",
-		"pound",
-		"curren",
-		"yen",
-		"brvbar",
-		"sect",
-		"uml",
-		"copy",
-		"ordf",
-		"laquo",
-		"not",
-		"shy",
-		"reg",
-		"macr",
-		"deg",
-		"plusmn",
-		"sup2",
-		"sup3",
-		"acute",
-		"micro",
-		"para",
-		"middot",
-		"cedil",
-		"sup1",
-		"ordm",
-		"raquo",
-		"frac14",
-		"frac12",
-		"frac34",
-		"iquest",
-		"Agrave",
-		"Aacute",
-		"Acirc",
-		"Atilde",
-		"Auml",
-		"Aring",
-		"AElig",
-		"Ccedil",
-		"Egrave",
-		"Eacute",
-		"Ecirc",
-		"Euml",
-		"Igrave",
-		"Iacute",
-		"Icirc",
-		"Iuml",
-		"ETH",
-		"Ntilde",
-		"Ograve",
-		"Oacute",
-		"Ocirc",
-		"Otilde",
-		"Ouml",
-		"times",
-		"Oslash",
-		"Ugrave",
-		"Uacute",
-		"Ucirc",
-		"Uuml",
-		"Yacute",
-		"THORN",
-		"szlig",
-		"agrave",
-		"aacute",
-		"acirc",
-		"atilde",
-		"auml",
-		"aring",
-		"aelig",
-		"ccedil",
-		"egrave",
-		"eacute",
-		"ecirc",
-		"euml",
-		"igrave",
-		"iacute",
-		"icirc",
-		"iuml",
-		"eth",
-		"ntilde",
-		"ograve",
-		"oacute",
-		"ocirc",
-		"otilde",
-		"ouml",
-		"divide",
-		"oslash",
-		"ugrave",
-		"uacute",
-		"ucirc",
-		"uuml",
-		"yacute",
-		"thorn",
-		"yuml",
-		nullptr
+		regex_cache_shard* shards = regex_cache_shards();
+
+		for (size_t i = 0; i < regex_cache_shard_count_; ++i)
+		{
+			std::lock_guard<std::mutex> lock(shards[i].mutex);
+
+			shards[i].index.clear();
+			shards[i].entries.clear();
+			shards[i].hits = shards[i].misses = shards[i].evictions = 0;
+		}
+
+		regex_cache_prefiltered_.store(0, std::memory_order_relaxed);
+		regex_cache_rejected_.store(0, std::memory_order_relaxed);
+	}
+
+	// Gets the maximum count of cached expressions.
+	size_t regex_cache::capacity()
+	{
+		return regex_cache_capacity_.load(std::memory_order_relaxed);
+	}
+
+	// Sets the maximum count of cached expressions, evicting the least recently used if over.
+	void regex_cache::capacity(size_t value)
+	{
+		regex_cache_capacity_.store(value, std::memory_order_relaxed);
+
+		size_t limit = regex_cache_shard_limit();
+		regex_cache_shard* shards = regex_cache_shards();
+
+		for (size_t i = 0; i < regex_cache_shard_count_; ++i)
+		{
+			std::lock_guard<std::mutex> lock(shards[i].mutex);
+
+			regex_cache_trim(shards[i], limit);
+		}
+	}
+
+	// A vector of string copies, and the allocator the copies are made with.
+	template <typename Alloc>
+	struct token_copies
+	{
+		std::vector<basic_string<Alloc>>& result;
+		Alloc allocator;
 	};
 
-	// Just the ASCII.
-	inline static string escape_entities(const string& value)
+	// Appends a token to a result container, as a view or as a copy.
+	inline static void emit_token(std::vector<string_view>& result, const string_view& token) { result.push_back(token); }
+	template <typename Alloc>
+	inline static void emit_token(token_copies<Alloc>& result, const string_view& token) { result.result.emplace_back(token, result.allocator); }
+	inline static void emit_token(string_table& result, const string_view& token) { result.push_back(token); }
+
+	// Finds the next non-overlapping match of regex in [at, last) into parts, as regex_iterator
+	// does: after an empty match, a non-empty one is sought at the same place before stepping
+	// on. first is the start of the input, and extra adds match flags, such as match_not_eol.
+	// Advances at past the match, and returns false if none.
+	static bool next_match(const std::regex& regex, std::cmatch& parts, const char* first, const char*& at, const char* last, bool& not_null,
+		std::regex_constants::match_flag_type extra = std::regex_constants::match_default)
 	{
-		string result;
+		for (;;)
+		{
+			auto flags = extra;
 
-		const char* s = value.c_str();
+			if (at != first) flags |= std::regex_constants::match_prev_avail;
+			if (not_null) flags |= std::regex_constants::match_not_null | std::regex_constants::match_continuous;
 
-		for (; *s; ++s)
+			if (std::regex_search(at, last, parts, regex, flags))
+			{
+				at = parts[0].second;
+				not_null = parts[0].first == parts[0].second;
+				return true;
+			}
+
+			if (!not_null || at == last)
+				return false;
+
+			++at;
+			not_null = false;
+		}
+	}
+
+	// Finds the successive non-overlapping matches of a compiled expression, as next_match does,
+	// within a window [origin, last] of an input starting at first. If eol is false, the input
+	// goes on past last, so that $ does not match there. With a DFA, one reverse pass over the
+	// window marks where matches begin, and each match runs forward from its start to its
+	// longest end, which is the end std::regex finds where it is also the end of the match its
+	// backtracking tries first; where those differ, std::regex decides from the start, into
+	// parts. Without a DFA, std::regex searches into parts. Once made, a scanner is not changed
+	// by a search into other match results, so that several may share it.
+	class match_scanner
+	{
+	private:
+
+		const regex_cache::compiled& _compiled;
+		std::cmatch& _parts;
+		const char* _first;
+		const char* _origin;
+		const char* _last;
+		bool _eol;
+		std::vector<bool> _starts;
+
+	public:
+
+		match_scanner(const regex_cache::compiled& compiled, std::cmatch& parts, const char* first, const char* origin, const char* last, bool eol = true)
+			: _compiled(compiled), _parts(parts), _first(first), _origin(origin), _last(last), _eol(eol)
 		{
-			switch (*s)
+			if (_compiled.dfa.is_valid())
+				_compiled.dfa.starts(_first, _origin, _last, _starts, _eol);
+		}
+
+	private:
+
+		// Gets the end std::regex finds for the match beginning at start, whose longest end is
+		// longest. std::regex tries the match its backtracking reaches first, and then others only
+		// in part, keeping the longest it has seen; so if the first is the longest, it ends there.
+		// Otherwise std::regex searches from start itself, into parts.
+		const char* settle(const char* start, const char* longest, bool not_null, std::cmatch& parts) const
+		{
+			if (_compiled.dfa.preferred(_first, start, _last, _eol, not_null) == longest)
+				return longest;
+
+			auto flags = std::regex_constants::match_continuous;
+
+			if (start != _first) flags |= std::regex_constants::match_prev_avail;
+			if (!_eol) flags |= std::regex_constants::match_not_eol;
+			if (not_null) flags |= std::regex_constants::match_not_null;
+
+			return std::regex_search(start, _last, parts, _compiled.regex, flags) ? parts[0].second : longest;
+		}
+
+	public:
+
+		// Finds the next match from at, which is within the window, into match. Advances at past
+		// it, and sets not_null if it was empty. Returns false if there is none.
+		inline bool next(const char*& at, bool& not_null, string_view& match) { return next(at, not_null, match, _parts); }
+
+		// Finds the next match as above, searching with std::regex into parts rather than into
+		// the scanner's own match results. parts hold the match's groups only if there is no DFA.
+		bool next(const char*& at, bool& not_null, string_view& match, std::cmatch& parts) const
+		{
+			if (!_compiled.dfa.is_valid())
 			{
-			case '\'': result.append("&apos;"); break;
-			case '"': result.append("&quot;"); break;
-			case '&': result.append("&amp;"); break;
-			case '<': result.append("&lt;"); break;
-			case '>': result.append("&gt;"); break;
-			case char(0x80): result.append("&euro;"); break;
-			case char(0x85): result.append("&hellip;"); break;
-			case char(0x86): result.append("&dagger;"); break;
-			case char(0x87): result.append("&ddagger;"); break;
-			case char(0x89): result.append("&permil;"); break;
-			case char(0x95): result.append("&bullet"); break;
-			case char(0x96): result.append("&endash;"); break;
-			case char(0x97): result.append("&emdash;"); break;
-			case char(0x99): result.append("&trade;"); break;
-			default:
-				if (*s >= char(0xA0))
+				if (!next_match(_compiled.regex, parts, _first, at, _last, not_null, _eol ? std::regex_constants::match_default : std::regex_constants::match_not_eol))
+					return false;
+
+				match = string_view(parts[0].first, size_t(parts[0].second - parts[0].first));
+				return true;
+			}
+
+			if (not_null)
+			{
+				const char* end = _starts[size_t(at - _origin)] ? _compiled.dfa.longest(_first, at, _last, _eol) : nullptr;
+
+				if (end != nullptr && end != at)
+					end = settle(at, end, true, parts);
+
+				if (end != nullptr && end != at)
 				{
-					result.append('&');
-					result.append(escape_entities_table_[(*s - 0xA0U)]);
-					result.append(';');
+					match = string_view(at, size_t(end - at));
+					at = end;
+					not_null = false;
+					return true;
 				}
-				else result.append(*s);
-				break;
+
+				if (at == _last)
+					return false;
+
+				++at;
+				not_null = false;
 			}
+
+			auto begin = std::find(_starts.begin() + (at - _origin), _starts.end(), true);
+
+			if (begin == _starts.end())
+				return false;
+
+			const char* start = _origin + (begin - _starts.begin());
+			const char* end = _compiled.dfa.longest(_first, start, _last, _eol);
+
+			if (end == nullptr)
+				return false;
+
+			end = settle(start, end, false, parts);
+
+			match = string_view(start, size_t(end - start));
+			at = end;
+			not_null = end == start;
+			return true;
 		}
+	};
 
-		return result;
+	// Emits each non-overlapping match of the expression in value, in one pass, reusing the
+	// match results in parts. Returns the count of matches emitted.
+	template <typename Result>
+	static size_t find_matches(const regex_cache::compiled& compiled, std::cmatch& parts, const string_view& value, Result& result)
+	{
+		const char* at = compiled.start(value.begin(), value.end());
+		bool not_null = false;
+		string_view match;
+		size_t count = 0;
+
+		if (at == nullptr)
+			return 0;
+
+		match_scanner scanner(compiled, parts, value.begin(), at, value.end());
+
+		while (scanner.next(at, not_null, match))
+		{
+			emit_token(result, match);
+			++count;
+		}
+
+		return count;
 	}
 
-	typedef struct entity_entry_s
+	// One chunk [begin, end) of a parallel match_all: the matches which start in it, or at its end
+	// if it is the last, and the scan state after each, its position and whether the match was
+	// empty. The scan starts at origin, the first place the prefilter allows, and sees as far
+	// past end as a match starting in the chunk can run. If that is further than the overlap,
+	// the chunk is not exact, and is left to the sequential scan.
+	struct match_chunk
+	{
+		const char* begin;
+		const char* end;
+		const char* origin;
+		std::cmatch parts;
+		std::unique_ptr<match_scanner> scanner;
+		std::vector<string_view> matches;
+		std::vector<std::pair<const char*, bool>> states;
+		bool last;
+		bool exact;
+
+		// True if a match starting at start belongs to this chunk.
+		inline bool owns(const char* start) const { return start < end || (last && start == end); }
+	};
+
+	// Scans a chunk of [first, last) from its start, keeping the matches which start before its
+	// end, over a window which the DFA finds that every such match ends within.
+	static void scan_chunk(const regex_cache::compiled& compiled, const char* first, const char* last, size_t overlap, match_chunk& chunk)
 	{
-		const char* name;
-		unsigned value;
+		const char* limit = chunk.end + std::min(overlap, size_t(last - chunk.end));
+		const char* window = compiled.dfa.reach(first, chunk.begin, chunk.end, limit);
+
+		chunk.exact = window != nullptr || limit == last;
+		chunk.origin = chunk.end;
+
+		if (!chunk.exact)
+			return;
+
+		window = window == nullptr ? last : std::max(window, chunk.end);
+
+		const char* at = compiled.start(chunk.begin, window);
+		bool not_null = false;
+		string_view match;
+
+		chunk.origin = at == nullptr ? chunk.end : at;
+
+		if (at == nullptr)
+			return;
+
+		chunk.scanner.reset(new match_scanner(compiled, chunk.parts, first, at, window, window == last));
+
+		while (chunk.scanner->next(at, not_null, match) && chunk.owns(match.begin()))
+		{
+			chunk.matches.push_back(match);
+			chunk.states.emplace_back(at, not_null);
+		}
 	}
-	entity_entry_t;
 
-	static const entity_entry_t string_unescape_entity_names_[] =
+	// Appends each non-overlapping match of the expression in value to result, scanning chunks
+	// of it on several threads, then merging them in order. The sequential scan state is carried
+	// across chunks: where it reaches a chunk from before its origin, no match started in
+	// between, so the chunk's own scan holds from there. Where a match ran into the chunk, the
+	// scan resumes from its end on the chunk's scanner until it reaches a state the chunk's scan
+	// also passed through, after which the chunk's matches hold. A chunk which is not exact is
+	// scanned sequentially, over the rest of value. Without a DFA to bound the matches, all of
+	// value is scanned sequentially. Returns the count appended.
+	static size_t find_matches(const regex_cache::compiled& compiled, const string_view& value, const chunking& chunks, std::vector<string_view>& result)
 	{
-		{ "nbsp", 160 },
-		{ "iexcl", 161 },
-		{ "cent", 162 },
-		{ "pound", 163 },
-		{ "curren", 164 },
-		{ "yen", 165 },
-		{ "brvbar", 166 },
-		{ "sect", 167 },
-		{ "uml", 168 },
-		{ "copy", 169 },
-		{ "ordf", 170 },
-		{ "laquo", 171 },
-		{ "not", 172 },
-		{ "shy", 173 },
-		{ "reg", 174 },
-		{ "macr", 175 },
-		{ "deg", 176 },
-		{ "plusmn", 177 },
-		{ "sup2", 178 },
-		{ "sup3", 179 },
-		{ "acute", 180 },
-		{ "micro", 181 },
-		{ "para", 182 },
-		{ "middot", 183 },
-		{ "cedil", 184 },
-		{ "sup1", 185 },
-		{ "ordm", 186 },
-		{ "raquo", 187 },
-		{ "frac14", 188 },
-		{ "frac12", 189 },
-		{ "frac34", 190 },
-		{ "iquest", 191 },
-		{ "Agrave", 192 },
-		{ "Aacute", 193 },
-		{ "Acirc", 194 },
-		{ "Atilde", 195 },
-		{ "Auml", 196 },
-		{ "Aring", 197 },
-		{ "AElig", 198 },
-		{ "Ccedil", 199 },
-		{ "Egrave", 200 },
-		{ "Eacute", 201 },
-		{ "Ecirc", 202 },
-		{ "Euml", 203 },
-		{ "Igrave", 204 },
-		{ "Iacute", 205 },
-		{ "Icirc", 206 },
-		{ "Iuml", 207 },
-		{ "ETH", 208 },
-		{ "Ntilde", 209 },
-		{ "Ograve", 210 },
-		{ "Oacute", 211 },
-		{ "Ocirc", 212 },
-		{ "Otilde", 213 },
-		{ "Ouml", 214 },
-		{ "times", 215 },
-		{ "Oslash", 216 },
-		{ "Ugrave", 217 },
-		{ "Uacute", 218 },
-		{ "Ucirc", 219 },
-		{ "Uuml", 220 },
-		{ "Yacute", 221 },
-		{ "THORN", 222 },
-		{ "szlig", 223 },
-		{ "agrave", 224 },
-		{ "aacute", 225 },
+		const char* const first = value.begin();
+		const char* const last = value.end();
+		const size_t size = std::max(chunks.size, size_t(1));
+		const size_t count = (value.length() + size - 1) / size;
+		size_t threads = chunks.threads != 0 ? chunks.threads : size_t(std::thread::hardware_concurrency());
+
+		threads = std::min(std::max(threads, size_t(1)), count);
+
+		if (threads <= 1 || !compiled.dfa.is_valid())
+		{
+			std::cmatch parts;
+			return find_matches(compiled, parts, value, result);
+		}
+
+		std::vector<match_chunk> parts(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			parts[i].begin = first + i * size;
+			parts[i].end = i + 1 == count ? last : parts[i].begin + size;
+			parts[i].last = i + 1 == count;
+		}
+
+		std::atomic<size_t> next(0);
+		std::exception_ptr error;
+		std::mutex error_mutex;
+
+		auto work = [&]
+		{
+			try
+			{
+				for (size_t i; (i = next.fetch_add(1)) < count; )
+					scan_chunk(compiled, first, last, chunks.overlap, parts[i]);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(error_mutex);
+				error = std::current_exception();
+				next.store(count);
+			}
+		};
+
+		std::vector<std::thread> pool;
+
+		for (size_t i = 1; i < threads; ++i)
+			pool.emplace_back(work);
+
+		work();
+
+		for (std::thread& thread : pool)
+			thread.join();
+
+		if (error)
+			std::rethrow_exception(error);
+
+		const size_t appended = result.size();
+		const char* at = first;
+		bool not_null = false;
+		std::cmatch sequential_parts;
+		std::unique_ptr<match_scanner> sequential;
+
+		for (match_chunk& chunk : parts)
+		{
+			size_t from = 0;
+
+			if (!chunk.owns(at))
+				continue;
+
+			if (!chunk.exact)
+			{
+				if (sequential == nullptr)
+					sequential.reset(new match_scanner(compiled, sequential_parts, first, at, last));
+
+				for (string_view match;;)
+				{
+					const char* resume = at;
+					const bool resume_null = not_null;
+
+					if (!sequential->next(at, not_null, match) || !chunk.owns(match.begin()))
+					{
+						at = resume;
+						not_null = resume_null;
+						break;
+					}
+
+					result.push_back(match);
+				}
+
+				continue;
+			}
+
+			if (chunk.scanner != nullptr && (at > chunk.origin || (at == chunk.origin && not_null)))
+			{
+				for (string_view match;;)
+				{
+					auto found = std::lower_bound(chunk.states.begin(), chunk.states.end(), std::make_pair(at, not_null));
+
+					if (found != chunk.states.end() && *found == std::make_pair(at, not_null))
+					{
+						from = size_t(found - chunk.states.begin()) + 1;
+						break;
+					}
+
+					const char* resume = at;
+					const bool resume_null = not_null;
+
+					if (!chunk.scanner->next(at, not_null, match) || !chunk.owns(match.begin()))
+					{
+						at = resume;
+						not_null = resume_null;
+						from = chunk.matches.size();
+						break;
+					}
+
+					result.push_back(match);
+				}
+			}
+
+			if (from < chunk.matches.size())
+			{
+				result.insert(result.end(), chunk.matches.begin() + from, chunk.matches.end());
+				at = chunk.states.back().first;
+				not_null = chunk.states.back().second;
+			}
+		}
+
+		return result.size() - appended;
+	}
+
+	// Scans value for tokens separated by any of the delimiters, as the strtok-style tokenize
+	// did, but without copying or writing to value. Leading delimiters are skipped; after that,
+	// each delimiter ends a token, so adjacent and trailing delimiters give empty tokens.
+	// Returns the count of tokens emitted to result.
+	template <typename Result>
+	static size_t split_tokens(const string_view& value, const char* delimiters, Result& result)
+	{
+		if (value.is_empty() || delimiters == nullptr || *delimiters == '\0')
+			return 0;
+
+		const char_set set(delimiters);
+		const char* p = set.find_not(value.begin(), value.end()); // Skip leading delimiters.
+		const char* e = value.end();
+		size_t count = 0;
+
+		for (;;)
+		{
+			const char* start = p; // Mark token start.
+
+			p = set.find(p, e); // Accumulate token characters.
+
+			emit_token(result, string_view(start, size_t(p - start)));
+			++count;
+
+			if (p == e)
+				break;
+
+			++p; // Step over the delimiter.
+		}
+
+		return count;
+	}
+
+	// Scans value for tokens separated by the needle of delimiter, as split_tokens does on
+	// characters: leading needles are skipped, then each needle ends a token. An empty needle
+	// emits nothing. Returns the count of tokens emitted to result.
+	template <typename Result>
+	static size_t split_tokens(const string_view& value, const searcher& delimiter, Result& result)
+	{
+		if (value.is_empty() || delimiter.length() == 0)
+			return 0;
+
+		const size_t n = delimiter.length();
+		const char* p = value.begin();
+		const char* e = value.end();
+		const char* q = delimiter.find(p, e);
+		size_t count = 0;
+
+		for (; q == p && q != e; q = delimiter.find(p, e)) // Skip leading delimiters.
+			p += n;
+
+		for (;;)
+		{
+			emit_token(result, string_view(p, size_t(q - p)));
+			++count;
+
+			if (q == e)
+				break;
+
+			p = q + n; // Step over the delimiter.
+			q = delimiter.find(p, e);
+		}
+
+		return count;
+	}
+
+	// Scans value for tokens separated by any of the delimiters, emitting each encountered
+	// delimiter as a separate one-character token. Delimiters in omit, if non-null, will not
+	// be retained. Delimiter tokens are views of the delimiter within value.
+	// Returns the count of tokens (including delimiters) emitted to result.
+	template <typename Result>
+	static size_t split_tokens_with(const string_view& value, const char* delimiters, const char* omit, Result& result)
+	{
+		if (value.is_empty() || delimiters == nullptr || *delimiters == '\0')
+			return 0;
+
+		const char_set set(delimiters);
+		const char_set omitted(omit);
+		const char* p = value.begin();
+		const char* e = value.end();
+		size_t count = 0;
+
+		while (p < e)
+		{
+			if (set.contains(*p))
+			{
+				if (!omitted.contains(*p)) // Add it if not omitted.
+				{
+					emit_token(result, string_view(p, 1));
+					++count;
+				}
+
+				++p;
+
+				continue;
+			}
+
+			const char* start = p; // Mark token start.
+
+			p = set.find(p, e); // Accumulate token characters.
+
+			emit_token(result, string_view(start, size_t(p - start)));
+			++count;
+		}
+
+		return count;
+	}
+
+	// Tokenizes this using the single delimiter, and appends the tokens to result vector.
+	// Returns the count of tokens appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split(char delimiter, std::vector<basic_string<Alloc>>& result) const
+	{
+		char delimiters[2] = { delimiter, '\0' };
+
+		token_copies<Alloc> copies = { result, base_type::get_allocator() };
+
+		return split_tokens(*this, delimiters, copies);
+	}
+
+	// Tokenizes this using the single delimiter, and appends views of the tokens to result vector.
+	// Returns the count of tokens appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split(char delimiter, std::vector<string_view>& result) const
+	{
+		char delimiters[2] = { delimiter, '\0' };
+
+		return split_tokens(*this, delimiters, result);
+	}
+
+	// Tokenizes this using the single delimiter, and returns a vector of the tokens.
+	template <typename Alloc>
+	std::vector<basic_string<Alloc>> basic_string<Alloc>::split(char delimiter) const
+	{
+		std::vector<basic_string> result;
+
+		if (delimiter != '\0')
+			split(delimiter, result);
+
+		return result;
+	}
+
+	// Tokenizes this using the delimiters, and appends the tokens to result vector.
+	// Returns the count of tokens appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split(const char* delimiters, std::vector<basic_string<Alloc>>& result) const
+	{
+		token_copies<Alloc> copies = { result, base_type::get_allocator() };
+
+		return split_tokens(*this, delimiters, copies);
+	}
+
+	// Tokenizes this using the delimiters, and appends views of the tokens to result vector.
+	// Returns the count of tokens appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split(const char* delimiters, std::vector<string_view>& result) const
+	{
+		return split_tokens(*this, delimiters, result);
+	}
+
+	// Tokenizes this using the needle of delimiter, and appends the tokens to result vector.
+	// Returns the count of tokens appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split(const searcher& delimiter, std::vector<basic_string<Alloc>>& result) const
+	{
+		token_copies<Alloc> copies = { result, base_type::get_allocator() };
+
+		return split_tokens(*this, delimiter, copies);
+	}
+
+	// Tokenizes this using the needle of delimiter, and appends views of the tokens to result vector.
+	// Returns the count of tokens appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split(const searcher& delimiter, std::vector<string_view>& result) const
+	{
+		return split_tokens(*this, delimiter, result);
+	}
+
+	// Tokenizes this using the delimiters, and appends the tokens to result vector.
+	// Returns the count of tokens appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split(const std::string& delimiters, std::vector<basic_string<Alloc>>& result) const
+	{
+		if (delimiters.length() == 0)
+			return 0;
+		else return split(delimiters.c_str(), result);
+	}
+
+	// Tokenizes this using the delimiters, and returns a vector of the tokens.
+	template <typename Alloc>
+	std::vector<basic_string<Alloc>> basic_string<Alloc>::split(const char* delimiters) const
+	{
+		std::vector<basic_string> result;
+
+		if (delimiters != nullptr && *delimiters)
+			split(delimiters, result);
+
+		return result;
+	}
+
+	// Tokenizes this using the delimiters, and returns a vector of the tokens.
+	template <typename Alloc>
+	std::vector<basic_string<Alloc>> basic_string<Alloc>::split(const std::string& delimiters) const
+	{
+		std::vector<basic_string> result;
+
+		if (delimiters.length() > 0)
+			split(delimiters.c_str(), result);
+
+		return result;
+	}
+
+	// Tokenizes this using the delimiters, and appends the tokens, and each encountered 
+	// delimiter as a separate string, to the result vector. Delimiters in omit, if non-null 
+	// will not be retained.
+	// Returns the count of tokens (including delimiters) captured.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split_with(const char* delimiters, std::vector<basic_string<Alloc>>& result, const char* omit /*= nullptr*/) const
+	{
+		token_copies<Alloc> copies = { result, base_type::get_allocator() };
+
+		return split_tokens_with(*this, delimiters, omit, copies);
+	}
+
+	// Tokenizes this using the delimiters, and appends views of the tokens, and each encountered 
+	// delimiter as a separate view, to the result vector. Delimiters in omit, if non-null 
+	// will not be retained.
+	// Returns the count of tokens (including delimiters) captured.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split_with(const char* delimiters, std::vector<string_view>& result, const char* omit /*= nullptr*/) const
+	{
+		return split_tokens_with(*this, delimiters, omit, result);
+	}
+
+	// Tokenizes this using the delimiters, and appends the tokens, and each encountered 
+	// delimiter as a separate string, to the result vector.
+	// Returns the count of tokens (including delimiters) captured.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split_with(const std::string& delimiters, std::vector<basic_string<Alloc>>& result) const
+	{
+		if (delimiters.length() == 0)
+			return 0;
+		else return split_with(delimiters.c_str(), result);
+	}
+
+	// Tokenizes this using the delimiters, and returns a vector of the tokens, and each encountered 
+	// delimiter as a separate string, to the result vector.
+	template <typename Alloc>
+	std::vector<basic_string<Alloc>> basic_string<Alloc>::split_with(const char* delimiters, const char* omit /*= nullptr*/) const
+	{
+		std::vector<basic_string> result;
+
+		if (delimiters != nullptr && *delimiters)
+			split_with(delimiters, result, omit);
+
+		return result;
+	}
+
+	// Tokenizes this using the delimiters, and returns a vector of the tokens, and each encountered 
+	// delimiter as a separate string, to the result vector.
+	template <typename Alloc>
+	std::vector<basic_string<Alloc>> basic_string<Alloc>::split_with(const std::string& delimiters) const
+	{
+		std::vector<basic_string> result;
+
+		if (delimiters.length() > 0)
+			split_with(delimiters.c_str(), result);
+
+		return result;
+	}
+
+	// Tokenizes this using the single delimiter, and appends the tokens, and each encountered 
+	// delimiter as a separate string, to the result vector.
+	// Returns the count of tokens (including delimiters) captured.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split_with(char delimiter, std::vector<basic_string<Alloc>>& result) const
+	{
+		char delimiters[2] = { delimiter, '\0' };
+
+		token_copies<Alloc> copies = { result, base_type::get_allocator() };
+
+		return split_tokens_with(*this, delimiters, nullptr, copies);
+	}
+
+	// Tokenizes this using the single delimiter, and appends views of the tokens, and each 
+	// encountered delimiter as a separate view, to the result vector.
+	// Returns the count of tokens (including delimiters) captured.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split_with(char delimiter, std::vector<string_view>& result) const
+	{
+		char delimiters[2] = { delimiter, '\0' };
+
+		return split_tokens_with(*this, delimiters, nullptr, result);
+	}
+
+	// Tokenizes this using the single delimiter, and returns a vector of the tokens
+	// with each separate delimiter as a string, in order.
+	template <typename Alloc>
+	std::vector<basic_string<Alloc>> basic_string<Alloc>::split_with(char delimiter) const
+	{
+		std::vector<basic_string> result;
+
+		if (delimiter != '\0')
+			split_with(delimiter, result);
+
+		return result;
+	}
+
+	// Tokenizes this using the single delimiter, and appends the tokens to the contiguous table.
+	// Returns the count of tokens appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split(char delimiter, string_table& result) const
+	{
+		char delimiters[2] = { delimiter, '\0' };
+
+		return split_tokens(*this, delimiters, result);
+	}
+
+	// Tokenizes this using the delimiters, and appends the tokens to the contiguous table.
+	// Returns the count of tokens appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split(const char* delimiters, string_table& result) const
+	{
+		return split_tokens(*this, delimiters, result);
+	}
+
+	// Tokenizes this using the single delimiter, and appends the tokens, and each encountered 
+	// delimiter, to the contiguous table.
+	// Returns the count of tokens (including delimiters) appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split_with(char delimiter, string_table& result) const
+	{
+		char delimiters[2] = { delimiter, '\0' };
+
+		return split_tokens_with(*this, delimiters, nullptr, result);
+	}
+
+	// Tokenizes this using the delimiters, and appends the tokens, and each encountered 
+	// delimiter not in omit, to the contiguous table.
+	// Returns the count of tokens (including delimiters) appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::split_with(const char* delimiters, string_table& result, const char* omit /*= nullptr*/) const
+	{
+		return split_tokens_with(*this, delimiters, omit, result);
+	}
+
+	// Reserves space for count elements, and the given total count of characters.
+	void string_table::reserve(size_t count, size_t bytes /*= 0*/)
+	{
+		_offsets.reserve(count + 1);
+
+		if (bytes > 0)
+			_bytes.reserve(bytes);
+	}
+
+	// Copies the elements into a vector of strings.
+	std::vector<string> string_table::to_vector() const
+	{
+		std::vector<string> result;
+
+		result.reserve(size());
+
+		for (size_t i = 0, n = size(); i < n; ++i)
+			result.push_back((*this)[i].to_string());
+
+		return result;
+	}
+
+	// Ranges over the tokens of source separated by any of the delimiters. If with is true,
+	// each encountered delimiter not in omit is also yielded as a separate token.
+	token_range::token_range(const string_view& source, const char* delimiters, const char* omit /*= nullptr*/, bool with /*= false*/)
+		: _source(source), _delimiters(delimiters), _omit(omit), _with(with)
+	{
+		if (_delimiters.empty()) // Nothing to split on, so no tokens.
+			_source = string_view();
+	}
+
+	// Ranges over the tokens of source separated by the single delimiter. If with is true,
+	// each encountered delimiter is also yielded as a separate token.
+	token_range::token_range(const string_view& source, char delimiter, bool with /*= false*/)
+		: _source(source), _delimiters(delimiter), _with(with)
+	{
+		if (_delimiters.empty())
+			_source = string_view();
+	}
+
+	// Scans the next token starting at position, advancing position past it.
+	// Returns false if there are no more tokens.
+	bool token_range::next(const char*& position, string_view& token) const
+	{
+		const char* p = position;
+		const char* e = _source.end();
+
+		if (!_with)
+		{
+			// As with split: leading delimiters are skipped, then each delimiter ends a token.
+			// Position becomes null once the token ending at the end of source is taken.
+
+			if (p == nullptr || _source.is_empty())
+				return false;
+
+			if (p == _source.begin())
+				p = _delimiters.find_not(p, e); // Skip leading delimiters.
+
+			const char* start = p; // Mark token start.
+
+			p = _delimiters.find(p, e); // Accumulate token characters.
+
+			token = string_view(start, size_t(p - start));
+			position = p == e ? nullptr : p + 1;
+
+			return true;
+		}
+
+		for (; p < e && _delimiters.contains(*p); ++p)
+		{
+			if (!_omit.contains(*p)) // Yield it if not omitted.
+			{
+				token = string_view(p, 1);
+				position = p + 1;
+				return true;
+			}
+		}
+
+		if (p == e)
+		{
+			position = p;
+			return false;
+		}
+
+		const char* start = p; // Mark token start.
+
+		p = _delimiters.find(p, e); // Accumulate token characters.
+
+		token = string_view(start, size_t(p - start));
+		position = p;
+
+		return true;
+	}
+
+	// Ranges over the matches of the expression, compiled with flags through regex_cache, in
+	// source. A null expression or empty source has no matches.
+	match_range::match_range(const string_view& source, const char* expression, std::regex_constants::syntax_option_type flags /*= std::regex_constants::ECMAScript*/)
+		: _source(source)
+	{
+		if (expression != nullptr && !_source.is_empty())
+			_regex = regex_cache::get_compiled(expression, flags);
+	}
+
+	// Ranges over the matches of an already compiled expression in source. A null expression
+	// or empty source has no matches.
+	match_range::match_range(const string_view& source, std::shared_ptr<const regex_cache::compiled> regex)
+		: _source(source)
+	{
+		if (!_source.is_empty())
+			_regex = std::move(regex);
+	}
+
+	// Starts at the first position the expression's prefilter allows, or at the end if the
+	// prefilter rejects the source outright.
+	match_range::iterator match_range::begin() const
+	{
+		if (_regex == nullptr)
+			return iterator();
+
+		return iterator(this, _regex->start(_source.begin(), _source.end()));
+	}
+
+	// The DFA's scan of a window of a range's source, which finds the matches starting in
+	// [begin, end), or at end if it is the end of the source, as a chunk of a parallel
+	// match_all does. The window runs past end as far as such a match can, and the scan
+	// starts at origin, the first place in it the prefilter allows, or has no scanner if
+	// there is none. Windows start small, so that a range stopped early scans little, and
+	// double up to a limit. A scan is not changed once made, so iterator copies share it.
+	struct match_range::scan
+	{
+		static const size_t initial_size = 256;
+		static const size_t size_limit = 65536;
+
+		const char* begin;
+		const char* end;
+		const char* origin;
+		size_t size;
+		bool last;
+		std::cmatch parts;
+		std::unique_ptr<match_scanner> scanner;
+
+		scan(const regex_cache::compiled& compiled, const string_view& source, const char* at, size_t size)
+			: begin(at), end(at + std::min(size, size_t(source.end() - at))), origin(nullptr), size(size), last(end == source.end())
+		{
+			const char* window = source.end();
+
+			if (at != window)
+			{
+				window = compiled.dfa.reach(source.begin(), at, end, source.end());
+				window = window == nullptr ? source.end() : std::max(window, end);
+			}
+
+			origin = compiled.start(at, window);
+
+			if (origin != nullptr)
+				scanner.reset(new match_scanner(compiled, parts, source.begin(), origin, window, window == source.end()));
+		}
+
+		// True if a match starting at start belongs to this scan.
+		inline bool owns(const char* start) const { return start >= begin && (start < end || (last && start == end)); }
+	};
+
+	// Searches for the next match from position into parts, advancing position past it.
+	// Returns false if there are no more matches. With a DFA, the scan of the window position
+	// is in finds the match, or else the scan of the next window, and std::regex fills in its
+	// groups by matching just it. That gives the groups it would give searching the whole
+	// source, as none of the matches it tries there ends past this one.
+	bool match_range::next(const char*& position, bool& not_null, std::cmatch& parts, std::shared_ptr<const scan>& scan) const
+	{
+		if (!_regex->dfa.is_valid())
+			return next_match(_regex->regex, parts, _source.begin(), position, _source.end(), not_null);
+
+		for (;;)
+		{
+			if (scan == nullptr || !scan->owns(position))
+				scan = std::make_shared<const match_range::scan>(*_regex, _source, position, scan == nullptr ? size_t(scan::initial_size) : std::min(scan->size * 2, size_t(scan::size_limit)));
+
+			if (scan->scanner != nullptr && position <= scan->origin)
+			{
+				not_null = not_null && position == scan->origin;
+				position = scan->origin;
+			}
+
+			const char* at = position;
+			const bool resumed = not_null;
+			string_view match;
+
+			if (scan->scanner != nullptr && scan->scanner->next(position, not_null, match, parts) && scan->owns(match.begin()))
+			{
+				auto flags = regex_cache::compiled::flags(_source.begin(), match.begin()) | std::regex_constants::match_continuous;
+
+				if (match.end() != _source.end()) flags |= std::regex_constants::match_not_eol;
+				if (resumed && match.begin() == at) flags |= std::regex_constants::match_not_null;
+
+				return std::regex_search(match.begin(), match.end(), parts, _regex->regex, flags);
+			}
+
+			if (scan->last)
+				return false;
+
+			position = scan->end;
+			not_null = false;
+		}
+	}
+
+	// A piece of a replacement format: literal text, or a reference to a group of the match,
+	// or to the text between it and the previous match (prefix), or after it (suffix).
+	struct format_piece
+	{
+		static const size_t prefix = size_t(-1);
+		static const size_t suffix = size_t(-2);
+		static const size_t literal = size_t(-3);
+
+		size_t group;
+		const char* text;
+		size_t length;
+	};
+
+	// Splits format into pieces, reading $n and $nn as groups, $& as the match, $` and $' as
+	// the prefix and suffix and $$ as $, as std::regex_replace does. A $ that begins none of
+	// these is literal. Returns one past the highest group referenced.
+	static size_t parse_replacement(const char* format, std::vector<format_piece>& pieces)
+	{
+		size_t width = 1;
+		const char* text = format;
+		const char* p = format;
+
+		auto flush = [&](const char* end)
+		{
+			if (end != text)
+				pieces.push_back(format_piece { format_piece::literal, text, size_t(end - text) });
+		};
+
+		while (*p != '\0')
+		{
+			if (*p != '$')
+			{
+				++p;
+				continue;
+			}
+
+			char c = p[1];
+			size_t group;
+			const char* next = p + 2;
+
+			if (c == '$')
+			{
+				flush(p + 1); // Keep one $ as literal text.
+				text = p = next;
+				continue;
+			}
+			else if (c == '&') group = 0;
+			else if (c == '`') group = format_piece::prefix;
+			else if (c == '\'') group = format_piece::suffix;
+			else if (c >= '0' && c <= '9')
+			{
+				group = size_t(c - '0');
+
+				if (*next >= '0' && *next <= '9')
+					group = group * 10 + size_t(*next++ - '0');
+
+				if (group + 1 > width)
+					width = group + 1;
+			}
+			else
+			{
+				++p;
+				continue;
+			}
+
+			flush(p);
+			pieces.push_back(format_piece { group, nullptr, 0 });
+			text = p = next;
+		}
+
+		flush(p);
+
+		return width;
+	}
+
+	// Replaces each non-overlapping match of expression in this with replacement, which is
+	// expanded for each match as std::regex_replace expands its format. The group views each
+	// match needs are collected first, so that the output is sized exactly and written once.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::replace_all(const pattern& expression, const char* replacement)
+	{
+		if (!expression.is_valid() || is_empty())
+			return 0;
+
+		std::vector<format_piece> pieces;
+		size_t width = parse_replacement(replacement == nullptr ? "" : replacement, pieces);
+
+		const char* first = base_type::data();
+		const char* last = first + base_type::length();
+		const char* previous = first;
+		std::vector<string_view> groups;
+		size_t count = 0;
+		size_t total = base_type::length();
+
+		for (const match_range::match& match : match_range(*this, expression.compiled()))
+		{
+			for (size_t i = 0; i < width; ++i)
+				groups.push_back(match.group(i));
+
+			const string_view* views = groups.data() + groups.size() - width;
+
+			total -= views[0].length();
+
+			for (const format_piece& piece : pieces)
+			{
+				if (piece.group == format_piece::literal) total += piece.length;
+				else if (piece.group == format_piece::prefix) total += size_t(views[0].begin() - previous);
+				else if (piece.group == format_piece::suffix) total += size_t(last - views[0].end());
+				else total += views[piece.group].length();
+			}
+
+			previous = views[0].end();
+			++count;
+		}
+
+		if (count == 0)
+			return 0;
+
+		base_type output(total, '\0', base_type::get_allocator());
+		char* out = &output[0];
+		const char* copied = first;
+
+		auto put = [&out](const char* from, size_t length)
+		{
+			if (length != 0)
+			{
+				std::memcpy(out, from, length);
+				out += length;
+			}
+		};
+
+		for (size_t m = 0; m < count; ++m)
+		{
+			const string_view* views = groups.data() + m * width;
+
+			put(copied, size_t(views[0].begin() - copied));
+
+			for (const format_piece& piece : pieces)
+			{
+				if (piece.group == format_piece::literal) put(piece.text, piece.length);
+				else if (piece.group == format_piece::prefix) put(copied, size_t(views[0].begin() - copied));
+				else if (piece.group == format_piece::suffix) put(views[0].end(), size_t(last - views[0].end()));
+				else put(views[piece.group].begin(), views[piece.group].length());
+			}
+
+			copied = views[0].end();
+		}
+
+		put(copied, size_t(last - copied));
+		assert(out == output.data() + total);
+		base_type::swap(output);
+
+		return count;
+	}
+
+	// Lazily tokenizes this using the single delimiter, as with split.
+	template <typename Alloc>
+	token_range basic_string<Alloc>::tokens(char delimiter) const { return token_range(*this, delimiter); }
+
+	// Lazily tokenizes this using the delimiters, as with split.
+	template <typename Alloc>
+	token_range basic_string<Alloc>::tokens(const char* delimiters) const { return token_range(*this, delimiters); }
+
+	// Lazily tokenizes this using the single delimiter, as with split_with.
+	template <typename Alloc>
+	token_range basic_string<Alloc>::tokens_with(char delimiter) const { return token_range(*this, delimiter, true); }
+
+	// Lazily tokenizes this using the delimiters, as with split_with.
+	template <typename Alloc>
+	token_range basic_string<Alloc>::tokens_with(const char* delimiters, const char* omit /*= nullptr*/) const { return token_range(*this, delimiters, omit, true); }
+
+	// Lazily tokenizes this using the single delimiter, as with split.
+	token_range string_view::tokens(char delimiter) const { return token_range(*this, delimiter); }
+
+	// Lazily tokenizes this using the delimiters, as with split.
+	token_range string_view::tokens(const char* delimiters) const { return token_range(*this, delimiters); }
+
+	// Lazily tokenizes this using the single delimiter, as with split_with.
+	token_range string_view::tokens_with(char delimiter) const { return token_range(*this, delimiter, true); }
+
+	// Lazily tokenizes this using the delimiters, as with split_with.
+	token_range string_view::tokens_with(const char* delimiters, const char* omit /*= nullptr*/) const { return token_range(*this, delimiters, omit, true); }
+
+	// Returns true if this is formatted as a decimal integer with an optional sign.
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_decimal_integer() const
+	{
+		return string_view(*this).is_decimal_integer();
+	}
+
+	// Returns true if this is formatted as a decimal integer with a sign.
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_signed_decimal_integer() const
+	{
+		return string_view(*this).is_signed_decimal_integer();
+	}
+
+	// Returns true if this is formatted as an unsigned decimal integer.
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_unsigned_decimal_integer() const
+	{
+		return string_view(*this).is_unsigned_decimal_integer();
+	}
+
+	// Returns true if this is formatted as a hexadecimal integer.
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_hexadecimal_integer() const
+	{
+		return string_view(*this).is_hexadecimal_integer();
+	}
+
+	// Returns true if this is formatted as an octal integer with the "0" prefix.
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_octal_integer() const
+	{
+		return string_view(*this).is_octal_integer();
+	}
+
+	// Returns true if this is formatted as a binary integer with the "0b" prefix.
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_binary_integer() const
+	{
+		return string_view(*this).is_binary_integer();
+	}
+
+	// Returns true if this is formatted as a decimal, hexadecimal, or octal integer.
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_integer() const
+	{
+		return string_view(*this).is_integer();
+	}
+
+	// Returns true if this is formatted as a boolean.
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_boolean() const
+	{
+		return string_view(*this).is_boolean();
+	}
+
+	// Returns true if this is formatted as a decimal floating point value.
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_decimal_float() const
+	{
+		return string_view(*this).is_decimal_float();
+	}
+
+	// Returns true if this is formatted as a hexadecimal floating point value.
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_hexadecimal_float() const
+	{
+		return string_view(*this).is_hexadecimal_float();
+	}
+
+	// Returns true if this is formatted as a decimal or hexadecimal floating point value.
+	template <typename Alloc>
+	bool basic_string<Alloc>::is_float() const
+	{
+		return string_view(*this).is_float();
+	}
+
+	// Attempts to parse this as an integer value in binary, octal, decimal or hexadecimal format.
+	// Returns true if the operation succeeded.
+	// If the operation failed, result and negative will not be set.
+	template <typename Alloc>
+	bool basic_string<Alloc>::parse_integer(unsigned long long& result, bool& negative) const
+	{
+		return string_view(*this).parse_integer(result, negative);
+	}
+
+	// Attempts to parse this as a floating point number.
+	// Returns true if the operation succeeded, and result will be set.
+	// If the operation failed, result will not be set.
+	template <typename Alloc>
+	bool basic_string<Alloc>::parse_float(long double& result) const
+	{
+		return string_view(*this).parse_float(result);
+	}
+
+	// Attempts to parse this as a boolean.
+	// Returns true if the operation succeeded, and result will be set.
+	// If the operation failed, result will not be set.
+	template <typename Alloc>
+	bool basic_string<Alloc>::parse_boolean(bool& result) const
+	{
+		return string_view(*this).parse_boolean(result);
+	}
+
+	template <typename Alloc>
+	bool basic_string<Alloc>::to_bool() const
+	{
+		return string_view(*this).to_bool();
+	}
+
+	// Parses value if it is only an optional sign and up to 19 decimal digits without a leading
+	// zero, or 0, which parse_integer would read the same way, and cannot overflow.
+	inline static bool parse_plain_decimal(const string_view& value, unsigned long long& result, bool& negative)
+	{
+		const char* p = value.data();
+		const char* last = p + value.length();
+
+		negative = *p == '-';
+
+		if (*p == '-' || *p == '+') ++p;
+
+		if (p == last || size_t(last - p) > 19 || *p < '0' || *p > '9' || (*p == '0' && last - p > 1) || (*p == '0' && p != value.data()))
+			return false;
+
+		unsigned long long v = 0ULL;
+
+		for (; p != last; ++p)
+		{
+			if (*p < '0' || *p > '9')
+				return false;
+
+			v = v * 10 + unsigned(*p - '0');
+		}
+
+		result = v;
+
+		return true;
+	}
+
+	// Casts a parsed integer to the type, saturating at minimum and maximum.
+	template <class T>
+	inline static T clamp_integer(unsigned long long integer, bool negative, T minimum, T maximum)
+	{
+		if (!negative && integer > static_cast<unsigned long long>(maximum))
+			return maximum;
+		else if (negative && integer > static_cast<unsigned long long>(maximum))
+			return minimum;
+		else if (negative)
+			return -static_cast<T>(integer);
+		else return static_cast<T>(integer);
+	}
+
+	// Parses value if it is only an optional sign, decimal digits without a leading zero (or 0,
+	// or none), a dot and decimal digits, with no more digits than long double holds exactly.
+	// The quotient of the digits by a power of ten is then rounded once, as strtold rounds.
+	inline static bool parse_plain_float(const string_view& value, long double& result)
+	{
+		static const long double powers[] = { 1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L,
+			1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L };
+		const size_t limit = std::numeric_limits<long double>::digits >= 64 ? 19 : 15;
+
+		const char* p = value.data();
+		const char* last = p + value.length();
+		const bool negative = *p == '-';
+
+		if (*p == '-' || *p == '+') ++p;
+
+		const char* whole = p;
+		unsigned long long digits = 0ULL;
+
+		while (p != last && *p >= '0' && *p <= '9' && size_t(p - whole) < limit)
+			digits = digits * 10 + unsigned(*p++ - '0');
+
+		if (p == last || *p != '.' || (p - whole > 1 && *whole == '0'))
+			return false;
+
+		const char* fraction = ++p;
+
+		while (p != last && *p >= '0' && *p <= '9' && size_t(p - whole) <= limit)
+			digits = digits * 10 + unsigned(*p++ - '0');
+
+		if (p != last || p == fraction)
+			return false;
+
+		long double real = (long double)digits / powers[p - fraction];
+
+		result = negative ? -real : real;
+
+		return true;
+	}
+
+	// Casts a parsed real to the type, saturating integer types at minimum and maximum.
+	template <class T>
+	inline static T cast_real(long double real, T minimum, T maximum, T nan)
+	{
+		if (std::is_floating_point<T>::value)
+			return static_cast<T>(real);
+		else if (std::isnan(real))
+			return nan;
+		else if (real == std::numeric_limits<long double>::infinity())
+			return maximum;
+		else if (real == -std::numeric_limits<long double>::infinity())
+			return minimum;
+		else if (real < static_cast<long double>(minimum))
+			return minimum;
+		else if (real > static_cast<long double>(maximum))
+			return maximum;
+		else return static_cast<T>(real);
+	}
+
+	// Attempts to parse this as a numeric type, and cast it to the specified type.
+	// Returns the parsed numeric value cast to type, if parsed, else one of the arguments.
+	// Result may be one of zero, one, minimum, maximum, or nan depending upon the conversion.
+	template <class T>
+	inline static T parse_cast(const string_view& value, T zero, T one, T minimum, T maximum, T nan)
+	{
+		unsigned long long integer = 0ULL;
+		bool negative = false;
+		long double real = 0.0L;
+
+		if (value.is_empty())
+			return nan;
+		else if (parse_plain_decimal(value, integer, negative)) // The common cases, decided in one pass.
+			return clamp_integer(integer, negative, minimum, maximum);
+		else if (parse_plain_float(value, real))
+			return cast_real(real, minimum, maximum, nan);
+		else if (value.is_boolean())
+		{
+			bool boolean = false;
+
+			if (value.parse_boolean(boolean))
+				return boolean ? one : zero;
+			else return nan;
+		}
+		else if (value.is_float())
+		{
+			if (value.parse_float(real))
+				return cast_real(real, minimum, maximum, nan);
+			else return nan;
+		}
+		else if (value.is_integer())
+		{
+			if (value.parse_integer(integer, negative))
+				return clamp_integer(integer, negative, minimum, maximum);
+			else return nan;
+		}
+		else return nan;
+	}
+
+	template <typename Alloc>
+	char basic_string<Alloc>::to_char() const { return string_view(*this).to_char(); }
+	template <typename Alloc>
+	unsigned char basic_string<Alloc>::to_byte() const { return string_view(*this).to_byte(); }
+	template <typename Alloc>
+	short basic_string<Alloc>::to_short() const { return string_view(*this).to_short(); }
+	template <typename Alloc>
+	unsigned short basic_string<Alloc>::to_ushort() const { return string_view(*this).to_ushort(); }
+	template <typename Alloc>
+	int basic_string<Alloc>::to_int() const { return string_view(*this).to_int(); }
+	template <typename Alloc>
+	unsigned int basic_string<Alloc>::to_uint() const { return string_view(*this).to_uint(); }
+	template <typename Alloc>
+	long basic_string<Alloc>::to_long() const { return string_view(*this).to_long(); }
+	template <typename Alloc>
+	unsigned long basic_string<Alloc>::to_ulong() const { return string_view(*this).to_ulong(); }
+	template <typename Alloc>
+	long long basic_string<Alloc>::to_llong() const { return string_view(*this).to_llong(); }
+	template <typename Alloc>
+	unsigned long long basic_string<Alloc>::to_ullong() const { return string_view(*this).to_ullong(); }
+	template <typename Alloc>
+	float basic_string<Alloc>::to_float() const { return string_view(*this).to_float(); }
+	template <typename Alloc>
+	double basic_string<Alloc>::to_double() const { return string_view(*this).to_double(); }
+	template <typename Alloc>
+	long double basic_string<Alloc>::to_ldouble() const { return string_view(*this).to_ldouble(); }
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(const std::string& value) &
+	{
+		base_type::append(value);
+		_null = false;
+
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(const char* value) &
+	{
+		if (value == nullptr || !*value)
+			return *this;
+
+		base_type::append(value);
+		_null = false;
+
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::append(const char* value) const &
+	{
+		basic_string result = clone();
+
+		if (value == nullptr || !*value) 
+			return result;
+
+		result.append(value);
+		result._null = false;
+
+		return result;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::append(const char* value) &&
+	{
+		return std::move(append(value));
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::append(const std::string& value) const &
+	{
+		basic_string result = clone();
+
+		result.append(value);
+		result._null = false;
+
+		return result;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::append(const std::string& value) &&
+	{
+		return std::move(append(value));
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(char value) &
+	{
+		if (is_empty() && value == '\0')
+		{
+			_null = false;
+
+			return *this;
+		}
+
+		base_type::push_back(value);
+
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::append(char value) const &
+	{
+		basic_string result = clone();
+
+		if (result.is_empty() && value == '\0')
+		{
+			result._null = false;
+
+			return result;
+		}
+
+		result.push_back(value);
+
+		return result;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::append(char value) &&
+	{
+		return std::move(append(value));
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::prepend(const char* value) &
+	{
+		if (value == nullptr || !*value)
+			return *this;
+
+		base_type::insert(0, value);
+		_null = false;
+
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::prepend(const std::string& value) &
+	{
+		base_type::insert(0, value);
+		_null = false;
+
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::prepend(const char* value) const &
+	{
+		basic_string result = clone();
+
+		if (value == nullptr || !*value)
+			return result;
+
+		result.insert(0, value);
+		result._null = false;
+
+		return result;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::prepend(const char* value) &&
+	{
+		return std::move(prepend(value));
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::prepend(const std::string& value) const &
+	{
+		basic_string result = clone();
+
+		result.insert(0, value);
+		result._null = false;
+
+		return result;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::prepend(const std::string& value) &&
+	{
+		return std::move(prepend(value));
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::prepend(char value) &
+	{
+		if (is_empty() && value == '\0')
+		{
+			_null = false;
+			return *this;
+		}
+
+		base_type::insert(0, 1, value);
+		_null = false;
+
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::prepend(char value) const &
+	{
+		basic_string result = clone();
+
+		if (result.is_empty() && value == '\0')
+		{
+			result._null = false;
+			return result;
+		}
+
+		result.insert(0, 1, value);
+		result._null = false;
+
+		return result;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::prepend(char value) &&
+	{
+		return std::move(prepend(value));
+	}
+
+#if defined(_MSC_VER)
+#pragma intrinsic(_rotl64)
+#define rotl_64(a, n) _rotl64((a), n)
+#else
+#if defined(__clang__)
+#define rotl_64(a, n) __builtin_rotateleft64((a), n)
+#elif defined(__x86_64__)
+#define rotl_64(a, n) ({ uint64_t r; asm("rolq %1,%0" : "=r"(r) : "J"(n),"0"(a) : "cc"); r; })
+#else
+#define rotl_64(a, n) (((a) << (n)) | ((a) >> (64 - (n))))
+#endif
+#endif
+
+	inline static uint64_t fmix_64(uint64_t k)
+	{
+		k ^= k >> 33;
+		k *= UINT64_C(0xFF51AFD7ED558CCD);
+		k ^= k >> 33;
+		k *= UINT64_C(0xC4CEB9FE1A85EC53);
+		k ^= k >> 33;
+
+		return k;
+	}
+
+	// The following is derived from MurmurHash3 written by Austin Appleby, and is placed in the public domain. 
+	// Austin Appleby disclaims copyright to this source code.
+	inline static void murmur3_x64_128(const void* value, const size_t bytes, const uint64_t seed, uint64_t* result)
+	{
+		const uint8_t* data = (const uint8_t*)value;
+		const size_t blocks = bytes / UINT64_C(16);
+
+		uint64_t h1 = seed;
+		uint64_t h2 = seed;
+
+		const uint64_t c1 = UINT64_C(0x87C37B91114253D5);
+		const uint64_t c2 = UINT64_C(0x4CF5AD432745937F);
+		const uint64_t* block = (const uint64_t*)data;
+
+		for (size_t i = 0; i < blocks; ++i)
+		{
+			uint64_t k1 = block[i * 2 + 0];
+			uint64_t k2 = block[i * 2 + 1];
+
+			k1 *= c1; k1 = rotl_64(k1, 31); k1 *= c2; h1 ^= k1;
+			h1 = rotl_64(h1, 27); h1 += h2; h1 = h1 * UINT64_C(5) + UINT64_C(0x52DCE729);
+			k2 *= c2; k2 = rotl_64(k2, 33); k2 *= c1; h2 ^= k2;
+			h2 = rotl_64(h2, 31); h2 += h1; h2 = h2 * UINT64_C(5) + UINT64_C(0x38495AB5);
+		}
+
+		const uint8_t* tail = (const uint8_t*)(data + blocks * 16);
+
+		uint64_t k1 = UINT64_C(0);
+		uint64_t k2 = UINT64_C(0);
+
+		switch (bytes & 15)
+		{
+		case 15: k2 ^= ((uint64_t)tail[14]) << 48;
+		case 14: k2 ^= ((uint64_t)tail[13]) << 40;
+		case 13: k2 ^= ((uint64_t)tail[12]) << 32;
+		case 12: k2 ^= ((uint64_t)tail[11]) << 24;
+		case 11: k2 ^= ((uint64_t)tail[10]) << 16;
+		case 10: k2 ^= ((uint64_t)tail[ 9]) <<  8;
+		case  9: k2 ^= ((uint64_t)tail[ 8]) <<  0;
+
+			k2 *= c2; 
+			k2 = rotl_64(k2, 33); 
+			k2 *= c1; 
+			h2 ^= k2;
+
+		case  8: k1 ^= ((uint64_t)tail[7]) << 56;
+		case  7: k1 ^= ((uint64_t)tail[6]) << 48;
+		case  6: k1 ^= ((uint64_t)tail[5]) << 40;
+		case  5: k1 ^= ((uint64_t)tail[4]) << 32;
+		case  4: k1 ^= ((uint64_t)tail[3]) << 24;
+		case  3: k1 ^= ((uint64_t)tail[2]) << 16;
+		case  2: k1 ^= ((uint64_t)tail[1]) <<  8;
+		case  1: k1 ^= ((uint64_t)tail[0]) <<  0;
+
+			k1 *= c1; 
+			k1 = rotl_64(k1, 31); 
+			k1 *= c2; 
+			h1 ^= k1;
+		}
+
+		h1 ^= bytes;
+		h2 ^= bytes;
+
+		h1 += h2;
+		h2 += h1;
+
+		h1 = fmix_64(h1);
+		h2 = fmix_64(h2);
+
+		h1 += h2;
+		h2 += h1;
+
+		result[0] = h1;
+		result[1] = h2;
+	}
+
+	// Computes a 64-bit hash code using the Murmur3 method, with the optional seed.
+	// Returns the specified qword part of the 128-bit result.
+	template <typename Alloc>
+	unsigned long long basic_string<Alloc>::hash_code(hash_code_part part /*= hash_code_part::low*/, unsigned long long seed /*= 0*/) const
+	{
+		return string_view(*this).hash_code(part, seed);
+	}
+
+	// Formats to the specified buffer. Must be freed using free().
+	static bool do_format(char** result, const char* format, va_list ap)
+	{
+		if (format == nullptr || result == nullptr)
+			return false;
+
+		*result = nullptr;
+
+		size_t size = std::strlen(format) * 2 + 1;
+		char* buffer = (char*)std::malloc(size);
+
+		if (buffer == nullptr)
+			return false;
+
+		buffer[0] = '\0';
+
+		va_list tp;
+		va_copy(tp, ap);
+		int need = vsnprintf(buffer, size, format, tp);
+		va_end(tp);
+
+		if (need < 0)
+		{
+			std::free(buffer);
+			return false;
+		}
+		else if (size_t(need) >= size)
+		{
+			size = need + 1;
+			char* temp = (char*)std::realloc(buffer, size);
+
+			if (temp == nullptr)
+			{
+				std::free(buffer);
+				return false;
+			}
+			else buffer = temp;
+
+			buffer[0] = '\0';
+
+			va_copy(tp, ap);
+			need = vsnprintf(buffer, size, format, tp);
+			va_end(tp);
+
+			if (need < 0)
+			{
+				std::free(buffer);
+				return false;
+			}
+		}
+
+		*result = buffer;
+
+		return true;
+	}
+
+	// Formats and appends to this using the specified format string, and its arguments.
+	// Returns true if the operation succeeded, else false.
+	template <typename Alloc>
+	bool basic_string<Alloc>::append_format(const char* format, ...)
+	{
+		va_list ap;
+		va_start(ap, format);
+		char* buffer = nullptr;
+		bool succeeded = do_format(&buffer, format, ap);
+		va_end(ap);
+
+		if (succeeded && buffer != nullptr)
+		{
+			base_type::append(buffer);
+			std::free(buffer);
+
+			return true;
+		}
+		else return false;
+	}
+
+	// Attempts to format this using the specified format string, and optional arguments.
+	// Returns true if the operation succeeded, else false.
+	template <typename Alloc>
+	bool basic_string<Alloc>::format(const char* format, ...)
+	{
+		va_list ap;
+		va_start(ap, format);
+		char* buffer = nullptr;
+		bool succeeded = do_format(&buffer, format, ap);
+		va_end(ap);
+
+		if (succeeded && buffer != nullptr)
+		{
+			base_type::operator=(buffer);
+			std::free(buffer);
+
+			return true;
+		}
+		else return false;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(bool value)
+	{
+		static const char* true_str = "true";
+		static const char* false_str = "false";
+		base_type::append(value ? true_str : false_str);
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(unsigned char value)
+	{
+		char buffer[4] = { '\0' };
+		snprintf(buffer, 4, "%u", value);
+		base_type::append(buffer);
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(short value)
+	{
+		char buffer[8] = { '\0' };
+		snprintf(buffer, 8, "%d", value);
+		base_type::append(buffer);
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(unsigned short value)
+	{
+		char buffer[8] = { '\0' };
+		snprintf(buffer, 8, "%u", value);
+		base_type::append(buffer);
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(int value)
+	{
+		char buffer[16] = { '\0' };
+		snprintf(buffer, 16, "%d", value);
+		base_type::append(buffer);
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(unsigned int value)
+	{
+		char buffer[16] = { '\0' };
+		snprintf(buffer, 16, "%u", value);
+		base_type::append(buffer);
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(long value)
+	{
+		char buffer[16] = { '\0' };
+		snprintf(buffer, 16, "%ld", value);
+		base_type::append(buffer);
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(unsigned long value)
+	{
+		char buffer[16] = { '\0' };
+		snprintf(buffer, 16, "%lu", value);
+		base_type::append(buffer);
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(long long value)
+	{
+		char buffer[32] = { '\0' };
+		snprintf(buffer, 32, "%lld", value);
+		base_type::append(buffer);
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(unsigned long long value)
+	{
+		char buffer[32] = { '\0' };
+		snprintf(buffer, 32, "%llu", value);
+		base_type::append(buffer);
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(float value)
+	{
+		char buffer[32] = { '\0' };
+		snprintf(buffer, 32, "%f", value);
+		base_type::append(buffer);
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(double value)
+	{
+		char buffer[32] = { '\0' };
+		snprintf(buffer, 32, "%lf", value);
+		base_type::append(buffer);
+		return *this;
+	}
+
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::append(long double value)
+	{
+		char buffer[32] = { '\0' };
+		snprintf(buffer, 32, "%llf", value);
+		base_type::append(buffer);
+		return *this;
+	}
+
+	// Appends count generated characters to this by calling the specified method count times, 
+	// unless method returns '\0', in which case it stops.
+	// Returns this after the generation completes.
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::generate(size_t count, char (*method)(size_t index))
+	{
+		if (method == nullptr)
+			return *this;
+
+		base_type::clear();
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			char c = method(i);
+
+			if (c == '\0')
+				return *this;
+
+			append(c);
+		}
+
+		return *this;
+	}
+
+	// Takes the left-hand count of characters as a substring.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::left(size_t count) const
+	{ 
+		size_t n = base_type::length();
+
+		if (_null || n == 0 || count == 0) 
+			return basic_string(base_type::get_allocator());
+
+		if (count > n) count = n;
+
+		return basic_string(string_view(base_type::data(), count), base_type::get_allocator());
+	}
+
+	// Takes the right-hand count of characters as a substring.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::right(size_t count) const
+	{
+		size_t n = base_type::length();
+
+		if (_null || n == 0 || count == 0) 
+			return basic_string(base_type::get_allocator());
+
+		if (count > n) count = n;
+
+		size_t start = n - count;
+
+		return basic_string(string_view(base_type::data() + start, count), base_type::get_allocator());
+	}
+
+	template <typename Alloc>
+	std::vector<uint8_t> basic_string<Alloc>::get_bytes() const
+	{
+		if (is_empty())
+			return std::vector<uint8_t>();
+
+		const uint8_t m = 0xFF;
+
+		std::vector<uint8_t> result;
+
+		for (char c : *this)
+			result.push_back(uint8_t(c & m));
+		
+		return result;
+	}
+
+	// Returns whether this matches the regular expression, using the flags:
+	// std::regex_constants::extended | std::regex_constants::nosubs.
+	// If caseless is true, or C++17 and multiline is true, adds these flags
+	// as well.
+	template <typename Alloc>
+	bool basic_string<Alloc>::match(const char* expression, bool caseless /*= false*/
+#if __cplusplus > 201402L
+		, bool multiline /*= false*/
+#endif
+	) const
+	{
+		return string_view(*this).match(expression, caseless
+#if __cplusplus > 201402L
+			, multiline
+#endif
+		);
+	}
+
+	// Matches the expression like in match above, and returns all of the matches, 
+	// or an empty vector if no matches or is_empty.
+	template <typename Alloc>
+	std::vector<basic_string<Alloc>> basic_string<Alloc>::match_all(const char* expression, bool caseless /*= false*/
+#if __cplusplus > 201402L
+		, bool multiline /*= false*/
+#endif
+	) const
+	{
+		std::vector<basic_string> result;
+
+		if (expression == nullptr || is_empty())
+			return result;
+
+		auto flags = std::regex_constants::extended;
+
+		if (caseless) flags |= std::regex_constants::icase;
+
+#if __cplusplus > 201402L
+		if (multiline) flags |= std::regex_constants::multiline;
+#endif
+
+		std::cmatch parts;
+		token_copies<Alloc> copies = { result, base_type::get_allocator() };
+
+		find_matches(*regex_cache::get_compiled(expression, flags), parts, *this, copies);
+
+		return result;
+	}
+
+	// Matches the expression like in match above, and appends all of the matches to the
+	// contiguous table. Returns the count of matches appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::match_all(const char* expression, string_table& result, bool caseless /*= false*/
+#if __cplusplus > 201402L
+		, bool multiline /*= false*/
+#endif
+	) const
+	{
+		if (expression == nullptr || is_empty())
+			return 0;
+
+		auto flags = std::regex_constants::extended;
+
+		if (caseless) flags |= std::regex_constants::icase;
+
+#if __cplusplus > 201402L
+		if (multiline) flags |= std::regex_constants::multiline;
+#endif
+
+		std::cmatch parts;
+
+		return find_matches(*regex_cache::get_compiled(expression, flags), parts, *this, result);
+	}
+
+	// Matches the expression like in match above, and appends views of all of the matches
+	// to result, which can be reused across calls. Returns the count of matches appended.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::match_all(const char* expression, std::vector<string_view>& result, bool caseless /*= false*/
+#if __cplusplus > 201402L
+		, bool multiline /*= false*/
+#endif
+	) const
+	{
+		if (expression == nullptr || is_empty())
+			return 0;
+
+		auto flags = std::regex_constants::extended;
+
+		if (caseless) flags |= std::regex_constants::icase;
+
+#if __cplusplus > 201402L
+		if (multiline) flags |= std::regex_constants::multiline;
+#endif
+
+		std::cmatch parts;
+
+		return find_matches(*regex_cache::get_compiled(expression, flags), parts, *this, result);
+	}
+
+	// Matches the expression like in match above, appending views of the matches to result,
+	// but scans chunks of this on several threads, and merges them in order.
+	template <typename Alloc>
+	size_t basic_string<Alloc>::match_all(const char* expression, std::vector<string_view>& result, const chunking& chunks, bool caseless /*= false*/
+#if __cplusplus > 201402L
+		, bool multiline /*= false*/
+#endif
+	) const
+	{
+		if (expression == nullptr || is_empty())
+			return 0;
+
+		auto flags = std::regex_constants::extended;
+
+		if (caseless) flags |= std::regex_constants::icase;
+
+#if __cplusplus > 201402L
+		if (multiline) flags |= std::regex_constants::multiline;
+#endif
+
+		return find_matches(*regex_cache::get_compiled(expression, flags), *this, chunks, result);
+	}
+
+	// Matches the expression like in match above, and returns a lazy range over the matches,
+	// which searches for one match per increment, so that iteration can stop early.
+	template <typename Alloc>
+	match_range basic_string<Alloc>::match_each(const char* expression, bool caseless /*= false*/
+#if __cplusplus > 201402L
+		, bool multiline /*= false*/
+#endif
+	) const
+	{
+		return string_view(*this).match_each(expression, caseless
+#if __cplusplus > 201402L
+			, multiline
+#endif
+		);
+	}
+
+	// Reads the next literal character of format into c, unescaping {{ and }}, and advances past
+	// it. Returns false at a {}, a lone brace, or the end of format.
+	inline static bool format_next(const char*& format, char& c)
+	{
+		c = *format;
+
+		if (c == '\0')
+			return false;
+
+		if (c == '{' || c == '}')
+		{
+			if (format[1] != c)
+				return false;
+
+			format += 2;
+		}
+		else ++format;
+
+		return true;
+	}
+
+	// Matches the literal text of format against at, up to the next {} or the end of format.
+	template <typename Alloc>
+	bool basic_string<Alloc>::format_literal(const char*& format, const char*& at, const char* last)
+	{
+		char c = '\0';
+
+		while (format_next(format, c))
+		{
+			if (at == last || *at != c)
+				return false;
+
+			++at;
+		}
+
+		return format[0] == '{' && format[1] == '}';
+	}
+
+	// Finds the end of the field at at, whose {} is followed by format, or null if the literal
+	// text following it, which must match there, is not found.
+	template <typename Alloc>
+	const char* basic_string<Alloc>::format_field(const char* format, const char* at, const char* last)
+	{
+		if (*format == '\0')
+			return last;
+
+		if (format[0] == '{' && format[1] == '}')
+		{
+			while (at != last && !std::isspace((unsigned char)*at))
+				++at;
+
+			return at;
+		}
+
+		const char* text = format;
+		char head = '\0';
+
+		if (!format_next(text, head)) // A lone brace.
+			return nullptr;
+
+		// Find the first place the whole of the following literal text matches.
+		for (const char* p = at; p != last; ++p)
+		{
+			p = (const char*)std::memchr(p, head, size_t(last - p));
+
+			if (p == nullptr)
+				break;
+
+			const char* f = text;
+			const char* q = p + 1;
+			char c = '\0';
+			bool found = true;
+
+			while (found && format_next(f, c))
+				found = q != last && *q++ == c;
+
+			if (found)
+				return p;
+		}
+
+		return nullptr;
+	}
+
+	// Computes the total length of an escaped string.
+	template <typename Alloc>
+	inline static size_t escaped_length(const basic_string<Alloc>& value)
+	{
+		size_t result = 0;
+
+		for (const auto& ch : value)
+		{
+			switch (ch)
+			{
+			case '"': case '\\': case '\b': case '\f': case '\n': case '\r': case '\t': 
+				result += 2; break;
+			default:
+				result++;
+				if (ch <= 0x1F && ch >= 0x00) 
+					result += 5;
+				break;
+			}
+		}
+
+		return result;
+	}
+
+	// Escapes this string using C-style or JSON escape sequences. Return *this.
+	template <typename Alloc>
+	inline static basic_string<Alloc> escape_json(basic_string<Alloc>& value)
+	{
+		size_t n = value.length();
+
+		if (n == 0) return basic_string<Alloc>(value);
+
+		const size_t size = escaped_length(value);
+
+		if (size == n) return basic_string<Alloc>(value);
+
+		size_t i = 0;
+		basic_string<Alloc> result(size, '\\');
+
+		for (const auto& c : value)
+		{
+			switch (c)
+			{
+			case  '"': result[i + 1] = '"'; i += 2; break;
+			case '\\': i += 2; break;
+			case '\b': result[i + 1] = 'b'; i += 2; break;
+			case '\f': result[i + 1] = 'f'; i += 2; break;
+			case '\n': result[i + 1] = 'n'; i += 2; break;
+			case '\r': result[i + 1] = 'r'; i += 2; break;
+			case '\t': result[i + 1] = 't'; i += 2; break;
+			default:
+				if (c >= 0x00 && c <= 0x1F)
+				{
+					char code[8];
+					snprintf(code, sizeof(code), "u%04X", int(c));
+					std::memcpy(&result[i + 1], code, 5);
+					i += 6;
+				}
+				else result[i++] = c;
+				break;
+			}
+		}
+
+		return result;
+	}
+
+	inline static bool parse_octal(const char* src, size_t& i, size_t& n, char* dst, size_t& j)
+	{
+		if ((long(n) - long(i)) < 2 || !string::is_one_of(src[i], "01234567") || !string::is_one_of(src[i + 1], "01234567")) 
+			return false;
+
+		dst[j] = ((src[i] - '0') * 8) + (src[i + 1] - '0');
+
+		char buffer[4] = { src[i + 0], src[i + 1], '\0', '\0' };
+
+		i += 2;
+		dst[j] = char(strtoul(buffer, nullptr, 8) & 0xFFU);
+		++j;
+
+		return true;
+	}
+
+	inline static bool parse_hexadecimal(const char* src, size_t& i, size_t& n, char* dst, size_t& j)
+	{
+		if ((long(n) - long(i)) < 2) 
+			return false;
+
+		char buffer[4] = { src[i + 0], src[i + 1], '\0', '\0' };
+
+		i += 2;
+		dst[j] = char(strtoul(buffer, nullptr, 16) & 0xFFU);
+		++j;
+
+		return true;
+	}
+
+	inline static bool parse_unicode(const char* src, size_t& i, size_t& n, char* dst, size_t& j)
+	{
+		if ((long(n) - long(i)) < 4) 
+			return false;
+
+		char buffer[8] = { src[i], src[i + 1], src[i + 2], src[i + 3], '\0', };
+
+		i += 4;
+
+		unsigned long code = strtoul(buffer, nullptr, 16) & 0xFFFFU; // Encode as UTF-8.
+
+		if (code < 0x80U)
+			dst[j++] = char(code);
+		else if (code < 0x800U)
+		{
+			dst[j++] = char(0xC0U | (code >> 6));
+			dst[j++] = char(0x80U | (code & 0x3FU));
+		}
+		else
+		{
+			dst[j++] = char(0xE0U | (code >> 12));
+			dst[j++] = char(0x80U | ((code >> 6) & 0x3FU));
+			dst[j++] = char(0x80U | (code & 0x3FU));
+		}
+
+		return true;
+	}
+
+	// Removes UTF-8 C-style or JSON escapes from this.
+	template <typename Alloc>
+	inline static bool unescape_json(basic_string<Alloc>& value, basic_string<Alloc>& result)
+	{
+		size_t n = value.length();
+
+		result.clear();
+
+		if (n == 0) return true;
+
+		result.resize(n); // Unescaping never lengthens.
+
+		const char* src = value.c_str();
+		char* dst = &result[0];
+		size_t j = 0;
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			char c1 = src[i];
+
+			if (c1 == '\\' && (i + 1) < n)
+			{
+				char c2 = src[++i];
+
+				switch (c2)
+				{
+				case 'a': dst[j++] = 0x07; break;
+				case 'b': dst[j++] = 0x08; break;
+				case 'f': dst[j++] = 0x0C; break;
+				case 'n': dst[j++] = 0x0A; break;
+				case 'r': dst[j++] = 0x0D; break;
+				case 't': dst[j++] = 0x09; break;
+				case 'v': dst[j++] = 0x0B; break;
+				case '\\': dst[j++] = 0x5C; break;
+				case '\'': dst[j++] = 0x27; break;
+				case '"': dst[j++] = 0x22; break;
+				case '/': dst[j++] = 0x2F; break;
+				case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
+					if (!parse_octal(src, i, n, dst, j)) 
+						return false; 
+					--i; // The loop steps past the last digit.
+					break;
+				case 'x': 
+					if (!parse_hexadecimal(src, ++i, n, dst, j)) 
+						return false; 
+					--i;
+					break;
+				case 'u': 
+					if (!parse_unicode(src, ++i, n, dst, j)) 
+						return false; 
+					--i;
+					break;
+				default: 
+					dst[j++] = c1, dst[j++] = c2; 
+					break;
+				}
+			}
+			else dst[j++] = c1;
+		}
+
+		result.resize(j);
+
+		return true;
+	}
+
+	static std::mutex string_escape_url_mutex_;
+	static bool string_escape_url_initialized_ = false;
+	static char string_escape_url_rfc3986_[256] = { 0 };
+	static char string_escape_url_html5_[256] = { 0 };
+	static const char string_escape_url_hex_[] = "0123456789ABCDEF";
+
+	void string_escape_url_initialize()
+	{
+		if (string_escape_url_initialized_)
+			return;
+
+		string_escape_url_mutex_.lock();
+
+		if (string_escape_url_initialized_)
+		{
+			string_escape_url_mutex_.unlock();
+			return;
+		}
+
+		for (size_t i = 0; i < 256; ++i)
+		{
+			string_escape_url_rfc3986_[i] = 
+				std::isalnum(i) || i == '~' || i == '-' || i == '.' || i == '_' ? i : 0;
+
+			string_escape_url_html5_[i] = 
+				std::isalnum(i) || i == '*' || i == '-' || i == '.' || i == '_' ? i : i == ' ' ? '+' : 0;
+		}
+
+		string_escape_url_initialized_ = true;
+
+		string_escape_url_mutex_.unlock();
+	}
+
+	inline static void escape_url_hex(unsigned value, char* result)
+	{
+		result[0] = string_escape_url_hex_[(value / 16U) % 16U];
+		result[1] = string_escape_url_hex_[value % 16U];
+	}
+
+	template <typename Alloc>
+	inline static basic_string<Alloc> escape_url(const char* table, basic_string<Alloc>& value)
+	{
+		string_escape_url_initialize();
+
+		basic_string<Alloc> result;
+
+		if (value.length() == 0)
+			return result;
+
+		const char* s = value.c_str();
+		char temp[2];
+
+		for (; *s; ++s) 
+		{
+			temp[0] = '\0';
+
+			unsigned char c = (unsigned char)*s;
+
+			if (table[c])
+				result.push_back(table[c]);
+			else
+			{
+				result.push_back('%');
+				escape_url_hex(c, temp);
+				result.push_back(temp[0]);
+				result.push_back(temp[1]);
+			}
+		}
+
+		return result;
+	}
+
+	const char* escape_entities_table_[] =
+	{
+		"nbsp",
+		"iexcl",
+		"cent",
+		"pound",
+		"curren",
+		"yen",
+		"brvbar",
+		"sect",
+		"uml",
+		"copy",
+		"ordf",
+		"laquo",
+		"not",
+		"shy",
+		"reg",
+		"macr",
+		"deg",
+		"plusmn",
+		"sup2",
+		"sup3",
+		"acute",
+		"micro",
+		"para",
+		"middot",
+		"cedil",
+		"sup1",
+		"ordm",
+		"raquo",
+		"frac14",
+		"frac12",
+		"frac34",
+		"iquest",
+		"Agrave",
+		"Aacute",
+		"Acirc",
+		"Atilde",
+		"Auml",
+		"Aring",
+		"AElig",
+		"Ccedil",
+		"Egrave",
+		"Eacute",
+		"Ecirc",
+		"Euml",
+		"Igrave",
+		"Iacute",
+		"Icirc",
+		"Iuml",
+		"ETH",
+		"Ntilde",
+		"Ograve",
+		"Oacute",
+		"Ocirc",
+		"Otilde",
+		"Ouml",
+		"times",
+		"Oslash",
+		"Ugrave",
+		"Uacute",
+		"Ucirc",
+		"Uuml",
+		"Yacute",
+		"THORN",
+		"szlig",
+		"agrave",
+		"aacute",
+		"acirc",
+		"atilde",
+		"auml",
+		"aring",
+		"aelig",
+		"ccedil",
+		"egrave",
+		"eacute",
+		"ecirc",
+		"euml",
+		"igrave",
+		"iacute",
+		"icirc",
+		"iuml",
+		"eth",
+		"ntilde",
+		"ograve",
+		"oacute",
+		"ocirc",
+		"otilde",
+		"ouml",
+		"divide",
+		"oslash",
+		"ugrave",
+		"uacute",
+		"ucirc",
+		"uuml",
+		"yacute",
+		"thorn",
+		"yuml",
+		nullptr
+	};
+
+	// Just the ASCII.
+	template <typename Alloc>
+	inline static basic_string<Alloc> escape_entities(const basic_string<Alloc>& value)
+	{
+		basic_string<Alloc> result;
+
+		const char* s = value.c_str();
+
+		for (; *s; ++s)
+		{
+			switch (*s)
+			{
+			case '\'': result.append("&apos;"); break;
+			case '"': result.append("&quot;"); break;
+			case '&': result.append("&amp;"); break;
+			case '<': result.append("&lt;"); break;
+			case '>': result.append("&gt;"); break;
+			case char(0x80): result.append("&euro;"); break;
+			case char(0x85): result.append("&hellip;"); break;
+			case char(0x86): result.append("&dagger;"); break;
+			case char(0x87): result.append("&ddagger;"); break;
+			case char(0x89): result.append("&permil;"); break;
+			case char(0x95): result.append("&bullet"); break;
+			case char(0x96): result.append("&endash;"); break;
+			case char(0x97): result.append("&emdash;"); break;
+			case char(0x99): result.append("&trade;"); break;
+			default:
+				if ((unsigned char)*s >= 0xA0U)
+				{
+					result.append('&');
+					result.append(escape_entities_table_[((unsigned char)*s - 0xA0U)]);
+					result.append(';');
+				}
+				else result.append(*s);
+				break;
+			}
+		}
+
+		return result;
+	}
+
+	typedef struct entity_entry_s
+	{
+		const char* name;
+		unsigned value;
+	}
+	entity_entry_t;
+
+	static const entity_entry_t string_unescape_entity_names_[] =
+	{
+		{ "nbsp", 160 },
+		{ "iexcl", 161 },
+		{ "cent", 162 },
+		{ "pound", 163 },
+		{ "curren", 164 },
+		{ "yen", 165 },
+		{ "brvbar", 166 },
+		{ "sect", 167 },
+		{ "uml", 168 },
+		{ "copy", 169 },
+		{ "ordf", 170 },
+		{ "laquo", 171 },
+		{ "not", 172 },
+		{ "shy", 173 },
+		{ "reg", 174 },
+		{ "macr", 175 },
+		{ "deg", 176 },
+		{ "plusmn", 177 },
+		{ "sup2", 178 },
+		{ "sup3", 179 },
+		{ "acute", 180 },
+		{ "micro", 181 },
+		{ "para", 182 },
+		{ "middot", 183 },
+		{ "cedil", 184 },
+		{ "sup1", 185 },
+		{ "ordm", 186 },
+		{ "raquo", 187 },
+		{ "frac14", 188 },
+		{ "frac12", 189 },
+		{ "frac34", 190 },
+		{ "iquest", 191 },
+		{ "Agrave", 192 },
+		{ "Aacute", 193 },
+		{ "Acirc", 194 },
+		{ "Atilde", 195 },
+		{ "Auml", 196 },
+		{ "Aring", 197 },
+		{ "AElig", 198 },
+		{ "Ccedil", 199 },
+		{ "Egrave", 200 },
+		{ "Eacute", 201 },
+		{ "Ecirc", 202 },
+		{ "Euml", 203 },
+		{ "Igrave", 204 },
+		{ "Iacute", 205 },
+		{ "Icirc", 206 },
+		{ "Iuml", 207 },
+		{ "ETH", 208 },
+		{ "Ntilde", 209 },
+		{ "Ograve", 210 },
+		{ "Oacute", 211 },
+		{ "Ocirc", 212 },
+		{ "Otilde", 213 },
+		{ "Ouml", 214 },
+		{ "times", 215 },
+		{ "Oslash", 216 },
+		{ "Ugrave", 217 },
+		{ "Uacute", 218 },
+		{ "Ucirc", 219 },
+		{ "Uuml", 220 },
+		{ "Yacute", 221 },
+		{ "THORN", 222 },
+		{ "szlig", 223 },
+		{ "agrave", 224 },
+		{ "aacute", 225 },
 		{ "acirc", 226 },
 		{ "atilde", 227 },
 		{ "auml", 228 },
@@ -2919,337 +5903,2306 @@ namespace super
 		{ nullptr, 0 }
 	};
 
-	static bool string_unescape_entity_initialized_ = false;
-	static std::mutex string_unescape_entity_mutex_;
-	static std::map<std::string, unsigned> string_unescape_entity_map_;
+	static bool string_unescape_entity_initialized_ = false;
+	static std::mutex string_unescape_entity_mutex_;
+	static std::map<std::string, unsigned> string_unescape_entity_map_;
+
+	static void string_unescape_entity_initialize()
+	{
+		if (string_unescape_entity_initialized_)
+			return;
+
+		string_unescape_entity_mutex_.lock();
+
+		if (string_unescape_entity_initialized_)
+		{
+			string_unescape_entity_mutex_.unlock();
+
+			return;
+		}
+
+		const entity_entry_t* p = string_unescape_entity_names_;
+
+		for (;;)
+		{
+			if (p->name == nullptr)
+				break;
+
+			string_unescape_entity_map_.insert(std::pair<std::string, unsigned>(p->name, p->value));
+
+			++p;
+		}
+
+		string_unescape_entity_initialized_ = true;
+		string_unescape_entity_mutex_.unlock();
+	}
+
+	// Expands any known XML/HTML entity references into literal
+	// UTF-8 characters.
+	template <typename Alloc>
+	inline static std::string unescape_entities(const basic_string<Alloc>& value)
+	{
+		std::istringstream is(value);
+		std::ostringstream os;
+
+		string_unescape_entity_initialize();
+
+		std::string mn;
+		unsigned cc;
+		bool pc, gc;
+
+		enum class state
+		{
+			none,
+			begin,
+			name,
+			number,
+			decimal,
+			hexadecimal,
+		}
+		ms = state::none;
+
+		for (;;)
+		{
+			const unsigned char ch = is.get();
+
+			if (is.eof()) 
+				break;
+
+			pc = false;
+			gc = false;
+
+			switch (ms)
+			{
+			case state::begin:
+
+				if (ch == '#')
+				{
+					ms = state::number;
+					pc = true;
+				}
+				else if (ch >= 'a' && ch <= 'z' || ch >= 'A' && ch <= 'Z')
+				{
+					mn.append(1, ch);
+					ms = state::name;
+					pc = true;
+				}
+				else
+				{
+					os.put('&');
+					ms = state::none;
+				}
+
+				break;
+
+			case state::name:
+
+				if (ch >= 'a' && ch <= 'z' || ch >= 'A' && ch <= 'Z' || ch >= '0' && ch <= '9')
+				{
+					mn.append(1, ch);
+					pc = true;
+				}
+				else if (ch == ';')
+				{
+					auto e = string_unescape_entity_map_.find(mn);
+
+					if (e != string_unescape_entity_map_.end())
+					{
+						cc = e->second;
+						pc = true;
+						gc = true;
+					}
+				}
+
+				if (!pc)
+				{
+					os.put('&');
+
+					size_t n = mn.size();
+
+					for (size_t i = 0; i < n; ++i)
+						os.put(mn[i]);
+
+					ms = state::none;
+				}
+
+				break;
+
+			case state::number:
+
+				if (ch == 'x' || ch == 'X')
+				{
+					pc = true;
+					ms = state::hexadecimal;
+					cc = 0;
+				}
+				else if (ch >= '0' && ch <= '9')
+				{
+					cc = ch - '0';
+					ms = state::decimal;
+					pc = true;
+				}
+				else ms = state::none;
+
+				break;
+
+			case state::decimal:
+
+				if (ch >= '0' && ch <= '9')
+				{
+					cc = cc * 10 + ch - '0';
+					pc = true;
+				}
+				else if (ch == ';')
+				{
+					pc = true;
+					gc = true;
+				}
+				else ms = state::none;
+
+				break;
+
+			case state::hexadecimal:
+
+				if (ch >= '0' && ch <= '9')
+				{
+					cc = cc * 16 + ch - '0';
+					pc = true;
+				}
+				else if (ch >= 'a' && ch <= 'f')
+				{
+					cc = cc * 16 + ch - 'a' + 10;
+					pc = true;
+				}
+				else if (ch >= 'A' && ch <= 'F')
+				{
+					cc = cc * 16 + ch - 'A' + 10;
+					pc = true;
+				}
+				else if (ch == ';')
+				{
+					pc = true;
+					gc = true;
+				}
+				else ms = state::none;
+
+				break;
+			}
+
+			if (gc)
+			{
+				if (cc >= 0x800U)
+				{
+					os.put(0xE0 | (cc >> 12) & 0x0FU);
+					os.put(0x80 | (cc >> 6) & 0x3FU);
+					os.put(0x80 | cc & 0x3FU);
+				}
+				else if (cc >= 0x80U)
+				{
+					os.put(0xC0 | (cc >> 6) & 0x1FU);
+					os.put(0x80 | cc & 0x3FU);
+				}
+				else os.put(cc);
+
+				ms = state::none;
+			}
+			else if (!pc && ms == state::none)
+			{
+				if (ch == '&')
+				{
+					ms = state::begin;
+					mn.erase();
+				}
+				else os.put(ch);
+			}
+		}
+
+		return os.str();
+	}
+
+	inline static char unescape_url_hex(char value)
+	{ return isdigit(value) ? value - char('0') : tolower(value) - char('a') + 10; }
+
+	template <typename Alloc>
+	inline static std::string unescape_url(const basic_string<Alloc>& value)
+	{
+		std::ostringstream os;
+
+		os.fill('0');
+
+		auto n = value.end();
+
+		for (auto i = value.begin(); i != n; ++i)
+		{
+			char c = *i;
+
+			if (c == '%') 
+			{
+				if (n - i > 2 && i[1] && i[2])
+				{
+					char h = unescape_url_hex(i[1]) << 4 | unescape_url_hex(i[2]);
+					os << h;
+					i += 2;
+				}
+			}
+			else if (c == '+') 
+				os << ' ';
+			else os << c;
+		}
+
+		return os.str();
+	}
+
+	// Escaping for literal patterns used in regular expressions.
+	template <typename Alloc>
+	inline static basic_string<Alloc> escape_regex(const basic_string<Alloc>& value)
+	{
+		basic_string<Alloc> result;
+
+		for (char c : value)
+		{
+			bool e = false;
+
+			switch (c)
+			{
+			case '\t': e = true, c = 't'; break;
+			case '\n': e = true, c = 'n'; break;
+			case '\r': e = true, c = 'r'; break;
+			case '\v': e = true, c = 'v'; break;
+			case '\f': e = true, c = 'f'; break;
+			case '.': case '^': case '$': case '*': case '+': case '-': case '?':
+			case '(': case ')': case '[': case ']': case '{': case '}': case '\\': case '/':
+				e = true; break;
+			default: break;
+			}
+
+			if (e)
+			{
+				result.append('\\');
+				result.append(c);
+			}
+			else result.append(c);
+		}
+
+		return result;
+	}
+
+	// Escapes this string, in place.
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::escape(escaping value) &
+	{
+		switch (value)
+		{
+		case escaping::json: 
+			assign(escape_json(*this)); 
+			break;
+		case escaping::url: 
+			assign(escape_url(string_escape_url_html5_, *this)); 
+			break;
+		case escaping::rfc3986: 
+			assign(escape_url(string_escape_url_rfc3986_, *this)); 
+			break;
+		case escaping::entities: 
+			assign(escape_entities(*this)); 
+			break;
+		case escaping::regex:
+			assign(escape_regex(*this));
+			break;
+		default: return *this;
+		}
+
+		return *this;
+	}
+
+	// Copies this and returns an escaped copy.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::escape(escaping value) const &
+	{
+		return clone().escape(value);
+	}
+
+	// Escapes this temporary, in place, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::escape(escaping value) &&
+	{
+		return std::move(escape(value));
+	}
+
+	// Removes the specified escaping from this.
+	template <typename Alloc>
+	basic_string<Alloc>& basic_string<Alloc>::unescape(escaping value) &
+	{
+		switch (value)
+		{
+		case escaping::json: 
+		{
+			basic_string result;
+			if (!unescape_json(*this, result))
+				return *this;
+			assign(result);
+			return *this;
+		}
+		case escaping::rfc3986:
+		case escaping::url:
+			return assign(unescape_url(*this));
+		case escaping::entities:
+			return assign(unescape_entities(*this));
+		case escaping::regex:
+			// TODO
+		default: return *this;
+		}
+	}
+
+	// Copies then removes the specified escaping from the copy.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::unescape(escaping value) const &
+	{
+		return clone().unescape(value);
+	}
+
+	// Removes the specified escaping from this temporary, in place, and moves it out.
+	template <typename Alloc>
+	basic_string<Alloc> basic_string<Alloc>::unescape(escaping value) &&
+	{
+		return std::move(unescape(value));
+	}
+
+	// Copies the viewed characters into a new string, preserving null.
+	string string_view::to_string() const
+	{
+		return string(*this);
+	}
+
+	// Compares this view with value, from left to right, returning the relative difference.
+	// Returns 1 if this is greater than value, -1 if value is greater than this, else 0 if they are equal.
+	int string_view::compare_to(const char* value) const
+	{
+		return compare_to(string_view(value));
+	}
+
+	// Compares this view with value, from left to right, returning the relative difference.
+	// Returns 1 if this is greater than value, -1 if value is greater than this, else 0 if they are equal.
+	int string_view::compare_to(const string_view& value) const
+	{
+		if (value._null)
+		{
+			if (_null)
+				return 0;
+			else return 1;
+		}
+
+		if (_null)
+			return -1;
+
+		const char* p = _data;
+		const char* q = value._data;
+		const char* p_end = p + _length;
+		const char* q_end = q + value._length;
+
+		for (; p < p_end && q < q_end; ++p, ++q)
+		{
+			int d = *p - *q;
+
+			if (d != 0)
+				return d;
+		}
+
+		if (p < p_end)
+			return 1;
+		else if (q < q_end)
+			return -1;
+		else return 0;
+	}
+
+	// Compares this view with value, from right to left, returning the relative difference.
+	// Returns 1 if this is greater than value, -1 if value is greater than this, else 0 if they are equal.
+	int string_view::reverse_compare_to(const char* value) const
+	{
+		return reverse_compare_to(string_view(value));
+	}
+
+	// Compares this view with value, from right to left, returning the relative difference.
+	// Returns 1 if this is greater than value, -1 if value is greater than this, else 0 if they are equal.
+	int string_view::reverse_compare_to(const string_view& value) const
+	{
+		if (value._null)
+		{
+			if (_null)
+				return 0;
+			else return 1;
+		}
+
+		if (_null)
+			return -1;
+
+		size_t m = _length;
+		size_t n = value._length;
+
+		for (; m > 0 && n > 0; --m, --n)
+		{
+			int d = _data[m - 1] - value._data[n - 1];
+
+			if (d != 0)
+				return d;
+		}
+
+		if (m > 0)
+			return 1;
+		else if (n > 0)
+			return -1;
+		else return 0;
+	}
+
+	// Computes the Levenshtein distance between this and value.
+	unsigned long long string_view::distance(const string_view& value) const
+	{
+		size_t m = value._length;
+		size_t n = _length;
+
+		if (n == 0) return m;
+		else if (m == 0) return n;
+
+		m++, n++;
+
+		std::vector<std::vector<unsigned long long>> delta(n);
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			delta[i].resize(m);
+			delta[i][0] = i;
+		}
+
+		for (size_t i = 0; i < m; ++i)
+			delta[0][i] = i;
+
+		const char* const pp = _data;
+		const char* const qq = value._data;
+
+		for (size_t i = 1; i < n; ++i)
+		{
+			const char p = pp[i - 1];
+
+			for (size_t j = 1; j < m; ++j)
+			{
+				const char q = qq[j - 1];
+
+				unsigned long long cost = std::min(delta[i - 1][j] + 1,
+					std::min(delta[i][j - 1] + 1, delta[i - 1][j - 1] + ((p == q) ? 0 : 1)));
+
+				if (i > 2 && j > 2)
+				{
+					unsigned long long t = delta[i - 2][j - 2] + 1;
+
+					if (pp[i - 2] != q) t++;
+					if (p != qq[j - 2]) t++;
+
+					if (cost > t)
+						cost = t;
+				}
+
+				delta[i][j] = cost;
+			}
+		}
+
+		return delta[n - 1][m - 1];
+	}
+
+	// Computes a 64-bit hash code using the Murmur3 method, with the optional seed.
+	// Returns the specified qword part of the 128-bit result.
+	unsigned long long string_view::hash_code(hash_code_part part /*= hash_code_part::low*/, unsigned long long seed /*= 0*/) const
+	{
+		if (_null) // Special case 1.
+			return 0ULL;
+
+		if (_length == 0) // Special case 2.
+			return ~0ULL;
+
+		uint64_t result[2] = { 0, 0 };
+
+		murmur3_x64_128(_data, _length * sizeof(char), seed, result);
+
+		if (part == hash_code_part::both)
+			return result[0] ^ result[1];
+		else if (part == hash_code_part::high)
+			return result[1];
+		else return result[0];
+	}
+
+	// Returns whether this matches the regular expression, as in string::match.
+	bool string_view::match(const char* expression, bool caseless /*= false*/
+#if __cplusplus > 201402L
+		, bool multiline /*= false*/
+#endif
+	) const
+	{
+		if (expression == nullptr || is_empty())
+			return false;
+
+		auto flags = std::regex_constants::extended;
+
+		if (caseless) flags |= std::regex_constants::icase;
+
+#if __cplusplus > 201402L
+		if (multiline) flags |= std::regex_constants::multiline;
+#endif
+
+		auto compiled = regex_cache::get_compiled(expression, flags);
+		const char* start = compiled->start(begin(), end());
+
+		if (start == nullptr)
+			return false;
+
+		if (compiled->dfa.is_valid())
+			return compiled->dfa.search(begin(), start, end());
+
+		return std::regex_search(start, end(), compiled->regex, regex_cache::compiled::flags(begin(), start));
+	}
+
+	// Ranges lazily over the matches of the expression, as in string::match_each.
+	match_range string_view::match_each(const char* expression, bool caseless /*= false*/
+#if __cplusplus > 201402L
+		, bool multiline /*= false*/
+#endif
+	) const
+	{
+		auto flags = std::regex_constants::extended;
+
+		if (caseless) flags |= std::regex_constants::icase;
+
+#if __cplusplus > 201402L
+		if (multiline) flags |= std::regex_constants::multiline;
+#endif
+
+		return match_range(*this, expression, flags);
+	}
+
+	// Gets the subview at start, with count characters.
+	string_view string_view::substring(size_t start, size_t count /*= npos*/) const
+	{
+		if (is_empty())
+			return *this;
+
+		if (start >= _length)
+			return string_view(nullptr);
+
+		if (count == npos || (start + count) > _length)
+			count = _length - start;
+
+		return string_view(_data + start, count);
+	}
+
+	// Takes the left-hand count of characters as a subview.
+	string_view string_view::left(size_t count) const
+	{
+		if (is_empty() || count == 0)
+			return string_view();
+
+		if (count > _length) count = _length;
+
+		return string_view(_data, count);
+	}
+
+	// Takes the right-hand count of characters as a subview.
+	string_view string_view::right(size_t count) const
+	{
+		if (is_empty() || count == 0)
+			return string_view();
+
+		if (count > _length) count = _length;
+
+		return string_view(_data + (_length - count), count);
+	}
+
+	// Gets the subview without leading whitespace.
+	string_view string_view::trim_left() const
+	{
+		if (is_empty())
+			return *this;
+
+		size_t i = 0;
+
+		while (i < _length && std::isspace((unsigned char)_data[i]))
+			++i;
+
+		return string_view(_data + i, _length - i);
+	}
+
+	// Gets the subview without leading occurences of the specified characters.
+	string_view string_view::trim_left(const char* chars) const
+	{
+		if (is_empty() || chars == nullptr)
+			return *this;
+
+		size_t i = 0;
+
+		while (i < _length && string::is_one_of(_data[i], chars))
+			++i;
+
+		return string_view(_data + i, _length - i);
+	}
+
+	// Gets the subview without following whitespace.
+	string_view string_view::trim_right() const
+	{
+		if (is_empty())
+			return *this;
+
+		size_t i = _length;
+
+		while (i > 0 && std::isspace((unsigned char)_data[i - 1]))
+			--i;
+
+		return string_view(_data, i);
+	}
+
+	// Gets the subview without following occurences of the specified characters.
+	string_view string_view::trim_right(const char* chars) const
+	{
+		if (is_empty() || chars == nullptr)
+			return *this;
+
+		size_t i = _length;
+
+		while (i > 0 && string::is_one_of(_data[i - 1], chars))
+			--i;
+
+		return string_view(_data, i);
+	}
+
+	// Gets the subview without leading and following whitespace.
+	string_view string_view::trim() const
+	{
+		return trim_left().trim_right();
+	}
+
+	// Gets the subview without leading and following occurences of the specified characters.
+	string_view string_view::trim(const char* chars) const
+	{
+		return trim_left(chars).trim_right(chars);
+	}
+
+	// True if this is composed only of the given characters (excluding the terminating null).
+	bool string_view::consists_of(const char* chars) const
+	{
+		if (chars == nullptr || is_empty())
+			return false;
+
+		for (const char* p = _data, *e = _data + _length; p < e; ++p)
+			if (!string::is_one_of(*p, chars))
+				return false;
+
+		return true;
+	}
+
+	// True if the count characters at p and q are equal, optionally ignoring case.
+	inline static bool equals(const char* p, const char* q, size_t count, bool insensitive)
+	{
+		if (!insensitive)
+			return std::memcmp(p, q, count) == 0;
+
+		for (size_t i = 0; i < count; ++i)
+			if (std::tolower((unsigned char)p[i]) != std::tolower((unsigned char)q[i]))
+				return false;
+
+		return true;
+	}
+
+	// True if value equals the null-terminated text, ignoring case.
+	inline static bool equals_caseless(const string_view& value, const char* text)
+	{
+		size_t n = std::strlen(text);
+
+		return value.length() == n && equals(value.data(), text, n, true);
+	}
+
+	// True if this starts with value. If insensitive is true, then compare caseless.
+	bool string_view::starts_with(const char* value, bool insensitive /*= false*/) const
+	{
+		if (_null && value == nullptr)
+			return true;
+		else if (value == nullptr)
+			return false;
+
+		size_t n = std::strlen(value);
+
+		if (_length < n)
+			return false;
+
+		return equals(_data, value, n, insensitive);
+	}
+
+	// True if this ends with value. If insensitive is true, then compare caseless.
+	bool string_view::ends_with(const char* value, bool insensitive /*= false*/) const
+	{
+		if (_null && value == nullptr)
+			return true;
+		else if (value == nullptr)
+			return false;
+
+		size_t n = std::strlen(value);
+
+		if (_length < n)
+			return false;
+
+		return equals(_data + (_length - n), value, n, insensitive);
+	}
+
+	// Narrows an offset to the int the index_of variants return, as -1 if npos or past INT_MAX.
+	inline static int int_offset(size_t offset)
+	{
+		return offset > size_t(INT_MAX) ? -1 : int(offset);
+	}
+
+	// Finds the first index of value, from left to right, starting at the optional offset.
+	// Returns the index, or -1 if not found.
+	int string_view::index_of(char value, size_t start /*= npos*/) const
+	{
+		return int_offset(offset_of(value, start == npos ? 0 : start));
+	}
+
+	// Finds the last index of value, from right to left, starting at the optional offset from end.
+	// Returns the index, or -1 if not found.
+	int string_view::last_index_of(char value, size_t start /*= npos*/) const
+	{
+		return int_offset(last_offset_of(value, start == npos ? 0 : start));
+	}
+
+	// Finds the first index of the substring value, from left to right, starting at the optional
+	// offset. Returns the index, or -1 if not found.
+	int string_view::index_of(const string_view& value, size_t start /*= npos*/) const
+	{
+		return int_offset(offset_of(value, start == npos ? 0 : start));
+	}
+
+	// Finds the last index of the substring value, from right to left, starting at the optional
+	// offset from end. Returns the index, or -1 if not found.
+	int string_view::last_index_of(const string_view& value, size_t start /*= npos*/) const
+	{
+		return int_offset(last_offset_of(value, start == npos ? 0 : start));
+	}
+
+	// Finds the first offset of value at or after start, by memchr, which C libraries vectorize.
+	size_t string_view::offset_of(char value, size_t start /*= 0*/) const
+	{
+		if (start >= _length)
+			return npos;
+
+		const char* p = (const char*)std::memchr(_data + start, value, _length - start);
+
+		return p == nullptr ? npos : size_t(p - _data);
+	}
+
+	// Finds the last offset of value, skipping start characters from the end, a vector at a time.
+	size_t string_view::last_offset_of(char value, size_t start /*= 0*/) const
+	{
+		if (start >= _length)
+			return npos;
+
+		const char* p = find_last_byte(_data, _data + (_length - start), value);
+
+		return p == nullptr ? npos : size_t(p - _data);
+	}
+
+	// Finds the first offset of value at or after start. Candidates are filtered by find_pair on
+	// the first and last characters of value, and compared in full only if both match.
+	size_t string_view::offset_of(const string_view& value, size_t start /*= 0*/) const
+	{
+		const size_t n = value.length();
+
+		if (start > _length || _length - start < n)
+			return npos;
+
+		if (n <= 1)
+			return n == 0 ? start : offset_of(value[0], start);
+
+		const byte_pair pair = { 0, n - 1, (unsigned char)value[0], (unsigned char)value[n - 1], 0, 0 };
+		const char* p = find_pair(pair, _data + start, _data + _length - n + 1, [&](const char* q) { return std::memcmp(q + 1, value.data() + 1, n - 2) == 0; });
+
+		return p == nullptr ? npos : size_t(p - _data);
+	}
+
+	// Finds the last offset of value which ends at least start characters from the end, as
+	// offset_of does but from the end.
+	size_t string_view::last_offset_of(const string_view& value, size_t start /*= 0*/) const
+	{
+		const size_t n = value.length();
+
+		if (start > _length || _length - start < n)
+			return npos;
+
+		if (n <= 1)
+			return n == 0 ? _length - start : last_offset_of(value[0], start);
+
+		const byte_pair pair = { 0, n - 1, (unsigned char)value[0], (unsigned char)value[n - 1], 0, 0 };
+		const char* p = find_last_pair(pair, _data, _data + (_length - start) - n + 1, [&](const char* q) { return std::memcmp(q + 1, value.data() + 1, n - 2) == 0; });
+
+		return p == nullptr ? npos : size_t(p - _data);
+	}
+
+	// Finds the first offset of the needle of searcher at or after start.
+	// Returns the offset, or npos if not found.
+	size_t string_view::offset_of(const searcher& value, size_t start /*= 0*/) const
+	{
+		return value.find(*this, start);
+	}
+
+	// True if this contains the substring value.
+	bool string_view::contains(const string_view& value) const
+	{
+		return offset_of(value) != npos;
+	}
+
+	// True if this contains the needle of searcher.
+	bool string_view::contains(const searcher& value) const
+	{
+		return value.find(*this) != npos;
+	}
+
+	// Counts the instances of the character value in this.
+	size_t string_view::count(char value) const
+	{
+		return count_byte(begin(), end(), value);
+	}
+
+	// Counts the characters of this which are in set. A null set has none.
+	size_t string_view::count(const char* set) const
+	{
+		return set == nullptr || *set == '\0' ? 0 : char_set(set).count(begin(), end());
+	}
+
+	// Counts the non-overlapping instances of the substring value in this.
+	size_t string_view::count(const string_view& value) const
+	{
+		return count(searcher(value));
+	}
+
+	// Counts the non-overlapping instances of the needle of value in this, without storing them.
+	size_t string_view::count(const searcher& value) const
+	{
+		const size_t n = value.length();
+		size_t result = 0;
+
+		if (n == 0)
+			return 0;
+
+		for (const char* p = begin(); (p = value.find(p, end())) != end(); p += n)
+			++result;
+
+		return result;
+	}
+
+	// Appends the offsets of the non-overlapping instances of the substring value in this to offsets.
+	size_t string_view::find_all(const string_view& value, std::vector<size_t>& offsets) const
+	{
+		return find_instances(*this, searcher(value), offsets);
+	}
+
+	// Appends the offsets of the non-overlapping instances of the needle of value in this to offsets.
+	size_t string_view::find_all(const searcher& value, std::vector<size_t>& offsets) const
+	{
+		return find_instances(*this, value, offsets);
+	}
+
+	// Tokenizes this using the single delimiter, and appends views of the tokens to result vector.
+	// Returns the count of tokens appended.
+	size_t string_view::split(char delimiter, std::vector<string_view>& result) const
+	{
+		char delimiters[2] = { delimiter, '\0' };
+
+		return split_tokens(*this, delimiters, result);
+	}
+
+	// Tokenizes this using the single delimiter, and returns a vector of views of the tokens.
+	std::vector<string_view> string_view::split(char delimiter) const
+	{
+		std::vector<string_view> result;
+
+		if (delimiter != '\0')
+			split(delimiter, result);
+
+		return result;
+	}
+
+	// Tokenizes this using the delimiters, and appends views of the tokens to result vector.
+	// Returns the count of tokens appended.
+	size_t string_view::split(const char* delimiters, std::vector<string_view>& result) const
+	{
+		return split_tokens(*this, delimiters, result);
+	}
+
+	// Tokenizes this using the needle of delimiter, and appends views of the tokens to result vector.
+	// Returns the count of tokens appended.
+	size_t string_view::split(const searcher& delimiter, std::vector<string_view>& result) const
+	{
+		return split_tokens(*this, delimiter, result);
+	}
+
+	// Tokenizes this using the delimiters, and returns a vector of views of the tokens.
+	std::vector<string_view> string_view::split(const char* delimiters) const
+	{
+		std::vector<string_view> result;
+
+		if (delimiters != nullptr && *delimiters)
+			split(delimiters, result);
+
+		return result;
+	}
+
+	// Tokenizes this using the delimiters, and appends views of the tokens, and each encountered 
+	// delimiter as a separate view, to the result vector. Delimiters in omit, if non-null 
+	// will not be retained.
+	// Returns the count of tokens (including delimiters) captured.
+	size_t string_view::split_with(const char* delimiters, std::vector<string_view>& result, const char* omit /*= nullptr*/) const
+	{
+		return split_tokens_with(*this, delimiters, omit, result);
+	}
+
+	// Tokenizes this using the single delimiter, and appends views of the tokens, and each 
+	// encountered delimiter as a separate view, to the result vector.
+	// Returns the count of tokens (including delimiters) captured.
+	size_t string_view::split_with(char delimiter, std::vector<string_view>& result) const
+	{
+		char delimiters[2] = { delimiter, '\0' };
+
+		return split_tokens_with(*this, delimiters, nullptr, result);
+	}
+
+	// Strips an optional leading sign from value, returning true if one was present.
+	inline static bool strip_sign(string_view& value)
+	{
+		char lead = value.head();
+
+		if (lead != '+' && lead != '-')
+			return false;
+
+		value = value.substring(1);
+
+		return true;
+	}
+
+	// True if value is a non-empty run of decimal digits without a leading zero.
+	inline static bool is_decimal_digits(const string_view& value)
+	{
+		return string::is_one_of(value.head(), "123456789") && value.consists_of("0123456789");
+	}
+
+	// Returns true if this is formatted as a decimal integer with an optional sign.
+	bool string_view::is_decimal_integer() const
+	{
+		string_view value = trim();
+		if (value.is_empty()) return false;
+		strip_sign(value);
+		return is_decimal_digits(value);
+	}
+
+	// Returns true if this is formatted as a decimal integer with a sign.
+	bool string_view::is_signed_decimal_integer() const
+	{
+		string_view value = trim();
+		if (value.is_empty()) return false;
+		if (!strip_sign(value)) return false;
+		return is_decimal_digits(value);
+	}
+
+	// Returns true if this is formatted as an unsigned decimal integer.
+	bool string_view::is_unsigned_decimal_integer() const
+	{
+		string_view value = trim();
+		if (value.is_empty()) return false;
+		if (strip_sign(value)) return false;
+		return is_decimal_digits(value);
+	}
+
+	// Returns true if this is formatted as a hexadecimal integer.
+	bool string_view::is_hexadecimal_integer() const
+	{
+		string_view value = trim();
+		if (!value.starts_with("0x", true)) return false;
+		return value.substring(2).consists_of("0123456789abcdefABCDEF");
+	}
+
+	// Returns true if this is formatted as an octal integer with the "0" prefix.
+	bool string_view::is_octal_integer() const
+	{
+		string_view value = trim();
+		if (value.head() != '0') return false;
+		return value.consists_of("01234567");
+	}
+
+	// Returns true if this is formatted as a binary integer with the "0b" prefix.
+	bool string_view::is_binary_integer() const
+	{
+		string_view value = trim();
+		if (!value.starts_with("0b", true)) return false;
+		return value.substring(2).consists_of("01");
+	}
+
+	// Returns true if this is formatted as a decimal, hexadecimal, or octal integer.
+	bool string_view::is_integer() const
+	{
+		if (is_empty()) return false;
+		return
+			is_decimal_integer() ||
+			is_hexadecimal_integer() ||
+			is_octal_integer() ||
+			is_binary_integer();
+	}
+
+	// Returns true if this is formatted as a boolean.
+	bool string_view::is_boolean() const
+	{
+		string_view value = trim();
+		return equals_caseless(value, "true") || equals_caseless(value, "false") || equals_caseless(value, "1") || equals_caseless(value, "0");
+	}
+
+	// True if value is one of the textual not-a-number forms.
+	inline static bool is_nan_text(const string_view& value)
+	{
+		return equals_caseless(value, "nan") || equals_caseless(value, "qnan") || equals_caseless(value, "snan");
+	}
+
+	// Validates the fraction and exponent parts of a float, following the dot.
+	inline static bool is_float_tail(const string_view& value, const char* digits, char marker, bool strict_exponent)
+	{
+		string_view fraction = value;
+		string_view exponent;
+
+		for (size_t i = 0; i < value.length(); ++i)
+		{
+			if (std::tolower((unsigned char)value[i]) == marker)
+			{
+				exponent = value.substring(i + 1);
+				fraction = value.left(i);
+				break;
+			}
+		}
+
+		if (!fraction.consists_of(digits))
+			return false;
+
+		if (exponent.non_empty())
+		{
+			strip_sign(exponent);
+
+			if (strict_exponent)
+				return is_decimal_digits(exponent);
+			else return exponent.consists_of(digits);
+		}
+		else return true;
+	}
+
+	// Returns true if this is formatted as a decimal floating point value.
+	bool string_view::is_decimal_float() const
+	{
+		string_view value = trim();
+
+		if (value.is_empty())
+			return false;
+
+		if (is_nan_text(value))
+			return true;
+
+		strip_sign(value);
+
+		if (equals_caseless(value, "inf")) return true;
+
+		int dot = value.index_of('.');
+
+		if (dot == -1) return false;
+
+		string_view whole = value.left(size_t(dot));
+
+		if (whole.non_empty() && !(whole.is_char() && whole.head() == '0') && !is_decimal_digits(whole))
+			return false;
+
+		return is_float_tail(value.substring(size_t(dot) + 1), "0123456789", 'e', true);
+	}
+
+	// Returns true if this is formatted as a hexadecimal floating point value.
+	bool string_view::is_hexadecimal_float() const
+	{
+		string_view value = trim();
+
+		if (value.is_empty())
+			return false;
+
+		if (is_nan_text(value))
+			return true;
+
+		strip_sign(value);
+
+		if (equals_caseless(value, "inf")) return true;
+
+		if (!value.starts_with("0x", true))
+			return false;
+
+		value = value.substring(2);
+
+		int dot = value.index_of('.');
+
+		if (dot == -1) return false;
+
+		string_view whole = value.left(size_t(dot));
+
+		if (whole.non_empty() && !whole.consists_of("0123456789abcdefABCDEF"))
+			return false;
+
+		return is_float_tail(value.substring(size_t(dot) + 1), "0123456789abcdefABCDEF", 'p', false);
+	}
+
+	// Returns true if this is formatted as a decimal or hexadecimal floating point value.
+	bool string_view::is_float() const
+	{
+		return is_decimal_float() || is_hexadecimal_float();
+	}
+
+	// Accumulates the digits of value in the given base, without overflow.
+	// Returns true if all digits were consumed and the result fits.
+	inline static bool accumulate_digits(const string_view& value, unsigned base, unsigned long long& result)
+	{
+		unsigned long long v = 0ULL;
+
+		for (char c : value)
+		{
+			unsigned d;
+
+			if (c >= '0' && c <= '9') d = unsigned(c - '0');
+			else if (c >= 'a' && c <= 'f') d = unsigned(c - 'a' + 10);
+			else if (c >= 'A' && c <= 'F') d = unsigned(c - 'A' + 10);
+			else return false;
+
+			if (d >= base || v > (ULLONG_MAX - d) / base)
+				return false;
+
+			v = v * base + d;
+		}
+
+		result = v;
+
+		return true;
+	}
+
+	// Attempts to parse this as an integer value in binary, octal, decimal or hexadecimal format.
+	// Returns true if the operation succeeded.
+	// If the operation failed, result and negative will not be set.
+	bool string_view::parse_integer(unsigned long long& result, bool& negative) const
+	{
+		string_view str = trim();
+
+		if (str.is_empty()) return false;
+
+		unsigned long long val = 0ULL;
+
+		if (str.is_binary_integer())
+		{
+			if (!accumulate_digits(str.substring(2), 2, val))
+				return false;
+
+			negative = false;
+		}
+		else if (str.is_octal_integer())
+		{
+			if (!accumulate_digits(str.substring(1), 8, val))
+				return false;
+
+			negative = false;
+		}
+		else if (str.is_decimal_integer())
+		{
+			bool neg = (str.head() == '-');
+
+			strip_sign(str);
+
+			if (!accumulate_digits(str, 10, val))
+				return false;
+
+			negative = neg;
+		}
+		else if (str.is_hexadecimal_integer())
+		{
+			if (!accumulate_digits(str.substring(2), 16, val))
+				return false;
+
+			negative = false;
+		}
+		else return false;
+
+		result = val;
+
+		return true;
+	}
+
+	// Attempts to parse this as a floating point number.
+	// Returns true if the operation succeeded, and result will be set.
+	// If the operation failed, result will not be set.
+	bool string_view::parse_float(long double& result) const
+	{
+		string_view str = trim();
+
+		if (str.is_empty()) return false;
+
+		if (equals_caseless(str, "nan") || equals_caseless(str, "qnan") || equals_caseless(str, "nan?"))
+		{
+			result = std::numeric_limits<long double>::quiet_NaN();
+			return true;
+		}
+		else if (equals_caseless(str, "snan"))
+		{
+			result = std::numeric_limits<long double>::signaling_NaN();
+			return true;
+		}
+		else if (equals_caseless(str, "inf") || equals_caseless(str, "+inf"))
+		{
+			result = std::numeric_limits<long double>::infinity();
+			return true;
+		}
+		else if (equals_caseless(str, "-inf"))
+		{
+			result = -std::numeric_limits<long double>::infinity();
+			return true;
+		}
+
+		if (str.is_decimal_float() || str.is_hexadecimal_float())
+		{
+			// strtold needs a terminated copy; short values stay on the stack.
+			char buffer[64];
+			std::string spill;
+			const char* start = buffer;
+
+			if (str.length() < sizeof(buffer))
+			{
+				std::memcpy(buffer, str.data(), str.length());
+				buffer[str.length()] = '\0';
+			}
+			else
+			{
+				spill.assign(str.data(), str.length());
+				start = spill.c_str();
+			}
+
+			char* end = nullptr;
+			errno = 0;
+			long double val = strtold(start, &end);
+
+			if ((val == HUGE_VALL || val == 0.0L) && errno == ERANGE)
+				return false;
+
+			result = val;
+
+			return true;
+		}
+
+		return false;
+	}
+
+	// Attempts to parse this as a boolean.
+	// Returns true if the operation succeeded, and result will be set.
+	// If the operation failed, result will not be set.
+	bool string_view::parse_boolean(bool& result) const
+	{
+		string_view str = trim();
+
+		if (equals_caseless(str, "true") || equals_caseless(str, "1"))
+		{
+			result = true;
+			return true;
+		}
+		else if (equals_caseless(str, "false") || equals_caseless(str, "0"))
+		{
+			result = false;
+			return true;
+		}
+		else return false;
+	}
+
+	bool string_view::to_bool() const
+	{
+		if (_null || trim().is_empty())
+			return false;
+		else if (is_boolean())
+		{
+			bool boolean = false;
+
+			if (parse_boolean(boolean))
+				return boolean;
+			else return false;
+		}
+		else if (is_float())
+		{
+			long double real = 0.0L;
+
+			if (parse_float(real))
+			{
+				if (std::isnan(real))
+					return false;
+				else if (real == std::numeric_limits<long double>::infinity())
+					return true;
+				else if (real == -std::numeric_limits<long double>::infinity())
+					return false;
+				else return real > 0.0L;
+			}
+			else return false;
+		}
+		else if (is_integer())
+		{
+			unsigned long long integer = 0ULL;
+			bool negative = false;
+
+			if (parse_integer(integer, negative))
+			{
+				if (negative)
+					return false;
+				else return integer > 0ULL;
+			}
+			else return false;
+		}
+		else return true;
+	}
+
+	char string_view::to_char() const { return head(); }
+	unsigned char string_view::to_byte() const { return parse_cast<unsigned char>(*this, 0, 1, 0, 0xFF, 0); }
+	short string_view::to_short() const { return parse_cast<short>(*this, 0, 1, SHRT_MIN, SHRT_MAX, 0); }
+	unsigned short string_view::to_ushort() const { return parse_cast<unsigned short>(*this, 0, 1, 0, USHRT_MAX, 0); }
+	int string_view::to_int() const { return parse_cast<int>(*this, 0, 1, INT_MIN, INT_MAX, 0); }
+	unsigned int string_view::to_uint() const { return parse_cast<unsigned int>(*this, 0U, 1U, 0U, UINT_MAX, 0U); }
+	long string_view::to_long() const { return parse_cast<long>(*this, 0L, 1L, LONG_MIN, LONG_MAX, 0L); }
+	unsigned long string_view::to_ulong() const { return parse_cast<unsigned long>(*this, 0UL, 1UL, 0UL, ULONG_MAX, 0UL); }
+	long long string_view::to_llong() const { return parse_cast<long long>(*this, 0LL, 1LL, LLONG_MIN, LLONG_MAX, 0LL); }
+	unsigned long long string_view::to_ullong() const { return parse_cast<unsigned long long>(*this, 0ULL, 1ULL, 0ULL, ULLONG_MAX, 0ULL); }
+	float string_view::to_float() const { return parse_cast<float>(*this, 0.0F, 1.0F, FLT_MIN, FLT_MAX, NAN); }
+	double string_view::to_double() const { return parse_cast<double>(*this, 0.0, 1.0, DBL_MIN, DBL_MAX, NAN); }
+	long double string_view::to_ldouble() const { return parse_cast<long double>(*this, 0.0L, 1.0L, LDBL_MIN, LDBL_MAX, NAN); }
+
+	// Decodes the length of a heap value, stored in the seven bytes after the pointer.
+	size_t compact_string::heap_length() const
+	{
+		uint64_t n = 0;
+
+		for (size_t i = 0; i < 7; ++i)
+			n |= uint64_t((unsigned char)_bytes[8 + i]) << (8 * i);
+
+		return size_t(n);
+	}
+
+	compact_string::compact_string()
+	{
+		std::memset(_bytes, 0, sizeof(_bytes));
+		_bytes[15] = char(15);
+	}
+
+	compact_string::compact_string(const compact_string& value) : compact_string()
+	{
+		assign(value.view());
+	}
+
+	compact_string::compact_string(compact_string&& value)
+	{
+		std::memcpy(_bytes, value._bytes, sizeof(_bytes)); // Take the heap pointer, if any.
+		std::memset(value._bytes, 0, sizeof(value._bytes));
+		value._bytes[15] = char(15);
+	}
+
+	compact_string::compact_string(const char* value) : compact_string()
+	{
+		assign(string_view(value));
+	}
+
+	compact_string::compact_string(const std::string& value) : compact_string()
+	{
+		assign(string_view(value));
+	}
+
+	compact_string::compact_string(const string_view& value) : compact_string()
+	{
+		assign(value);
+	}
+
+	compact_string::~compact_string()
+	{
+		release();
+	}
+
+	// Releases any heap storage, leaving the tag unchanged.
+	void compact_string::release()
+	{
+		if (is_heap())
+			delete[] heap_data();
+	}
+
+	// Simple assignment.
+	compact_string& compact_string::assign(const string_view& value)
+	{
+		size_t n = value.length();
+		char* heap = nullptr;
+
+		if (n > 15) // Copy first, in case value views this.
+		{
+			heap = new char[n + 1];
+			std::memcpy(heap, value.data(), n);
+			heap[n] = '\0';
+		}
+
+		char bytes[16] = { 0 };
+
+		if (value.is_null())
+			bytes[15] = char(null_tag);
+		else if (heap == nullptr)
+		{
+			std::memcpy(bytes, value.data(), n);
+			bytes[15] = char(15 - n);
+		}
+		else
+		{
+			std::memcpy(bytes, &heap, sizeof(heap));
+
+			for (size_t i = 0; i < 7; ++i)
+				bytes[8 + i] = char((uint64_t(n) >> (8 * i)) & 0xFFU);
+
+			bytes[15] = char(heap_tag);
+		}
+
+		release();
+		std::memcpy(_bytes, bytes, sizeof(_bytes));
+
+		return *this;
+	}
+
+	compact_string& compact_string::operator=(const compact_string& value)
+	{
+		if (this != &value)
+			assign(value.view());
+
+		return *this;
+	}
+
+	compact_string& compact_string::operator=(compact_string&& value)
+	{
+		if (this != &value)
+		{
+			release();
+			std::memcpy(_bytes, value._bytes, sizeof(_bytes));
+			std::memset(value._bytes, 0, sizeof(value._bytes));
+			value._bytes[15] = char(15);
+		}
+
+		return *this;
+	}
+
+	compact_string& compact_string::operator=(const char* value) { return assign(string_view(value)); }
+	compact_string& compact_string::operator=(const string_view& value) { return assign(value); }
+
+	// Nullifies this instance.
+	compact_string& compact_string::nullify()
+	{
+		release();
+		std::memset(_bytes, 0, sizeof(_bytes));
+		_bytes[15] = char(null_tag);
+
+		return *this;
+	}
+
+	// Clears this, returning this.
+	compact_string& compact_string::clear()
+	{
+		release();
+		std::memset(_bytes, 0, sizeof(_bytes));
+		_bytes[15] = char(15);
+
+		return *this;
+	}
+
+	// Copies this into a new string, preserving null.
+	string compact_string::to_string() const
+	{
+		return string(view());
+	}
+
+	// Compiles expression, using the same flags as parse by default.
+	pattern::pattern(const char* expression, std::regex_constants::syntax_option_type flags /*= std::regex_constants::ECMAScript*/)
+		: _error(std::regex_constants::error_type())
+	{
+		if (expression == nullptr)
+		{
+			_message = "null expression";
+			return;
+		}
+
+		try { _regex = regex_cache::get_compiled(expression, flags); }
+		catch (std::regex_error& e)
+		{
+			_error = e.code();
+			_message = e.what();
+		}
+	}
 
-	static void string_unescape_entity_initialize()
+	// Gets the number of capture groups, or zero if not valid.
+	size_t pattern::groups() const
 	{
-		if (string_unescape_entity_initialized_)
-			return;
+		return is_valid() ? size_t(_regex->regex.mark_count()) : 0;
+	}
 
-		string_unescape_entity_mutex_.lock();
+	// Searches value into the reused match results.
+	bool pattern::search(const string_view& value)
+	{
+		const char* start = is_valid() ? _regex->start(value.begin(), value.end()) : nullptr;
 
-		if (string_unescape_entity_initialized_)
+		return start != nullptr && std::regex_search(start, value.end(), _parts, _regex->regex, regex_cache::compiled::flags(value.begin(), start));
+	}
+
+	// Returns true if value contains a match.
+	bool pattern::matches(const string_view& value)
+	{
+		const char* start = is_valid() ? _regex->start(value.begin(), value.end()) : nullptr;
+
+		return start != nullptr && std::regex_search(start, value.end(), _regex->regex, regex_cache::compiled::flags(value.begin(), start) | std::regex_constants::match_any);
+	}
+
+	// Appends views of each non-overlapping match in value to result.
+	size_t pattern::find_all(const string_view& value, std::vector<string_view>& result)
+	{
+		return is_valid() ? find_matches(*_regex, _parts, value, result) : 0;
+	}
+
+	// Appends each non-overlapping match in value to result.
+	size_t pattern::find_all(const string_view& value, string_table& result)
+	{
+		return is_valid() ? find_matches(*_regex, _parts, value, result) : 0;
+	}
+
+	const uint32_t keyword_set::none;
+	const uint32_t keyword_set::reports;
+
+	// An empty set, which matches nothing.
+	keyword_set::keyword_set() : _caseless(false)
+	{
+		compile();
+	}
+
+	// Compiles the keywords, matched ignoring ASCII case if caseless.
+	keyword_set::keyword_set(const std::vector<std::string>& keywords, bool caseless /*= false*/)
+		: _keywords(keywords), _caseless(caseless)
+	{
+		compile();
+	}
+
+	// Compiles the keywords, matched ignoring ASCII case if caseless. Null keywords are empty.
+	keyword_set::keyword_set(std::initializer_list<const char*> keywords, bool caseless /*= false*/)
+		: _caseless(caseless)
+	{
+		for (const char* keyword : keywords)
+			_keywords.emplace_back(keyword == nullptr ? "" : keyword);
+
+		compile();
+	}
+
+	// Builds the trie of the keywords over byte classes, then completes it breadth first into a
+	// DFA: a missing transition takes that of the failure state, the longest proper suffix which
+	// is also a prefix. Each state keeps its own keyword, and a link to the longest suffix state
+	// with one; transitions into a state with either are flagged, so the scan checks no others.
+	void keyword_set::compile()
+	{
+		const auto fold = [this](unsigned char c) { return _caseless && c >= 'A' && c <= 'Z' ? (unsigned char)(c + ('a' - 'A')) : c; };
+
+		std::fill(_classes, _classes + 256, (unsigned char)0);
+		_class_count = 1;
+
+		for (const std::string& keyword : _keywords)
 		{
-			string_unescape_entity_mutex_.unlock();
+			for (char c : keyword)
+			{
+				if (_classes[fold((unsigned char)c)] == 0)
+					_classes[fold((unsigned char)c)] = (unsigned char)_class_count++;
+			}
+		}
 
-			return;
+		if (_caseless)
+		{
+			for (int c = 'A'; c <= 'Z'; ++c)
+				_classes[c] = _classes[c + ('a' - 'A')];
 		}
 
-		const entity_entry_t* p = string_unescape_entity_names_;
+		_next.assign(_class_count, none);
+		_output.assign(1, none);
+		_same.assign(_keywords.size(), none);
 
-		for (;;)
+		for (size_t i = 0; i < _keywords.size(); ++i)
 		{
-			if (p->name == nullptr)
-				break;
+			if (_keywords[i].empty())
+				continue;
 
-			string_unescape_entity_map_.insert(std::pair<std::string, unsigned>(p->name, p->value));
+			uint32_t state = 0;
+
+			for (char c : _keywords[i])
+			{
+				uint32_t& next = _next[state * _class_count + _classes[(unsigned char)c]];
+
+				if (next == none)
+				{
+					next = uint32_t(_output.size());
+					_output.push_back(none);
+					_next.resize(_next.size() + _class_count, none);
+				}
+
+				state = _next[state * _class_count + _classes[(unsigned char)c]];
+			}
+
+			if (_output[state] == none)
+				_output[state] = uint32_t(i);
+			else
+			{
+				uint32_t k = _output[state];
+
+				while (_same[k] != none)
+					k = _same[k];
+
+				_same[k] = uint32_t(i);
+			}
+		}
+
+		std::vector<uint32_t> fail(_output.size(), 0);
+		std::vector<uint32_t> queue;
+
+		_suffix.assign(_output.size(), none);
+
+		for (size_t c = 0; c < _class_count; ++c)
+		{
+			uint32_t& next = _next[c];
+
+			if (next == none)
+				next = 0;
+			else
+				queue.push_back(next);
+		}
+
+		for (size_t head = 0; head < queue.size(); ++head)
+		{
+			const uint32_t state = queue[head];
+			const uint32_t link = fail[state];
+
+			_suffix[state] = _output[link] != none ? link : _suffix[link];
+
+			for (size_t c = 0; c < _class_count; ++c)
+			{
+				uint32_t& next = _next[state * _class_count + c];
+				const uint32_t fallback = _next[link * _class_count + c] & ~reports;
+
+				if (next == none)
+					next = fallback;
+				else
+				{
+					fail[next] = fallback;
+					queue.push_back(next);
+				}
+			}
+		}
+
+		for (uint32_t& next : _next)
+		{
+			if (_output[next] != none || _suffix[next] != none)
+				next |= reports;
+		}
+	}
+
+	// Runs the automaton over text, calling emit(keyword, end) for each occurrence, longest
+	// first at each end, until emit returns false.
+	template <typename Emit>
+	void keyword_set::scan(const string_view& text, Emit emit) const
+	{
+		const uint32_t* next = _next.data();
+		const size_t classes = _class_count;
+		uint32_t state = 0;
+
+		for (const char* p = text.begin(), *e = text.end(); p != e; )
+		{
+			state = next[(state & ~reports) * classes + _classes[(unsigned char)*p++]];
+
+			if (!(state & reports))
+				continue;
+
+			for (uint32_t s = state & ~reports; s != none; s = _suffix[s])
+			{
+				for (uint32_t k = _output[s]; k != none; k = _same[k])
+				{
+					if (!emit(size_t(k), p))
+						return;
+				}
+			}
+		}
+	}
+
+	// Finds the occurrence which ends first in text, the longest of those ending together.
+	bool keyword_set::find_first(const string_view& text, match& result) const
+	{
+		bool found = false;
+
+		scan(text, [&](size_t keyword, const char* end)
+		{
+			const size_t length = _keywords[keyword].length();
+
+			result.keyword = keyword;
+			result.view = string_view(end - length, length);
+			found = true;
+			return false;
+		});
+
+		return found;
+	}
+
+	// Appends every occurrence of every keyword in text to result.
+	size_t keyword_set::find_all(const string_view& text, std::vector<match>& result) const
+	{
+		const size_t count = result.size();
+
+		scan(text, [&](size_t keyword, const char* end)
+		{
+			const size_t length = _keywords[keyword].length();
+			const match found = { keyword, string_view(end - length, length) };
+
+			result.push_back(found);
+			return true;
+		});
+
+		return result.size() - count;
+	}
+
+	// Compiles the keys of replacements, matched ignoring ASCII case if caseless.
+	replacer::replacer(const std::vector<std::pair<std::string, std::string>>& replacements, bool caseless /*= false*/)
+	{
+		std::vector<std::string> keys;
+
+		for (const auto& replacement : replacements)
+		{
+			keys.push_back(replacement.first);
+			_values.push_back(replacement.second);
+		}
+
+		_keys = keyword_set(keys, caseless);
+	}
+
+	// Compiles the keys of replacements, matched ignoring ASCII case if caseless. Null keys
+	// and values are empty.
+	replacer::replacer(std::initializer_list<std::pair<const char*, const char*>> replacements, bool caseless /*= false*/)
+	{
+		std::vector<std::string> keys;
+
+		for (const auto& replacement : replacements)
+		{
+			keys.emplace_back(replacement.first == nullptr ? "" : replacement.first);
+			_values.emplace_back(replacement.second == nullptr ? "" : replacement.second);
+		}
+
+		_keys = keyword_set(keys, caseless);
+	}
 
+	// Finds every occurrence of the keys, then orders them by start, longest and first listed
+	// first, and keeps each that starts past the end of the last one kept.
+	size_t replacer::find(const string_view& text, std::vector<keyword_set::match>& result) const
+	{
+		const size_t count = result.size();
+
+		if (_keys.find_all(text, result) == 0)
+			return 0;
+
+		auto first = result.begin() + count;
+
+		std::sort(first, result.end(), [](const keyword_set::match& a, const keyword_set::match& b)
+		{
+			if (a.view.begin() != b.view.begin()) return a.view.begin() < b.view.begin();
+			if (a.view.length() != b.view.length()) return a.view.length() > b.view.length();
+			return a.keyword < b.keyword;
+		});
+
+		const char* covered = text.begin();
+		auto kept = first;
+
+		for (auto it = first; it != result.end(); ++it)
+		{
+			if (it->view.begin() >= covered)
+			{
+				covered = it->view.end();
+				*kept++ = *it;
+			}
+		}
+
+		result.erase(kept, result.end());
+
+		return result.size() - count;
+	}
+
+	// Sets a bit in mask for each keyword occurring in text, stopping once all have been found.
+	size_t keyword_set::find_mask(const string_view& text, std::vector<uint64_t>& mask) const
+	{
+		size_t count = 0;
+
+		mask.assign((_keywords.size() + 63) / 64, 0);
+
+		scan(text, [&](size_t keyword, const char*)
+		{
+			uint64_t& word = mask[keyword / 64];
+			const uint64_t bit = uint64_t(1) << (keyword % 64);
+
+			if (!(word & bit))
+			{
+				word |= bit;
+				++count;
+			}
+
+			return count < _keywords.size();
+		});
+
+		return count;
+	}
+
+	const int glob::any;
+
+	// Lowers an ASCII letter.
+	inline static unsigned char glob_lower(unsigned char c) { return c >= 'A' && c <= 'Z' ? (unsigned char)(c + ('a' - 'A')) : c; }
+
+	// Reads one character of a glob at p, which is the next if p is a \ before another.
+	inline static unsigned char glob_char(const char*& p)
+	{
+		if (*p == '\\' && p[1] != '\0')
 			++p;
+		return (unsigned char)*p++;
+	}
+
+	// Compiles pattern, matched ignoring ASCII case if caseless. A null pattern matches nothing.
+	glob::glob(const char* pattern, bool caseless /*= false*/)
+		: _pattern(pattern == nullptr ? "" : pattern), _caseless(caseless), _anchored_start(true), _anchored_end(true), _min_length(0)
+	{
+		if (pattern == nullptr)
+		{
+			_min_length = string_view::npos; // Longer than any value.
+			return;
 		}
 
-		string_unescape_entity_initialized_ = true;
-		string_unescape_entity_mutex_.unlock();
+		piece part = { 0, 0, string_view::npos, string_view::npos };
+		bool star = false;
+
+		auto close = [&]()
+		{
+			if (part.count != 0)
+				_pieces.push_back(part);
+
+			part = piece { _tokens.size(), 0, string_view::npos, string_view::npos };
+		};
+
+		auto push = [&](int token)
+		{
+			if (token >= 0)
+			{
+				if (part.head == string_view::npos)
+					part.head = part.count;
+				part.tail = part.count;
+			}
+
+			_tokens.push_back(token);
+			++part.count;
+			++_min_length;
+		};
+
+		for (const char* p = _pattern.c_str(); *p != '\0';)
+		{
+			star = *p == '*';
+
+			if (star)
+			{
+				if (p == _pattern.c_str())
+					_anchored_start = false;
+
+				close();
+				++p;
+			}
+			else if (*p == '?')
+			{
+				push(any);
+				++p;
+			}
+			else if (*p == '[')
+			{
+				const char* q = p + 1;
+				const bool negated = *q == '!' || *q == '^';
+				uint64_t bits[4] = { 0, 0, 0, 0 };
+
+				if (negated) ++q;
+
+				// A leading ] is a member.
+				for (bool leading = true; *q != '\0' && (*q != ']' || leading); leading = false)
+				{
+					unsigned char low = glob_char(q), high = low;
+
+					if (*q == '-' && q[1] != ']' && q[1] != '\0')
+					{
+						++q;
+						high = glob_char(q);
+					}
+
+					for (unsigned c = low; c <= high; ++c)
+					{
+						bits[c >> 6] |= uint64_t(1) << (c & 63);
+
+						if (caseless && std::isalpha(c))
+						{
+							const unsigned other = c ^ 0x20U;
+							bits[other >> 6] |= uint64_t(1) << (other & 63);
+						}
+					}
+				}
+
+				if (*q == '\0') // Unterminated, so literal.
+				{
+					push('[');
+					++p;
+					continue;
+				}
+
+				for (uint64_t word : bits)
+					_sets.push_back(negated ? ~word : word);
+
+				push(-2 - int(_sets.size() / 4 - 1));
+				p = q + 1;
+			}
+			else
+			{
+				const unsigned char c = glob_char(p);
+				push(caseless ? glob_lower(c) : c);
+			}
+		}
+
+		close();
+		_anchored_end = !star;
 	}
 
-	// Expands any known XML/HTML entity references into literal
-	// UTF-8 characters.
-	inline static std::string unescape_entities(const string& value)
+	// Returns true if the tokens of part match at p, which has room for them.
+	bool glob::matches_at(const piece& part, const char* p) const
 	{
-		std::istringstream is(value);
-		std::ostringstream os;
+		const int* token = _tokens.data() + part.first;
 
-		string_unescape_entity_initialize();
+		for (size_t i = 0; i < part.count; ++i)
+		{
+			const int t = token[i];
+			const unsigned char c = (unsigned char)p[i];
 
-		std::string mn;
-		unsigned cc;
-		bool pc, gc;
+			if (t >= 0)
+			{
+				if ((_caseless ? glob_lower(c) : c) != t)
+					return false;
+			}
+			else if (t != any)
+			{
+				const uint64_t* bits = _sets.data() + size_t(-2 - t) * 4;
 
-		enum class state
+				if (((bits[c >> 6] >> (c & 63)) & 1) == 0)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Finds the first place in [first, last) where part matches whole, or null if none. With
+	// literal tokens, candidates are those where the first and last literal tokens both match,
+	// tested a vector at a time; a letter of a caseless glob compares with its 0x20 bit set,
+	// which only upper and lower case of it have.
+	const char* glob::find(const piece& part, const char* first, const char* last) const
+	{
+		if (size_t(last - first) < part.count)
+			return nullptr;
+
+		const char* end = last - part.count + 1; // Past the last candidate.
+		const char* p = first;
+
+		if (part.head == string_view::npos)
 		{
-			none,
-			begin,
-			name,
-			number,
-			decimal,
-			hexadecimal,
+			for (; p < end; ++p)
+				if (matches_at(part, p))
+					return p;
+
+			return nullptr;
+		}
+
+		const unsigned char head = (unsigned char)_tokens[part.first + part.head];
+		const unsigned char tail = (unsigned char)_tokens[part.first + part.tail];
+		const byte_pair pair = { part.head, part.tail, head, tail,
+			(unsigned char)(_caseless && std::isalpha(head) ? 0x20 : 0), (unsigned char)(_caseless && std::isalpha(tail) ? 0x20 : 0) };
+
+		return find_pair(pair, first, end, [&](const char* q) { return matches_at(part, q); });
+	}
+
+	// Returns true if the whole of value matches. A null value matches nothing.
+	bool glob::matches(const string_view& value) const
+	{
+		if (value.is_null() || value.length() < _min_length)
+			return false;
+
+		const char* p = value.begin();
+		const char* e = value.end();
+		size_t i = 0;
+		size_t j = _pieces.size();
+
+		// Without a star, the one piece, if any, is the whole value. With one, anchoring both
+		// ends means there are pieces before and after it.
+		if (_anchored_start && _anchored_end && j <= 1)
+			return value.length() == _min_length && (j == 0 || matches_at(_pieces[0], p));
+
+		if (_anchored_start)
+		{
+			if (!matches_at(_pieces[0], p))
+				return false;
+			p += _pieces[i++].count;
+		}
+
+		if (_anchored_end)
+		{
+			const piece& part = _pieces[--j];
+
+			if (!matches_at(part, e - part.count))
+				return false;
+			e -= part.count;
 		}
-		ms = state::none;
 
-		for (;;)
+		for (; i < j; ++i)
 		{
-			const unsigned char ch = is.get();
+			const char* q = find(_pieces[i], p, e);
 
-			if (is.eof()) 
-				break;
+			if (q == nullptr)
+				return false;
+			p = q + _pieces[i].count;
+		}
 
-			pc = false;
-			gc = false;
+		return true;
+	}
 
-			switch (ms)
-			{
-			case state::begin:
+	const size_t searcher::pair_limit;
 
-				if (ch == '#')
-				{
-					ms = state::number;
-					pc = true;
-				}
-				else if (ch >= 'a' && ch <= 'z' || ch >= 'A' && ch <= 'Z')
-				{
-					mn.append(1, ch);
-					ms = state::name;
-					pc = true;
-				}
-				else
-				{
-					os.put('&');
-					ms = state::none;
-				}
+	// Ranks how often byte occurs in typical text, from 0 for never to 255 for most often, so
+	// that the packed-pair filter can test the rarest bytes of a needle.
+	static unsigned byte_rank(unsigned char c)
+	{
+		if (c == ' ') return 255;
+		if (std::strchr("etaoinsrhl", c) != nullptr && c != '\0') return 220;
+		if (c >= 'a' && c <= 'z') return 180;
+		if (c >= '0' && c <= '9') return 140;
+		if (c >= 'A' && c <= 'Z') return 120;
+		if (c == '\n' || c == '\r' || c == '\t') return 110;
+		if (std::strchr(".,-_/:=\"'();<>", c) != nullptr && c != '\0') return 100;
+		if (c >= 0x20 && c < 0x7F) return 70;
+		if (c >= 0x80) return 40;
+		return c == '\0' ? 30 : 10;
+	}
 
-				break;
+	// Builds a searcher for needle, choosing its algorithm and precomputing what that needs.
+	searcher::searcher(const string_view& needle)
+		: _needle(needle.data(), needle.length()), _algorithm(algorithm::empty), _head(0), _tail(0), _suffix(0), _period(1), _periodic(false)
+	{
+		const size_t n = _needle.length();
+		const unsigned char* p = (const unsigned char*)_needle.data();
 
-			case state::name:
+		if (n == 0)
+			return;
 
-				if (ch >= 'a' && ch <= 'z' || ch >= 'A' && ch <= 'Z' || ch >= '0' && ch <= '9')
-				{
-					mn.append(1, ch);
-					pc = true;
-				}
-				else if (ch == ';')
-				{
-					auto e = string_unescape_entity_map_.find(mn);
+		if (n == 1)
+		{
+			_algorithm = algorithm::byte;
+			return;
+		}
 
-					if (e != string_unescape_entity_map_.end())
-					{
-						cc = e->second;
-						pc = true;
-						gc = true;
-					}
-				}
+		if (n <= pair_limit)
+		{
+			// The rarest byte, then the rarest at another offset, preferring another value.
+			_algorithm = algorithm::pair;
 
-				if (!pc)
-				{
-					os.put('&');
+			for (size_t i = 1; i < n; ++i)
+				if (byte_rank(p[i]) < byte_rank(p[_head]))
+					_head = i;
 
-					size_t n = mn.size();
+			_tail = _head == 0 ? 1 : 0;
 
-					for (size_t i = 0; i < n; ++i)
-						os.put(mn[i]);
+			for (size_t i = 0; i < n; ++i)
+			{
+				if (i == _head)
+					continue;
 
-					ms = state::none;
-				}
+				const bool distinct = p[i] != p[_head], tail_distinct = p[_tail] != p[_head];
 
-				break;
+				if ((distinct && !tail_distinct) || (distinct == tail_distinct && byte_rank(p[i]) < byte_rank(p[_tail])))
+					_tail = i;
+			}
 
-			case state::number:
+			return;
+		}
 
-				if (ch == 'x' || ch == 'X')
-				{
-					pc = true;
-					ms = state::hexadecimal;
-					cc = 0;
-				}
-				else if (ch >= '0' && ch <= '9')
-				{
-					cc = ch - '0';
-					ms = state::decimal;
-					pc = true;
-				}
-				else ms = state::none;
+		bool seen[256] = { false };
+		size_t distinct = 0;
 
-				break;
+		for (size_t i = 0; i < n; ++i)
+			if (!seen[p[i]])
+				seen[p[i]] = true, ++distinct;
 
-			case state::decimal:
+		if (distinct > 8)
+		{
+			_algorithm = algorithm::horspool;
+			_shifts.assign(256, n);
 
-				if (ch >= '0' && ch <= '9')
-				{
-					cc = cc * 10 + ch - '0';
-					pc = true;
-				}
-				else if (ch == ';')
-				{
-					pc = true;
-					gc = true;
-				}
-				else ms = state::none;
+			for (size_t i = 0; i + 1 < n; ++i)
+				_shifts[p[i]] = n - 1 - i;
 
-				break;
+			return;
+		}
 
-			case state::hexadecimal:
+		// The critical factorization of Crochemore and Perrin: the later of the maximal suffixes
+		// under the byte order and its reverse, with the period of that suffix.
+		_algorithm = algorithm::two_way;
 
-				if (ch >= '0' && ch <= '9')
-				{
-					cc = cc * 16 + ch - '0';
-					pc = true;
-				}
-				else if (ch >= 'a' && ch <= 'f')
-				{
-					cc = cc * 16 + ch - 'a' + 10;
-					pc = true;
-				}
-				else if (ch >= 'A' && ch <= 'F')
-				{
-					cc = cc * 16 + ch - 'A' + 10;
-					pc = true;
-				}
-				else if (ch == ';')
-				{
-					pc = true;
-					gc = true;
-				}
-				else ms = state::none;
+		size_t suffixes[2];
+		size_t periods[2];
 
-				break;
-			}
+		for (int order = 0; order < 2; ++order)
+		{
+			size_t suffix = size_t(-1), j = 0, k = 1, period = 1;
 
-			if (gc)
+			while (j + k < n)
 			{
-				if (cc >= 0x800U)
+				const unsigned char a = p[j + k], b = p[suffix + k];
+
+				if (order == 0 ? a < b : a > b)
 				{
-					os.put(0xE0 | (cc >> 12) & 0x0FU);
-					os.put(0x80 | (cc >> 6) & 0x3FU);
-					os.put(0x80 | cc & 0x3FU);
+					j += k;
+					k = 1;
+					period = j - suffix;
 				}
-				else if (cc >= 0x80U)
+				else if (a == b)
 				{
-					os.put(0xC0 | (cc >> 6) & 0x1FU);
-					os.put(0x80 | cc & 0x3FU);
+					if (k != period)
+						++k;
+					else
+					{
+						j += period;
+						k = 1;
+					}
 				}
-				else os.put(cc);
-
-				ms = state::none;
-			}
-			else if (!pc && ms == state::none)
-			{
-				if (ch == '&')
+				else
 				{
-					ms = state::begin;
-					mn.erase();
+					suffix = j++;
+					k = period = 1;
 				}
-				else os.put(ch);
 			}
+
+			suffixes[order] = suffix + 1;
+			periods[order] = period;
 		}
 
-		return os.str();
-	}
+		const int later = suffixes[1] >= suffixes[0] ? 1 : 0;
 
-	inline static char unescape_url_hex(char value)
-	{ return isdigit(value) ? value - char('0') : tolower(value) - char('a') + 10; }
+		_suffix = suffixes[later];
+		_period = periods[later];
+		_periodic = std::memcmp(p, p + _period, _suffix) == 0;
 
-	inline static std::string unescape_url(const string& value)
-	{
-		std::ostringstream os;
+		if (!_periodic)
+			_period = std::max(_suffix, n - _suffix) + 1;
+	}
 
-		os.fill('0');
+	// Finds the first instance of the needle in [first, last), or last if none.
+	const char* searcher::find(const char* first, const char* last) const
+	{
+		const size_t n = _needle.length();
+		const char* needle = _needle.data();
 
-		auto n = value.end();
+		if (size_t(last - first) < n)
+			return last;
 
-		for (auto i = value.begin(); i != n; ++i)
+		switch (_algorithm)
 		{
-			char c = *i;
+		case algorithm::empty:
+			return first;
 
-			if (c == '%') 
-			{
-				if (i[1] && i[2])
-				{
-					char h = unescape_url_hex(i[1]) << 4 | unescape_url_hex(i[2]);
-					os << h;
-					i += 2;
-				}
-			}
-			else if (c == '+') 
-				os << ' ';
-			else os << c;
+		case algorithm::byte:
+		{
+			const char* p = (const char*)std::memchr(first, needle[0], size_t(last - first));
+			return p == nullptr ? last : p;
 		}
 
-		return os.str();
-	}
-
-	// Escaping for literal patterns used in regular expressions.
-	inline static string escape_regex(const string& value)
-	{
-		string result;
+		case algorithm::pair:
+		{
+			const byte_pair pair = { _head, _tail, (unsigned char)needle[_head], (unsigned char)needle[_tail], 0, 0 };
+			const char* p = find_pair(pair, first, last - n + 1, [&](const char* q) { return std::memcmp(q, needle, n) == 0; });
+			return p == nullptr ? last : p;
+		}
 
-		for (char c : value)
+		case algorithm::horspool:
 		{
-			bool e = false;
+			const unsigned char end = (unsigned char)needle[n - 1];
 
-			switch (c)
-			{
-			case '\t': e = true, c = 't'; break;
-			case '\n': e = true, c = 'n'; break;
-			case '\r': e = true, c = 'r'; break;
-			case '\v': e = true, c = 'v'; break;
-			case '\f': e = true, c = 'f'; break;
-			case '.': case '^': case '$': case '*': case '+': case '-': case '?':
-			case '(': case ')': case '[': case ']': case '{': case '}': case '\\': case '/':
-				e = true; break;
-			default: break;
-			}
+			for (const char* p = first; p <= last - n; p += _shifts[(unsigned char)p[n - 1]])
+				if ((unsigned char)p[n - 1] == end && std::memcmp(p, needle, n - 1) == 0)
+					return p;
 
-			if (e)
-			{
-				result.append('\\');
-				result.append(c);
-			}
-			else result.append(c);
+			return last;
 		}
 
-		return result;
+		default:
+			return find_two_way(first, last);
+		}
 	}
 
-	// Copies this and returns an escaped copy.
-	string& string::escape(escaping value)
+	// Finds the first offset of the needle in haystack at or after start, or npos if none.
+	size_t searcher::find(const string_view& haystack, size_t start /*= 0*/) const
 	{
-		switch (value)
-		{
-		case escaping::json: 
-			assign(escape_json(*this)); 
-			break;
-		case escaping::url: 
-			assign(escape_url(string_escape_url_html5_, *this)); 
-			break;
-		case escaping::rfc3986: 
-			assign(escape_url(string_escape_url_rfc3986_, *this)); 
-			break;
-		case escaping::entities: 
-			assign(escape_entities(*this)); 
-			break;
-		case escaping::regex:
-			assign(escape_regex(*this));
-			break;
-		default: return *this;
-		}
+		if (start > haystack.length())
+			return string_view::npos;
 
-		return *this;
+		const char* p = find(haystack.begin() + start, haystack.end());
+
+		return p == haystack.end() && (_needle.length() != 0 || start != haystack.length()) ? string_view::npos : size_t(p - haystack.begin());
 	}
 
-	// Removes the specified escaping from this.
-	string& string::unescape(escaping value)
+	// Finds the first instance in [first, last) by Two-Way: the right part of the needle, past
+	// the critical factorization, is compared from the left, then the left part from the right.
+	// A mismatch in the right part shifts by its position, and one in the left part by the
+	// period; for a periodic needle, the part already known to match is remembered.
+	const char* searcher::find_two_way(const char* first, const char* last) const
 	{
-		string temp(*this);
+		const unsigned char* needle = (const unsigned char*)_needle.data();
+		const unsigned char* haystack = (const unsigned char*)first;
+		const size_t n = _needle.length();
+		const size_t h = size_t(last - first);
+		size_t memory = 0;
 
-		switch (value)
+		for (size_t j = 0; j <= h - n;)
 		{
-		case escaping::json: 
-		{
-			string result;
-			if (!unescape_json(*this, result))
-				return *this;
-			assign(result);
-			return *this;
-		}
-		case escaping::rfc3986:
-		case escaping::url:
-			return assign(unescape_url(*this));
-		case escaping::entities:
-			return assign(unescape_entities(*this));
-		case escaping::regex:
-			// TODO
-		default: return *this;
+			size_t i = _periodic ? std::max(_suffix, memory) : _suffix;
+
+			while (i < n && needle[i] == haystack[i + j])
+				++i;
+
+			if (i < n)
+			{
+				j += i - _suffix + 1;
+				memory = 0;
+				continue;
+			}
+
+			const size_t floor = _periodic ? memory : 0;
+
+			for (i = _suffix; i > floor && needle[i - 1] == haystack[i - 1 + j];)
+				--i;
+
+			if (i <= floor)
+				return first + j;
+
+			j += _period;
+
+			if (_periodic)
+				memory = n - _period;
 		}
+
+		return last;
 	}
+
+	// The allocators basic_string is instantiated for.
+	template class basic_string<std::allocator<char>>;
+#if __cplusplus > 201402L
+	template class basic_string<std::pmr::polymorphic_allocator<char>>;
+#endif
 };
 
@@ -32,33 +32,1454 @@ SOFTWARE.
 
 #include <string>
 #include <vector>
+#include <iterator>
+#include <memory>
 #include <regex>
+#include <iostream>
 #include <type_traits>
 #include <limits>
 #include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <initializer_list>
 
+#if __cplusplus > 201402L
+#include <memory_resource>
+#endif
+
+
+namespace super
+{
+	// Hash code part for 128 bit hashes.
+	enum class hash_code_part
+	{
+		// Low qword.
+		low,
+
+		// High qword.
+		high,
+
+		// XOR of low, high.
+		both
+	};
+
+	// A compiled set of characters, used to scan for delimiters. Membership is a 256-bit table;
+	// for sets of ASCII characters, find and find_not also use nibble lookup tables to test 16
+	// (SSSE3) or 32 (AVX2) bytes per step, where the build targets those instruction sets.
+	class char_set
+	{
+	private:
+
+		uint64_t _bits[4];
+		uint8_t _nibbles[16];
+		bool _ascii;
+
+	public:
+
+		// An empty set.
+		char_set();
+
+		// The set of characters in chars, excluding the terminating null. A null chars is empty.
+		explicit char_set(const char* chars);
+
+		// The set of the single character value.
+		explicit char_set(char value);
+
+		// True if value is a member of the set.
+		inline bool contains(char value) const
+		{
+			const unsigned char c = (unsigned char)value;
+			return ((_bits[c >> 6] >> (c & 63)) & 1) != 0;
+		}
+
+		// True if the set has no members.
+		inline bool empty() const { return (_bits[0] | _bits[1] | _bits[2] | _bits[3]) == 0; }
+
+		// Finds the first character in [first, last) which is a member, or last if none.
+		const char* find(const char* first, const char* last) const;
+
+		// Finds the first character in [first, last) which is not a member, or last if none.
+		const char* find_not(const char* first, const char* last) const;
+
+		// Counts the characters in [first, last) which are members.
+		size_t count(const char* first, const char* last) const;
+
+	private:
+
+		// Adds value to the set.
+		void add(char value);
+	};
+
+	// A necessary condition for a regular expression to match, read from its text: a literal which
+	// every match contains, and the set of characters every match starts with. Either may be
+	// unknown, and a prefilter knowing neither admits everything. Only ECMAScript and extended
+	// syntax without icase are read, and whatever is not understood is skipped conservatively.
+	class regex_prefilter
+	{
+	private:
+
+		std::string _literal;
+		char_set _first;
+
+	public:
+
+		// A prefilter which admits everything.
+		regex_prefilter();
+
+		// Reads the prefilter of expression, compiled with flags.
+		regex_prefilter(const char* expression, std::regex_constants::syntax_option_type flags);
+
+		// Gets the literal every match contains, or an empty string if unknown.
+		inline const std::string& literal() const { return _literal; }
+
+		// Gets the characters every match starts with, or an empty set if unknown.
+		inline const char_set& first() const { return _first; }
+
+		// True if this rules nothing out.
+		inline bool is_trivial() const { return _literal.empty() && _first.empty(); }
+
+		// Finds the first position in [first, last) at which a match can start, or last if there is
+		// none: no character of first() from there, or no literal() after it.
+		const char* candidate(const char* first, const char* last) const;
+	};
+
+	// A matcher for regular expressions in the POSIX extended syntax, as match and match_all
+	// compile them, which runs in time linear in the input where std::regex backtracks. The
+	// expression is compiled to an NFA, and DFA states are built from it as the input reaches
+	// them, in caches of at most state_limit states which are flushed when full. It finds where
+	// matches begin, and from each start the longest end and the end a backtracking search tries
+	// first, between which std::regex picks in extended syntax. Expressions outside the supported
+	// subset, such as with multiline, collating elements or equivalence classes, leave this
+	// invalid, to be matched with std::regex instead. Searches may run on several threads.
+	class regex_dfa
+	{
+	public:
+
+		// The maximum count of DFA states cached per automaton, before the cache is flushed.
+		static const size_t state_limit = 2048;
+
+	private:
+
+		struct program;
+		struct cache;
+		class runner;
+
+		std::unique_ptr<program> _program;
+
+	public:
+
+		// Compiles expression, which std::regex accepts with flags, for the DFA. This is left
+		// invalid unless flags are extended syntax, optionally with icase, and the expression
+		// stays within the supported subset and a bounded NFA size.
+		regex_dfa(const char* expression, std::regex_constants::syntax_option_type flags);
+		~regex_dfa();
+
+		// True if the expression was compiled for the DFA.
+		inline bool is_valid() const { return _program != nullptr; }
+
+		// Returns whether a match lies within [at, last), where first is the start of the input,
+		// as regex_search does with match_prev_avail when at is past first. Requires is_valid.
+		bool search(const char* first, const char* at, const char* last) const;
+
+		// Marks whether a match begins at each position of [at, last], as starts[i] for at + i,
+		// in one reverse pass. first is the start of the input, and eol is false if the input
+		// goes on past last, so that $ does not match there. Requires is_valid.
+		void starts(const char* first, const char* at, const char* last, std::vector<bool>& result, bool eol = true) const;
+
+		// Gets the end of the longest match beginning at at, within [first, last), or null if
+		// none begins there. eol is as for starts. Requires is_valid.
+		const char* longest(const char* first, const char* at, const char* last, bool eol = true) const;
+
+		// Gets the end of the match beginning at at which a backtracking search finds first, trying
+		// alternatives in order and repeats greedily, or null if none begins there. If not_null,
+		// an empty match is passed over. std::regex keeps this match if it is also the longest.
+		// first, last and eol are as for longest. Requires is_valid.
+		const char* preferred(const char* first, const char* at, const char* last, bool eol = true, bool not_null = false) const;
+
+		// Gets how far a match beginning in [at, end) can run within [at, last], where first is
+		// the start of the input: a position no such match reaches, or null if one may still run
+		// on past last. Requires is_valid.
+		const char* reach(const char* first, const char* at, const char* end, const char* last) const;
+	};
+
+	// A process-wide cache of compiled regular expressions, keyed by expression and syntax flags,
+	// behind match, match_all and parse, so that a repeated expression is compiled once. Entries
+	// are spread over lock-striped shards, each a bounded LRU list, and a miss compiles outside
+	// the lock. Compiled expressions are shared, so they stay valid for their current users when
+	// evicted or cleared.
+	class regex_cache
+	{
+	public:
+
+		// Cache counters, accumulated since start or the last clear. Searches which a prefilter
+		// checked are counted as prefiltered, and those it ruled out, without running the
+		// expression, as rejected.
+		struct statistics
+		{
+			unsigned long long hits;
+			unsigned long long misses;
+			unsigned long long evictions;
+			size_t size;
+			unsigned long long prefiltered;
+			unsigned long long rejected;
+		};
+
+		// A compiled expression, its prefilter, and its DFA where the expression allows one.
+		struct compiled
+		{
+			std::regex regex;
+			regex_prefilter prefilter;
+			regex_dfa dfa;
+
+			compiled(const char* expression, std::regex_constants::syntax_option_type flags);
+
+			// Finds where a search of [first, last) should start, or returns null if the prefilter
+			// rules out a match, counting the check in the statistics.
+			const char* start(const char* first, const char* last) const;
+
+			// Gets the match flag for a search starting at start within [first, last).
+			static inline std::regex_constants::match_flag_type flags(const char* first, const char* start)
+			{
+				return start == first ? std::regex_constants::match_default : std::regex_constants::match_prev_avail;
+			}
+		};
+
+		// Gets the compiled expression, compiling and caching it on a miss.
+		// Throws std::regex_error if the expression is invalid. Invalid expressions are not cached.
+		static std::shared_ptr<const std::regex> get(const char* expression, std::regex_constants::syntax_option_type flags = std::regex_constants::ECMAScript);
+
+		// Gets the compiled expression with its prefilter, as for get.
+		static std::shared_ptr<const compiled> get_compiled(const char* expression, std::regex_constants::syntax_option_type flags = std::regex_constants::ECMAScript);
+
+		// Gets the hit, miss and eviction counts, and the count of cached expressions.
+		static statistics stats();
+
+		// Removes all cached expressions, and resets the counters.
+		static void clear();
+
+		// Gets the maximum count of cached expressions (256 by default).
+		static size_t capacity();
+
+		// Sets the maximum count of cached expressions, evicting the least recently used if over.
+		// The bound is kept per shard, as a sixteenth of value rounded up, so the total is approximate.
+		// Zero disables caching, so that each call compiles its expression.
+		static void capacity(size_t value);
+	};
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L && defined(__cpp_lib_constexpr_vector)
+#define SUPERSTRING_STATIC_REGEX 1
+
+	// A string literal usable as a template argument, as in parse<"id=([0-9]+)">(id).
+	template <size_t N>
+	struct fixed_string
+	{
+		char value[N] = { };
+
+		constexpr fixed_string(const char (&literal)[N]) { for (size_t i = 0; i < N; ++i) value[i] = literal[i]; }
+
+		constexpr size_t length() const { return N - 1; }
+	};
+
+	namespace detail
+	{
+		// An instruction of an expression compiled by static_compiler. Jumps are relative.
+		struct static_inst
+		{
+			enum op_type : uint8_t { chr, set, any, split, jmp, save, bol, eol, match };
+
+			op_type op = match;
+			unsigned char c = 0;
+			int x = 0;
+			int y = 0;
+		};
+
+		// A set of byte values, as 256 bits.
+		struct static_set
+		{
+			uint64_t bits[4] = { };
+
+			constexpr void add(unsigned char c) { bits[c >> 6] |= uint64_t(1) << (c & 63); }
+			constexpr bool test(unsigned char c) const { return ((bits[c >> 6] >> (c & 63)) & 1) != 0; }
+		};
+
+		// Compiles the ECMAScript subset supported by parse<"...">: literals, escapes, '.', bracket
+		// classes, capturing and (?:) groups, alternation, the greedy and lazy quantifiers *, +, ?
+		// and {n,m}, and the anchors ^ and $. Anything else throws std::regex_error, which in a
+		// constant expression stops compilation at the throw.
+		class static_compiler
+		{
+		public:
+
+			std::vector<static_inst> code;
+			std::vector<static_set> sets;
+			size_t groups = 0;
+
+			constexpr static_compiler(const char* expression, size_t length) : _at(expression), _end(expression + length)
+			{
+				emit(static_inst::save, 0, 0);
+				alternation();
+				if (_at != _end) throw std::regex_error(std::regex_constants::error_paren); // Unbalanced ')'.
+				emit(static_inst::save, 0, 1);
+				emit(static_inst::match);
+			}
+
+		private:
+
+			const char* _at;
+			const char* _end;
+
+			constexpr size_t emit(static_inst::op_type op, unsigned char c = 0, int x = 0)
+			{
+				static_inst i;
+				i.op = op;
+				i.c = c;
+				i.x = x;
+				code.push_back(i);
+				if (code.size() > 4096) throw std::regex_error(std::regex_constants::error_complexity); // Too large to compile.
+				return code.size() - 1;
+			}
+
+			// Inserts a split before the code from start, to the code and past its end.
+			constexpr void insert_split(size_t start)
+			{
+				static_inst i;
+				i.op = static_inst::split;
+				i.x = 1;
+				i.y = int(code.size() + 1 - start);
+				code.insert(code.begin() + start, i);
+			}
+
+			constexpr void alternation()
+			{
+				size_t start = code.size();
+
+				sequence();
+
+				if (_at == _end || *_at != '|')
+					return;
+
+				++_at;
+				insert_split(start);
+
+				size_t jump = emit(static_inst::jmp);
+
+				code[start].y = int(code.size() - start);
+				alternation();
+				code[jump].x = int(code.size() - jump);
+			}
+
+			constexpr void sequence()
+			{
+				while (_at != _end && *_at != '|' && *_at != ')')
+				{
+					size_t start = code.size();
+
+					atom();
+					quantifier(start);
+				}
+			}
+
+			constexpr void quantifier(size_t start)
+			{
+				if (_at == _end)
+					return;
+
+				size_t low = 0, high = 1;
+				bool bounded = true;
+
+				switch (*_at)
+				{
+				case '*': bounded = false; break;
+				case '+': low = 1; bounded = false; break;
+				case '?': break;
+				case '{':
+					++_at;
+					low = high = number();
+					if (_at != _end && *_at == ',')
+					{
+						++_at;
+						if (_at != _end && *_at == '}') bounded = false;
+						else high = number();
+					}
+					if (_at == _end || *_at != '}' || high < low) throw std::regex_error(std::regex_constants::error_badbrace);
+					break;
+				default: return;
+				}
+
+				++_at;
+
+				bool lazy = _at != _end && *_at == '?';
+
+				if (lazy) ++_at;
+
+				std::vector<static_inst> block(code.begin() + start, code.end());
+
+				code.resize(start);
+
+				for (size_t i = 0; i < low; ++i)
+					append(block);
+
+				if (!bounded)
+				{
+					if (low > 0)
+					{
+						// The last copy loops: e+ is e, then a split back to it.
+						size_t last = code.size() - block.size();
+						size_t split = emit(static_inst::split);
+						code[split].x = int(last) - int(split);
+						code[split].y = 1;
+						if (lazy) std::swap(code[split].x, code[split].y);
+					}
+					else
+					{
+						// e* is a split over e, which jumps back to the split.
+						size_t split = code.size();
+						append(block);
+						insert_split(split);
+						size_t jump = emit(static_inst::jmp);
+						code[jump].x = int(split) - int(jump);
+						code[split].y = int(code.size() - split);
+						if (lazy) std::swap(code[split].x, code[split].y);
+					}
+				}
+				else for (size_t i = low; i < high; ++i)
+				{
+					size_t split = code.size();
+					append(block);
+					insert_split(split);
+					if (lazy) std::swap(code[split].x, code[split].y);
+				}
+			}
+
+			constexpr void append(const std::vector<static_inst>& block)
+			{
+				for (const auto& i : block)
+				{
+					code.push_back(i);
+					if (code.size() > 4096) throw std::regex_error(std::regex_constants::error_complexity); // Too large to compile.
+				}
+			}
+
+			constexpr size_t number()
+			{
+				if (_at == _end || *_at < '0' || *_at > '9') throw std::regex_error(std::regex_constants::error_badbrace);
+
+				size_t result = 0;
+
+				while (_at != _end && *_at >= '0' && *_at <= '9')
+					result = result * 10 + size_t(*_at++ - '0');
+
+				return result;
+			}
+
+			constexpr void atom()
+			{
+				char c = *_at++;
+
+				switch (c)
+				{
+				case '(':
+				{
+					size_t group = 0;
+
+					if (_at != _end && *_at == '?')
+					{
+						if (_end - _at < 2 || _at[1] != ':') throw std::regex_error(std::regex_constants::error_complexity); // Lookahead is not supported.
+						_at += 2;
+					}
+					else group = ++groups;
+
+					if (group > 0) emit(static_inst::save, 0, int(2 * group));
+					alternation();
+					if (_at == _end || *_at != ')') throw std::regex_error(std::regex_constants::error_paren); // Unbalanced '('.
+					++_at;
+					if (group > 0) emit(static_inst::save, 0, int(2 * group + 1));
+					break;
+				}
+				case '[': bracket(); break;
+				case '.': emit(static_inst::any); break;
+				case '^': emit(static_inst::bol); break;
+				case '$': emit(static_inst::eol); break;
+				case '*': case '+': case '?': case '{': throw std::regex_error(std::regex_constants::error_badrepeat); // Nothing to repeat.
+				case '\\':
+				{
+					static_set s;
+					if (class_escape(s)) emit_set(s);
+					else emit(static_inst::chr, character_escape(false));
+					break;
+				}
+				default: emit(static_inst::chr, (unsigned char)c);
+				}
+			}
+
+			constexpr void emit_set(const static_set& s)
+			{
+				sets.push_back(s);
+				emit(static_inst::set, 0, int(sets.size() - 1));
+			}
+
+			constexpr void bracket()
+			{
+				static_set s;
+				bool negate = _at != _end && *_at == '^';
+
+				if (negate) ++_at;
+
+				while (_at != _end && *_at != ']')
+				{
+					unsigned char low = 0;
+
+					if (*_at == '\\')
+					{
+						++_at;
+						if (class_escape(s)) continue;
+						low = character_escape(true);
+					}
+					else low = (unsigned char)*_at++;
+
+					if (_end - _at >= 2 && *_at == '-' && _at[1] != ']')
+					{
+						++_at;
+
+						unsigned char high = 0;
+
+						if (*_at == '\\')
+						{
+							++_at;
+							high = character_escape(true);
+						}
+						else high = (unsigned char)*_at++;
+
+						if (high < low) throw std::regex_error(std::regex_constants::error_range);
+
+						for (unsigned i = low; i <= high; ++i)
+							s.add((unsigned char)i);
+					}
+					else s.add(low);
+				}
+
+				if (_at == _end) throw std::regex_error(std::regex_constants::error_brack);
+
+				++_at;
+
+				if (negate)
+					for (auto& b : s.bits) b = ~b;
+
+				emit_set(s);
+			}
+
+			// Adds \d, \w or \s, or their complements, to s, and returns true; else false.
+			constexpr bool class_escape(static_set& s)
+			{
+				if (_at == _end) throw std::regex_error(std::regex_constants::error_escape);
+
+				char kind = *_at;
+
+				switch (kind)
+				{
+				case 'd': case 'D': case 'w': case 'W': case 's': case 'S': break;
+				default: return false;
+				}
+
+				++_at;
+
+				bool complement = kind == 'D' || kind == 'W' || kind == 'S';
+
+				for (unsigned i = 0; i < 256; ++i)
+				{
+					bool digit = i >= '0' && i <= '9';
+					bool member = false;
+
+					switch (kind)
+					{
+					case 'd': case 'D': member = digit; break;
+					case 'w': case 'W': member = digit || (i >= 'a' && i <= 'z') || (i >= 'A' && i <= 'Z') || i == '_'; break;
+					default: member = i == ' ' || (i >= '\t' && i <= '\r'); break;
+					}
+
+					if (member != complement) s.add((unsigned char)i);
+				}
+
+				return true;
+			}
+
+			constexpr unsigned char character_escape(bool in_bracket)
+			{
+				if (_at == _end) throw std::regex_error(std::regex_constants::error_escape);
+
+				char c = *_at++;
+
+				switch (c)
+				{
+				case 'n': return '\n';
+				case 'r': return '\r';
+				case 't': return '\t';
+				case 'f': return '\f';
+				case 'v': return '\v';
+				case '0': return '\0';
+				case 'x':
+				{
+					unsigned value = 0;
+					for (int i = 0; i < 2; ++i)
+					{
+						char h = _at != _end ? *_at++ : '\0';
+						if (h >= '0' && h <= '9') value = value * 16 + unsigned(h - '0');
+						else if (h >= 'a' && h <= 'f') value = value * 16 + unsigned(h - 'a' + 10);
+						else if (h >= 'A' && h <= 'F') value = value * 16 + unsigned(h - 'A' + 10);
+						else throw std::regex_error(std::regex_constants::error_escape);
+					}
+					return (unsigned char)value;
+				}
+				case 'b':
+					if (in_bracket) return '\b';
+					throw std::regex_error(std::regex_constants::error_complexity); // Word boundaries are not supported.
+				case 'B': case 'c': case 'u': case 'k':
+					throw std::regex_error(std::regex_constants::error_complexity); // Not supported.
+				default:
+					if (c >= '1' && c <= '9') throw std::regex_error(std::regex_constants::error_backref); // Back references are not supported.
+					return (unsigned char)c;
+				}
+			}
+		};
+
+		// An expression compiled when compiling, searched by a Pike VM: leftmost-first, as for
+		// ECMAScript, in time linear in the input, and without allocation.
+		template <fixed_string Expression>
+		class static_regex
+		{
+		private:
+
+			static constexpr size_t code_size = static_compiler(Expression.value, Expression.length()).code.size();
+			static constexpr size_t set_size = static_compiler(Expression.value, Expression.length()).sets.size();
+
+		public:
+
+			// The count of capture groups, and of the bounds stored by search.
+			static constexpr size_t groups = static_compiler(Expression.value, Expression.length()).groups;
+			static constexpr size_t slots = 2 * (groups + 1);
+
+		private:
+
+			struct program
+			{
+				static_inst code[code_size];
+				static_set sets[set_size > 0 ? set_size : 1];
+			};
+
+			static constexpr program compile()
+			{
+				static_compiler compiler(Expression.value, Expression.length());
+				program result { };
+
+				for (size_t i = 0; i < code_size; ++i) result.code[i] = compiler.code[i];
+				for (size_t i = 0; i < set_size; ++i) result.sets[i] = compiler.sets[i];
+
+				return result;
+			}
+
+			static constexpr program _program = compile();
+
+			// Adds the bytes which can start a match from pc to result, or all if it can match empty.
+			static constexpr void first_bytes(size_t pc, bool* visited, static_set& result)
+			{
+				if (visited[pc])
+					return;
+
+				visited[pc] = true;
+
+				const static_inst& i = _program.code[pc];
+
+				switch (i.op)
+				{
+				case static_inst::chr: result.add(i.c); break;
+				case static_inst::set: for (size_t b = 0; b < 4; ++b) result.bits[b] |= _program.sets[i.x].bits[b]; break;
+				case static_inst::any: case static_inst::match: for (auto& b : result.bits) b = ~uint64_t(0); break;
+				case static_inst::jmp: first_bytes(size_t(int(pc) + i.x), visited, result); break;
+				case static_inst::split:
+					first_bytes(size_t(int(pc) + i.x), visited, result);
+					first_bytes(size_t(int(pc) + i.y), visited, result);
+					break;
+				default: first_bytes(pc + 1, visited, result); break;
+				}
+			}
+
+			static constexpr static_set first_bytes()
+			{
+				bool visited[code_size] = { };
+				static_set result;
+
+				first_bytes(0, visited, result);
+
+				return result;
+			}
+
+			// The bytes a match can start with, to skip positions where none can. All bytes if the
+			// expression can match empty, so a match at the end is possible only if it is full.
+			static constexpr static_set _first = first_bytes();
+			static constexpr bool _full = (_first.bits[0] & _first.bits[1] & _first.bits[2] & _first.bits[3]) == ~uint64_t(0);
+
+			// The threads at one position, in priority order, with a mark per instruction.
+			struct thread_list
+			{
+				size_t count;
+				size_t pc[code_size];
+				unsigned mark[code_size];
+				const char* captures[code_size][slots];
+			};
+
+			// Follows the non-consuming instructions from pc, adding the threads they reach.
+			static void add(thread_list& list, unsigned generation, size_t pc, const char** captures, const char* at, const char* first, const char* last)
+			{
+				if (list.mark[pc] == generation)
+					return;
+
+				list.mark[pc] = generation;
+
+				const static_inst& i = _program.code[pc];
+
+				switch (i.op)
+				{
+				case static_inst::jmp:
+					add(list, generation, size_t(int(pc) + i.x), captures, at, first, last);
+					break;
+				case static_inst::split:
+					add(list, generation, size_t(int(pc) + i.x), captures, at, first, last);
+					add(list, generation, size_t(int(pc) + i.y), captures, at, first, last);
+					break;
+				case static_inst::save:
+				{
+					const char* saved = captures[i.x];
+					captures[i.x] = at;
+					add(list, generation, pc + 1, captures, at, first, last);
+					captures[i.x] = saved;
+					break;
+				}
+				case static_inst::bol:
+					if (at == first) add(list, generation, pc + 1, captures, at, first, last);
+					break;
+				case static_inst::eol:
+					if (at == last) add(list, generation, pc + 1, captures, at, first, last);
+					break;
+				default:
+					list.pc[list.count] = pc;
+					std::copy(captures, captures + slots, list.captures[list.count]);
+					++list.count;
+				}
+			}
+
+		public:
+
+			// Searches [first, last) for the leftmost match, as std::regex_search does, and stores
+			// the bounds of the match and of each group in captures, null for a group not taken.
+			static bool search(const char* first, const char* last, const char* (&captures)[slots])
+			{
+				thread_list lists[2];
+				const char* scratch[slots];
+				thread_list* now = &lists[0];
+				thread_list* next = &lists[1];
+				unsigned generation = 1;
+				bool matched = false;
+
+				std::fill(lists[0].mark, lists[0].mark + code_size, 0U);
+				std::fill(lists[1].mark, lists[1].mark + code_size, 0U);
+				now->count = 0;
+
+				for (const char* at = first; ; ++at)
+				{
+					// Until a match is found, a new thread starts at each position, at lowest priority.
+					if (!matched)
+					{
+						if (now->count == 0)
+						{
+							while (at != last && !_first.test((unsigned char)*at))
+								++at;
+
+							if (at == last && !_full)
+								break;
+						}
+
+						if (at != last ? _first.test((unsigned char)*at) : _full)
+						{
+							std::fill(scratch, scratch + slots, nullptr);
+							add(*now, generation, 0, scratch, at, first, last);
+						}
+					}
+
+					// No thread is left here; unless a match was found, one may yet start further on.
+					if (now->count == 0)
+					{
+						if (matched || at == last)
+							break;
+
+						++generation;
+						continue;
+					}
+
+					++generation;
+					next->count = 0;
+
+					for (size_t t = 0; t < now->count; ++t)
+					{
+						const static_inst& i = _program.code[now->pc[t]];
+						bool step = false;
+
+						switch (i.op)
+						{
+						case static_inst::chr: step = at != last && (unsigned char)*at == i.c; break;
+						case static_inst::set: step = at != last && _program.sets[i.x].test((unsigned char)*at); break;
+						case static_inst::any: step = at != last && *at != '\n' && *at != '\r'; break;
+						default: break;
+						}
+
+						if (step)
+							add(*next, generation, now->pc[t] + 1, now->captures[t], at + 1, first, last);
+						else if (i.op == static_inst::match)
+						{
+							// Lower priority threads are cut; higher ones in next may still match.
+							matched = true;
+							std::copy(now->captures[t], now->captures[t] + slots, captures);
+							break;
+						}
+					}
+
+					if (at == last)
+						break;
+
+					std::swap(now, next);
+				}
+
+				return matched;
+			}
+		};
+	}
+#endif
+
+	template <typename Alloc> class basic_string;
+	typedef basic_string<std::allocator<char>> string;
+	class token_range;
+	class match_range;
+	class string_table;
+	class pattern;
+	class replacer;
+	class searcher;
+
+	// A non-owning, read-only view of a character sequence, carrying the same null semantics
+	// as string. The viewed characters must outlive the view, and need not be null-terminated.
+	class string_view
+	{
+	public:
+
+		typedef const char* iterator;
+		typedef const char* const_iterator;
+
+		// Indicates no position, or all remaining characters.
+		static const size_t npos = size_t(-1);
+
+	private:
+
+		const char* _data;
+		size_t _length;
+		bool _null;
+
+	public:
+
+		inline string_view() : _data(""), _length(0), _null(false) { }
+		inline string_view(const char* value) : _data(value == nullptr ? "" : value), _length(value == nullptr ? 0 : std::strlen(value)), _null(value == nullptr) { }
+		inline string_view(const char* value, size_t length) : _data(value == nullptr ? "" : value), _length(value == nullptr ? 0 : length), _null(value == nullptr) { }
+		inline string_view(const std::string& value) : _data(value.c_str()), _length(value.length()), _null(false) { }
+		template <typename Alloc> inline string_view(const basic_string<Alloc>& value);
+
+	public:
+
+		// Gets a pointer to the first viewed character. Not necessarily null-terminated.
+		inline const char* data() const { return _data; }
+
+		// Gets the length of this view in characters, or zero if null.
+		inline size_t length() const { return _length; }
+		inline size_t size() const { return _length; }
+
+		inline const_iterator begin() const { return _data; }
+		inline const_iterator end() const { return _data + _length; }
+
+		inline char operator[](size_t index) const { return _data[index]; }
+
+		// Copies the viewed characters into a new string, preserving null.
+		string to_string() const;
+
+	public:
+
+		// True if the view is marked as null.
+		inline bool is_null() const { return _null; }
+
+		// True if the view is null or zero-length.
+		inline bool is_empty() const { return _length == 0; }
+
+		// True if the view is not null and not zero-length.
+		inline bool non_empty() const { return _length > 0; }
+
+		// True if this has a length of one.
+		inline bool is_char() const { return _length == 1; }
+
+		// Gets the first character, or '\0'.
+		inline char head() const { return _length == 0 ? '\0' : _data[0]; }
+
+		// Gets the last character, or '\0'.
+		inline char tail() const { return _length == 0 ? '\0' : _data[_length - 1]; }
+
+	public:
+
+		// Compares this view with value, from left to right, returning the relative difference.
+		// Returns 1 if this is greater than value, -1 if value is greater than this, else 0 if they are equal.
+		int compare_to(const char* value) const;
+
+		// Compares this view with value, from left to right, returning the relative difference.
+		// Returns 1 if this is greater than value, -1 if value is greater than this, else 0 if they are equal.
+		int compare_to(const string_view& value) const;
+
+		// Compares this view with value, from right to left, returning the relative difference.
+		// Returns 1 if this is greater than value, -1 if value is greater than this, else 0 if they are equal.
+		int reverse_compare_to(const char* value) const;
+
+		// Compares this view with value, from right to left, returning the relative difference.
+		// Returns 1 if this is greater than value, -1 if value is greater than this, else 0 if they are equal.
+		int reverse_compare_to(const string_view& value) const;
+
+		// Computes the Levenshtein distance between this and value.
+		unsigned long long distance(const string_view& value) const;
+
+		// Computes a 128-bit hash code using the Murmur3 method, with the optional seed.
+		// Returns the specified qword part of the 128-bit result.
+		// Part defaults to the low qword, with a seed of zero.
+		unsigned long long hash_code(hash_code_part part = hash_code_part::low, unsigned long long seed = 0) const;
+
+	public:
+
+		// Returns whether this matches the regular expression, as in string::match.
+		bool match(const char* expression, bool caseless = false
+#if __cplusplus > 201402L
+			, bool multiline = false
+#endif
+		) const;
+
+		// Ranges lazily over the matches of the expression, as in string::match_each.
+		match_range match_each(const char* expression, bool caseless = false
+#if __cplusplus > 201402L
+			, bool multiline = false
+#endif
+		) const;
+
+	public:
+
+		// Gets the subview at start, with count characters.
+		string_view substring(size_t start, size_t count = npos) const;
+
+		// Takes the left-hand count of characters as a subview.
+		string_view left(size_t count) const;
+
+		// Takes the right-hand count of characters as a subview.
+		string_view right(size_t count) const;
+
+		// Gets the subview without leading whitespace.
+		string_view trim_left() const;
+
+		// Gets the subview without leading occurences of the specified characters.
+		string_view trim_left(const char* chars) const;
+
+		// Gets the subview without following whitespace.
+		string_view trim_right() const;
+
+		// Gets the subview without following occurences of the specified characters.
+		string_view trim_right(const char* chars) const;
+
+		// Gets the subview without leading and following whitespace.
+		string_view trim() const;
+
+		// Gets the subview without leading and following occurences of the specified characters.
+		string_view trim(const char* chars) const;
+
+		// True if this is composed only of the given characters (excluding the terminating null).
+		bool consists_of(const char* chars) const;
+
+		// True if this starts with value. If insensitive is true, then compare caseless.
+		bool starts_with(const char* value, bool insensitive = false) const;
+
+		// True if this ends with value. If insensitive is true, then compare caseless.
+		bool ends_with(const char* value, bool insensitive = false) const;
+
+		// Finds the first index of value, from left to right, starting at the optional offset.
+		// Returns the index, or -1 if not found.
+		int index_of(char value, size_t start = npos) const;
+
+		// Finds the last index of value, from right to left, starting at the optional offset from end.
+		// Returns the index, or -1 if not found.
+		int last_index_of(char value, size_t start = npos) const;
+
+		// Finds the first index of the substring value, from left to right, starting at the
+		// optional offset. Returns the index, or -1 if not found.
+		int index_of(const string_view& value, size_t start = npos) const;
+
+		// Finds the last index of the substring value, from right to left, starting at the
+		// optional offset from end. Returns the index, or -1 if not found.
+		int last_index_of(const string_view& value, size_t start = npos) const;
+
+		// Finds the first offset of value at or after start. Unlike index_of, the offset is not
+		// narrowed to int. Returns the offset, or npos if not found.
+		size_t offset_of(char value, size_t start = 0) const;
+		size_t offset_of(const string_view& value, size_t start = 0) const;
+
+		// Finds the last offset of value which ends at least start characters from the end.
+		// Unlike last_index_of, the offset is not narrowed to int. Returns the offset, or npos
+		// if not found.
+		size_t last_offset_of(char value, size_t start = 0) const;
+		size_t last_offset_of(const string_view& value, size_t start = 0) const;
+
+		// Finds the first offset of the needle of searcher at or after start.
+		// Returns the offset, or npos if not found.
+		size_t offset_of(const searcher& value, size_t start = 0) const;
+
+		// True if this contains the substring value, or the needle of searcher.
+		bool contains(const string_view& value) const;
+		bool contains(const searcher& value) const;
+
+		// Counts the instances of the character value, or the characters which are in set, in this.
+		size_t count(char value) const;
+		size_t count(const char* set) const;
+
+		// Counts the non-overlapping instances of the substring value, or the needle of searcher,
+		// in this. A const char* is read as a set, so a literal substring is counted as in
+		// count(string_view("ab")); a super::string is counted as a substring.
+		size_t count(const string_view& value) const;
+		size_t count(const searcher& value) const;
+		template <typename Alloc> inline size_t count(const basic_string<Alloc>& value) const { return count(string_view(value)); }
+
+		// Appends the offsets of the non-overlapping instances of the substring value, or the
+		// needle of searcher, in this to offsets, which may be reused across calls.
+		// Returns the count appended.
+		size_t find_all(const string_view& value, std::vector<size_t>& offsets) const;
+		size_t find_all(const searcher& value, std::vector<size_t>& offsets) const;
+
+	public:
+
+		// Tokenizes this using the single delimiter, and appends views of the tokens to result vector.
+		// Returns the count of tokens appended.
+		size_t split(char delimiter, std::vector<string_view>& result) const;
+
+		// Tokenizes this using the single delimiter, and returns a vector of views of the tokens.
+		std::vector<string_view> split(char delimiter) const;
+
+		// Tokenizes this using the delimiters, and appends views of the tokens to result vector.
+		// Returns the count of tokens appended.
+		size_t split(const char* delimiters, std::vector<string_view>& result) const;
+
+		// Tokenizes this using the delimiters, and returns a vector of views of the tokens.
+		std::vector<string_view> split(const char* delimiters) const;
+
+		// Tokenizes this using the needle of delimiter, a multi-character delimiter, and appends
+		// views of the tokens to result vector. As with split on characters, leading delimiters
+		// are skipped, and adjacent or trailing ones give empty tokens. Returns the count of
+		// tokens appended.
+		size_t split(const searcher& delimiter, std::vector<string_view>& result) const;
+
+		// Tokenizes this using the delimiters, and appends views of the tokens, and each encountered 
+		// delimiter as a separate view, to the result vector. Delimiters in omit, if non-null 
+		// will not be retained.
+		// Returns the count of tokens (including delimiters) captured.
+		size_t split_with(const char* delimiters, std::vector<string_view>& result, const char* omit = nullptr) const;
+
+		// Tokenizes this using the single delimiter, and appends views of the tokens, and each 
+		// encountered delimiter as a separate view, to the result vector.
+		// Returns the count of tokens (including delimiters) captured.
+		size_t split_with(char delimiter, std::vector<string_view>& result) const;
+
+		// Tokenizes this as with split or split_with, and appends copies of the tokens to the table.
+		// Returns the count of tokens appended.
+		size_t split(char delimiter, string_table& result) const;
+		size_t split(const char* delimiters, string_table& result) const;
+		size_t split_with(char delimiter, string_table& result) const;
+		size_t split_with(const char* delimiters, string_table& result, const char* omit = nullptr) const;
+
+		// Lazily tokenizes this using the single delimiter or the delimiters, as with split.
+		token_range tokens(char delimiter) const;
+		token_range tokens(const char* delimiters) const;
+
+		// Lazily tokenizes this using the single delimiter or the delimiters, also yielding each
+		// encountered delimiter not in omit as a separate token, as with split_with.
+		token_range tokens_with(char delimiter) const;
+		token_range tokens_with(const char* delimiters, const char* omit = nullptr) const;
+
+	public:
+
+		// Returns true if this is formatted as a decimal integer with an optional sign.
+		bool is_decimal_integer() const;
 
-namespace super
-{
-	// Hash code part for 128 bit hashes.
-	enum class hash_code_part
+		// Returns true if this is formatted as a decimal integer with a sign.
+		bool is_signed_decimal_integer() const;
+
+		// Returns true if this is formatted as an unsigned decimal integer.
+		bool is_unsigned_decimal_integer() const;
+
+		// Returns true if this is formatted as a hexadecimal integer.
+		bool is_hexadecimal_integer() const;
+
+		// Returns true if this is formatted as an octal integer with the "0" prefix.
+		bool is_octal_integer() const;
+
+		// Returns true if this is formatted as a binary integer with the "0b" prefix.
+		bool is_binary_integer() const;
+
+		// Returns true if this is formatted as a decimal, hexadecimal, or octal integer.
+		bool is_integer() const;
+
+		// Returns true if this is formatted as a boolean.
+		bool is_boolean() const;
+
+		// Returns true if this is formatted as a decimal floating point value.
+		bool is_decimal_float() const;
+
+		// Returns true if this is formatted as a hexadecimal floating point value.
+		bool is_hexadecimal_float() const;
+
+		// Returns true if this is formatted as a decimal or hexadecimal floating point value.
+		bool is_float() const;
+
+	public:
+
+		// Attempts to parse this as an integer value in binary, octal, decimal or hexadecimal format.
+		// Returns true if the operation succeeded.
+		// If the operation failed, result and negative will not be set.
+		bool parse_integer(unsigned long long& result, bool& negative) const;
+
+		// Attempts to parse this as a floating point number.
+		// Returns true if the operation succeeded, and result will be set.
+		// If the operation failed, result will not be set.
+		bool parse_float(long double& result) const;
+
+		// Attempts to parse this as a boolean.
+		// Returns true if the operation succeeded, and result will be set.
+		// If the operation failed, result will not be set.
+		bool parse_boolean(bool& result) const;
+
+	public:
+
+		bool to_bool() const;
+		char to_char() const;
+		unsigned char to_byte() const;
+		short to_short() const;
+		unsigned short to_ushort() const;
+		int to_int() const;
+		unsigned int to_uint() const;
+		long to_long() const;
+		unsigned long to_ulong() const;
+		long long to_llong() const;
+		unsigned long long to_ullong() const;
+		float to_float() const;
+		double to_double() const;
+		long double to_ldouble() const;
+	};
+
+	// A lazy forward range over the tokens of a view, as produced by split or split_with, which
+	// scans one token per increment. Iterators are valid while the range and its source are.
+	class token_range
 	{
-		// Low qword.
-		low,
+	public:
 
-		// High qword.
-		high,
+		class iterator
+		{
+		public:
 
-		// XOR of low, high.
-		both
+			typedef std::forward_iterator_tag iterator_category;
+			typedef string_view value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const string_view* pointer;
+			typedef const string_view& reference;
+
+		private:
+
+			const token_range* _range;
+			const char* _next;
+			string_view _current;
+
+		public:
+
+			inline iterator() : _range(nullptr), _next(nullptr) { }
+			inline iterator(const token_range* range, const char* next) : _range(range), _next(next) { ++*this; }
+
+			inline reference operator*() const { return _current; }
+			inline pointer operator->() const { return &_current; }
+
+			inline iterator& operator++()
+			{
+				if (_range != nullptr && !_range->next(_next, _current))
+					_range = nullptr;
+				return *this;
+			}
+
+			inline iterator operator++(int) { iterator result(*this); ++*this; return result; }
+
+			inline bool operator==(const iterator& value) const { return _range == value._range && (_range == nullptr || _current.data() == value._current.data()); }
+			inline bool operator!=(const iterator& value) const { return !(*this == value); }
+		};
+
+	private:
+
+		string_view _source;
+		char_set _delimiters;
+		char_set _omit;
+		bool _with;
+
+	public:
+
+		// Ranges over the tokens of source separated by any of the delimiters. If with is true,
+		// each encountered delimiter not in omit is also yielded as a separate token.
+		token_range(const string_view& source, const char* delimiters, const char* omit = nullptr, bool with = false);
+
+		// Ranges over the tokens of source separated by the single delimiter. If with is true,
+		// each encountered delimiter is also yielded as a separate token.
+		token_range(const string_view& source, char delimiter, bool with = false);
+
+		inline iterator begin() const { return iterator(this, _source.begin()); }
+		inline iterator end() const { return iterator(); }
+
+	private:
+
+		// Scans the next token starting at position, advancing position past it.
+		// Returns false if there are no more tokens.
+		bool next(const char*& position, string_view& token) const;
+	};
+
+	// A lazy forward range over the non-overlapping matches of an expression in a view, as
+	// produced by match_each, which searches for one match per increment. Each element gives the
+	// matched view and its capture groups, as views into the source. Iterators are valid while
+	// the range and its source are; each holds its own match results, reused as it advances.
+	// An expression with a DFA is scanned as match_all scans it, a window at a time, and
+	// std::regex only fills in the groups of each match found.
+	class match_range
+	{
+	private:
+
+		struct scan;
+
+	public:
+
+		// A match, and its capture groups.
+		class match
+		{
+		private:
+
+			friend class match_range;
+
+			std::cmatch _parts;
+			const char* _source = nullptr;
+
+		public:
+
+			// Gets the matched view.
+			inline string_view view() const { return group(0); }
+			inline operator string_view() const { return group(0); }
+
+			// Gets the count of groups, including the whole match as group 0.
+			inline size_t size() const { return _parts.size(); }
+
+			// Gets the view of the group at index, or a null view if it did not take part.
+			inline string_view group(size_t index) const
+			{
+				return index < _parts.size() && _parts[index].matched ? string_view(_parts[index].first, size_t(_parts[index].length())) : string_view(nullptr);
+			}
+
+			// Gets the offset of the match from the start of the source.
+			inline size_t position() const { return size_t(_parts[0].first - _source); }
+		};
+
+		class iterator
+		{
+		public:
+
+			typedef std::forward_iterator_tag iterator_category;
+			typedef match value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const match* pointer;
+			typedef const match& reference;
+
+		private:
+
+			const match_range* _range;
+			const char* _next;
+			bool _not_null;
+			match _current;
+			std::shared_ptr<const scan> _scan;
+
+		public:
+
+			inline iterator() : _range(nullptr), _next(nullptr), _not_null(false) { }
+			inline iterator(const match_range* range, const char* next) : _range(range), _next(next), _not_null(false)
+			{
+				if (next == nullptr) _range = nullptr;
+				else { _current._source = range->_source.begin(); ++*this; }
+			}
+
+			inline reference operator*() const { return _current; }
+			inline pointer operator->() const { return &_current; }
+
+			inline iterator& operator++()
+			{
+				if (_range != nullptr && !_range->next(_next, _not_null, _current._parts, _scan))
+					_range = nullptr;
+				return *this;
+			}
+
+			inline iterator operator++(int) { iterator result(*this); ++*this; return result; }
+
+			inline bool operator==(const iterator& value) const { return _range == value._range && (_range == nullptr || _next == value._next); }
+			inline bool operator!=(const iterator& value) const { return !(*this == value); }
+		};
+
+	private:
+
+		string_view _source;
+		std::shared_ptr<const regex_cache::compiled> _regex;
+
+	public:
+
+		// Ranges over the matches of the expression, compiled with flags through regex_cache, in
+		// source. Throws std::regex_error if the expression is invalid.
+		match_range(const string_view& source, const char* expression, std::regex_constants::syntax_option_type flags = std::regex_constants::ECMAScript);
+
+		// Ranges over the matches of an already compiled expression in source. A null
+		// expression or empty source has no matches.
+		match_range(const string_view& source, std::shared_ptr<const regex_cache::compiled> regex);
+
+		// Starts at the first position the expression's prefilter allows.
+		iterator begin() const;
+		inline iterator end() const { return iterator(); }
+
+	private:
+
+		// Searches for the next match from position into parts, advancing position past it, and
+		// replacing scan with the DFA's scan of a window further on when it passes the current
+		// one. Returns false if there are no more matches.
+		bool next(const char*& position, bool& not_null, std::cmatch& parts, std::shared_ptr<const scan>& scan) const;
+	};
+
+	// How a parallel match_all splits its input: into chunks of size characters, scanned on up
+	// to threads threads, or as many as the hardware runs if zero. Each chunk's scan looks past
+	// its end as far as a match starting in it can run, up to overlap characters; a chunk whose
+	// matches may run further is scanned sequentially instead.
+	struct chunking
+	{
+		size_t size = size_t(1) << 20;
+		size_t overlap = 4096;
+		size_t threads = 0;
+	};
+
+	// A contiguous table of strings, which stores the characters of all elements in one arena
+	// buffer with a packed array of offsets, so that appending costs no allocation per element.
+	// Elements are read as views, which are valid until the table is next modified. Clearing
+	// keeps the capacity, so one table can be reused across calls.
+	class string_table
+	{
+	public:
+
+		class iterator
+		{
+		public:
+
+			typedef std::random_access_iterator_tag iterator_category;
+			typedef string_view value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const string_view* pointer;
+			typedef string_view reference;
+
+		private:
+
+			const string_table* _table;
+			size_t _index;
+
+		public:
+
+			inline iterator() : _table(nullptr), _index(0) { }
+			inline iterator(const string_table* table, size_t index) : _table(table), _index(index) { }
+
+			inline reference operator*() const { return (*_table)[_index]; }
+			inline reference operator[](difference_type offset) const { return (*_table)[_index + offset]; }
+
+			inline iterator& operator++() { ++_index; return *this; }
+			inline iterator operator++(int) { iterator result(*this); ++_index; return result; }
+			inline iterator& operator--() { --_index; return *this; }
+			inline iterator operator--(int) { iterator result(*this); --_index; return result; }
+			inline iterator& operator+=(difference_type offset) { _index += offset; return *this; }
+			inline iterator& operator-=(difference_type offset) { _index -= offset; return *this; }
+			inline iterator operator+(difference_type offset) const { return iterator(_table, _index + offset); }
+			inline iterator operator-(difference_type offset) const { return iterator(_table, _index - offset); }
+			inline difference_type operator-(const iterator& value) const { return difference_type(_index) - difference_type(value._index); }
+
+			inline bool operator==(const iterator& value) const { return _index == value._index; }
+			inline bool operator!=(const iterator& value) const { return _index != value._index; }
+			inline bool operator<(const iterator& value) const { return _index < value._index; }
+		};
+
+	private:
+
+		std::string _bytes;
+		std::vector<size_t> _offsets;
+
+	public:
+
+		inline string_table() : _offsets(1, 0) { }
+
+		// Gets the count of elements.
+		inline size_t size() const { return _offsets.size() - 1; }
+
+		// True if there are no elements.
+		inline bool empty() const { return _offsets.size() == 1; }
+
+		// Gets the total count of characters in all elements.
+		inline size_t bytes() const { return _bytes.size(); }
+
+		// Gets a view of the element at index.
+		inline string_view operator[](size_t index) const { return string_view(_bytes.data() + _offsets[index], _offsets[index + 1] - _offsets[index]); }
+
+		inline string_view front() const { return (*this)[0]; }
+		inline string_view back() const { return (*this)[size() - 1]; }
+
+		inline iterator begin() const { return iterator(this, 0); }
+		inline iterator end() const { return iterator(this, size()); }
+
+		// Appends a copy of value as a new element.
+		inline void push_back(const string_view& value)
+		{
+			_bytes.append(value.data(), value.length());
+			_offsets.push_back(_bytes.size());
+		}
+
+		// Removes all elements, keeping the allocated capacity.
+		inline void clear()
+		{
+			_bytes.clear();
+			_offsets.resize(1);
+		}
+
+		// Reserves space for count elements, and the given total count of characters.
+		void reserve(size_t count, size_t bytes = 0);
+
+		// Copies the elements into a vector of strings.
+		std::vector<string> to_vector() const;
 	};
 
-	class string : public std::string
+	// An extended string, built on std::basic_string with the given allocator. Use the string
+	// alias for the default allocator, or pmr::string for a polymorphic memory resource, such
+	// as a request-scoped arena. Copies, including those made by the const variants, use the
+	// allocator of the source string.
+	template <typename Alloc>
+	class basic_string : public std::basic_string<char, std::char_traits<char>, Alloc>
 	{
 	public:
 
 		// Our base type.
-		typedef std::string base_type;
+		typedef std::basic_string<char, std::char_traits<char>, Alloc> base_type;
+
+		// Our allocator type.
+		typedef Alloc allocator_type;
 
 	private:
 
@@ -66,25 +1487,32 @@ namespace super
 
 	public:
 
-		string();
-		string(size_t size, char initial);
-		string(const string& value);
-		string(string&& value);
-		explicit string(const char* value);
-		explicit string(const std::string& value);
+		basic_string();
+		basic_string(size_t size, char initial);
+		basic_string(const basic_string& value);
+		basic_string(basic_string&& value) noexcept;
+		explicit basic_string(const char* value);
+		explicit basic_string(const std::string& value);
+		explicit basic_string(const string_view& value);
+
+		// An empty string using allocator.
+		explicit basic_string(const Alloc& allocator);
+
+		// A copy of value using allocator, preserving null.
+		basic_string(const string_view& value, const Alloc& allocator);
 
 	public:
 
 		// Simple assignment.
-		string& assign(const string& value);
-		string& assign(const std::string& value);
-		string& assign(const char* value);
+		basic_string& assign(const basic_string& value);
+		basic_string& assign(const std::string& value);
+		basic_string& assign(const char* value);
 
-		string& operator=(const char* value);
-		string& operator=(const string& value);
-		string& operator=(const std::string& value);
-		string& operator=(string&& value);
-		string& operator=(std::string&& value);
+		basic_string& operator=(const char* value);
+		basic_string& operator=(const basic_string& value);
+		basic_string& operator=(const std::string& value);
+		basic_string& operator=(basic_string&& value);
+		basic_string& operator=(std::string&& value);
 
 		operator const char*() const;
 		operator const std::string() const;
@@ -118,13 +1546,13 @@ namespace super
 	public:
 
 		// Nullifies this instance.
-		string& nullify();
+		basic_string& nullify();
 
 		// Clears this, returning this.
-		string& clear();
+		basic_string& clear();
 
 		// Clones this instance.
-		string clone() const;
+		basic_string clone() const;
 
 	public:
 
@@ -148,44 +1576,160 @@ namespace super
 		// True if this has a length of one.
 		bool is_char() const;
 
-		// Gets the first character, or '\0'.
-		char head() const;
+		// Gets the first character, or '\0'.
+		char head() const;
+
+		// Gets the last character, or '\0'.
+		char tail() const;
+
+	public:
+
+		// Returns whether this matches the regular expression, using the flags:
+		// std::regex_constants::extended.
+		// If caseless is true, or C++17 and multiline is true, adds these flags
+		// as well.
+		bool match(const char* expression, bool caseless = false
+#if __cplusplus > 201402L
+			, bool multiline = false
+#endif
+		) const;
+
+		// Matches the expression like in match above, and returns all of the matches, 
+		// or an empty vector if no matches or is_empty.
+		std::vector<basic_string> match_all(const char* expression, bool caseless = false
+#if __cplusplus > 201402L
+			, bool multiline = false
+#endif
+		) const;
+
+		// Matches the expression like in match above, and appends all of the matches to the
+		// contiguous table. Returns the count of matches appended.
+		size_t match_all(const char* expression, string_table& result, bool caseless = false
+#if __cplusplus > 201402L
+			, bool multiline = false
+#endif
+		) const;
+
+		// Matches the expression like in match above, and appends views of all of the matches
+		// to result, which can be reused across calls. Returns the count of matches appended.
+		size_t match_all(const char* expression, std::vector<string_view>& result, bool caseless = false
+#if __cplusplus > 201402L
+			, bool multiline = false
+#endif
+		) const;
+
+		// Matches the expression like in match above, appending views of the matches to result,
+		// but scans chunks of this on several threads, as set by chunks, and merges them in order.
+		// An expression without a DFA is scanned sequentially. The results are always those of
+		// the sequential match_all. Returns the count of matches appended.
+		size_t match_all(const char* expression, std::vector<string_view>& result, const chunking& chunks, bool caseless = false
+#if __cplusplus > 201402L
+			, bool multiline = false
+#endif
+		) const;
+
+		// Matches the expression like in match above, and returns a lazy range over the matches,
+		// which searches for one match per increment, so that iteration can stop early.
+		match_range match_each(const char* expression, bool caseless = false
+#if __cplusplus > 201402L
+			, bool multiline = false
+#endif
+		) const;
+
+	private:
+
+		typedef std::match_results<typename base_type::const_iterator> match_type;
+
+		// Copies the captured group at index, with our allocator.
+		basic_string group(const match_type& parts, size_t index) const
+		{
+			return basic_string(string_view(base_type::data() + (parts[index].first - base_type::begin()), size_t(parts.length(index))), base_type::get_allocator());
+		}
+
+		// Searches this for the expression into parts, from where its prefilter allows.
+		bool search(const regex_cache::compiled& regex, match_type& parts) const
+		{
+			const char* first = base_type::data();
+			const char* start = regex.start(first, first + base_type::length());
+
+			return start != nullptr && std::regex_search(base_type::begin() + (start - first), base_type::end(), parts, regex.regex, regex_cache::compiled::flags(first, start));
+		}
+
+		size_t collect(bool strict, match_type& parts, size_t& count, size_t& index) const { return index; }
+
+		// Converts field into value, without an intermediate string for the built-in types.
+		static void convert(const string_view& field, bool& value) { value = field.to_bool(); }
+		static void convert(const string_view& field, char& value) { value = field.to_char(); }
+		static void convert(const string_view& field, unsigned char& value) { value = field.to_byte(); }
+		static void convert(const string_view& field, short& value) { value = field.to_short(); }
+		static void convert(const string_view& field, unsigned short& value) { value = field.to_ushort(); }
+		static void convert(const string_view& field, int& value) { value = field.to_int(); }
+		static void convert(const string_view& field, unsigned int& value) { value = field.to_uint(); }
+		static void convert(const string_view& field, long& value) { value = field.to_long(); }
+		static void convert(const string_view& field, unsigned long& value) { value = field.to_ulong(); }
+		static void convert(const string_view& field, long long& value) { value = field.to_llong(); }
+		static void convert(const string_view& field, unsigned long long& value) { value = field.to_ullong(); }
+		static void convert(const string_view& field, float& value) { value = field.to_float(); }
+		static void convert(const string_view& field, double& value) { value = field.to_double(); }
+		static void convert(const string_view& field, long double& value) { value = field.to_ldouble(); }
+		static void convert(const string_view& field, std::string& value) { value.assign(field.data(), field.length()); }
+		static void convert(const string_view& field, string_view& value) { value = field; }
+		template <typename T>
+		static void convert(const string_view& field, T& value) { value = T(field); }
+
+		// True if field converts to the arithmetic T without loss, as is_strictly.
+		template <typename T>
+		static bool is_strict_field(const string_view& field, std::true_type) { return is_strictly<T>(field); }
+
+		// True if field is not null, for the other types, which take any characters.
+		template <typename T>
+		static bool is_strict_field(const string_view& field, std::false_type) { return !field.is_null(); }
+
+		// Matches the literal text of format against at, up to the next {} or the end of format.
+		// Advances both past the text; returns false if it does not match, or format has no {}.
+		static bool format_literal(const char*& format, const char*& at, const char* last);
+
+		// Finds the end of the field at at, whose {} is followed by format: the start of the
+		// following literal text, the first whitespace if another {} follows, else last.
+		// Returns null if the following literal text is not found, which is a mismatch.
+		static const char* format_field(const char* format, const char* at, const char* last);
+
+		size_t format_fields(bool, const char*, const char*, size_t count) const { return count; }
+
+		// Converts the fields for parse_format, one per {}, stopping at the first mismatch.
+		template <typename T, typename... Args>
+		size_t format_fields(bool strict, const char* format, const char* at, size_t count, T& value, Args&... args) const
+		{
+			const char* last = base_type::data() + base_type::length();
+
+			if (!format_literal(format, at, last))
+				return count;
+
+			format += 2;
 
-		// Gets the last character, or '\0'.
-		char tail() const;
+			const char* end = format_field(format, at, last);
 
-	public:
+			if (end == nullptr)
+				return count;
 
-		// Returns whether this matches the regular expression, using the flags:
-		// std::regex_constants::extended.
-		// If caseless is true, or C++17 and multiline is true, adds these flags
-		// as well.
-		bool match(const char* expression, bool caseless = false
-#if __cplusplus > 201402L
-			, bool multiline = false
-#endif
-		) const;
+			string_view field(at, size_t(end - at));
 
-		// Matches the expression like in match above, and returns all of the matches, 
-		// or an empty vector if no matches or is_empty.
-		std::vector<string> match_all(const char* expression, bool caseless = false
-#if __cplusplus > 201402L
-			, bool multiline = false
-#endif
-		) const;
+			if (strict && !is_strict_field<T>(field, std::is_arithmetic<T>()))
+				return count;
 
-	private:
+			convert(field, value);
 
-		size_t collect(bool strict, std::smatch& parts, size_t& count, size_t& index) const { return index; }
+			return format_fields(strict, format, end, count + 1, args ...);
+		}
 
 		// Strictly collects elements for parse.
 		template <typename T, typename... Args>
-		size_t collect(bool strict, std::smatch& parts, size_t& count, size_t& index, T& value, Args&... args) const
+		size_t collect(bool strict, match_type& parts, size_t& count, size_t& index, T& value, Args&... args) const
 		{
 			++index;
 			if (index < count)
 			{
-				string str(parts[index].str());
+				basic_string str(group(parts, index));
 				if (strict && !is_strictly<T>(str)) // Validate it.
 					return index - 1;
 				value = T(str);
@@ -202,18 +1746,18 @@ namespace super
 		template<typename T, typename... Args>
 		size_t parse(const char* expression, T& first, Args&... args) const
 		{
-			std::regex regex;
+			std::shared_ptr<const regex_cache::compiled> regex;
 			
-			try { regex = std::regex(expression); }
+			try { regex = regex_cache::get_compiled(expression); }
 			catch (std::regex_error& e) 
 			{
 				std::cerr << e.what() << std::endl;
 				return 0; 
 			}
 
-			std::smatch parts;
+			match_type parts;
 
-			if (!std::regex_search(*this, parts, regex))
+			if (!search(*regex, parts))
 				return 0;
 
 			size_t count = parts.size();
@@ -222,7 +1766,7 @@ namespace super
 			if (count > 1)
 			{
 				++index;
-				first = T(string(parts[index].str()));
+				first = T(group(parts, index));
 				if (count > index)
 					return collect(false, parts, count, index, args ...);
 				else return 1;
@@ -236,18 +1780,18 @@ namespace super
 		template<typename T, typename... Args>
 		size_t parse(bool strict, const char* expression, T& first, Args&... args) const
 		{
-			std::regex regex;
+			std::shared_ptr<const regex_cache::compiled> regex;
 
-			try { regex = std::regex(expression); }
+			try { regex = regex_cache::get_compiled(expression); }
 			catch (std::regex_error& e)
 			{
 				std::cerr << e.what() << std::endl;
 				return 0;
 			}
 
-			std::smatch parts;
+			match_type parts;
 
-			if (!std::regex_search(*this, parts, regex))
+			if (!search(*regex, parts))
 				return 0;
 
 			size_t count = parts.size();
@@ -256,7 +1800,7 @@ namespace super
 			if (count > 1)
 			{
 				++index;
-				string str(parts[index].str());
+				basic_string str(group(parts, index));
 				if (strict && !is_strictly<T>(str))
 					return index - 1;
 				first = T(str);
@@ -267,81 +1811,177 @@ namespace super
 			else return 0;
 		}
 
+		// Assigns the fields of this, delimited as in format, to the arguments in order, like scanf
+		// but without a regular expression, and without allocating for the built-in types. Each {}
+		// in format is a field, which extends to the literal text that follows it, to the next
+		// whitespace if another {} follows, or to the end; {{ and }} are literal braces, and other
+		// characters must match exactly, from the start. A field whose following literal text is
+		// not found is a mismatch. Returns the count of parameters converted, stopping at the
+		// first mismatch.
+		template <typename T, typename... Args>
+		size_t parse_format(const char* format, T& first, Args&... args) const
+		{
+			return format == nullptr || is_null() ? 0 : format_fields(false, format, base_type::data(), 0, first, args ...);
+		}
+
+		// As parse_format, but if strict, stops at the first field which cannot be converted to its
+		// argument without loss, as parse does. Returns the count of parameters converted.
+		template <typename T, typename... Args>
+		size_t parse_format(bool strict, const char* format, T& first, Args&... args) const
+		{
+			return format == nullptr || is_null() ? 0 : format_fields(strict, format, base_type::data(), 0, first, args ...);
+		}
+
+#ifdef SUPERSTRING_STATIC_REGEX
+		// Using a regular expression compiled when compiling, assigns the captured groups to the
+		// arguments in order, as parse does, converting directly from the matched characters. The
+		// expression, and that there is one argument per capture group, are checked when compiling;
+		// see detail::static_compiler for the syntax supported. If Strict, stops at the first group
+		// which cannot be converted without loss. Returns the count of parameters converted.
+		template <fixed_string Expression, bool Strict = false, typename... Args>
+		size_t parse(Args&... args) const
+		{
+			typedef detail::static_regex<Expression> regex;
+
+			static_assert(sizeof...(Args) == regex::groups, "parse<expression> takes one argument per capture group");
+
+			const char* captures[regex::slots];
+
+			if (!regex::search(base_type::data(), base_type::data() + base_type::length(), captures))
+				return 0;
+
+			size_t count = 0;
+
+			(void)(... && (assign_group<Strict>(args, captures[2 * count + 2], captures[2 * count + 3]) && ++count));
+
+			return count;
+		}
+
+	private:
+
+		// Converts the characters of a captured group into value. Returns false if Strict and the
+		// group cannot be converted without loss, or was not taken.
+		template <bool Strict, typename T>
+		static bool assign_group(T& value, const char* first, const char* last)
+		{
+			string_view group(first, size_t(last - first));
+
+			if (Strict && !std::is_same<T, string_view>::value && !is_strict_field<T>(group, std::is_arithmetic<T>()))
+				return false;
+
+			convert(group, value);
+
+			return true;
+		}
+
+	public:
+#endif
+
 	public:
 
 		// Gets the substring copy at start, with count characters.
-		string substring(size_t start, size_t count = std::string::npos) const;
+		basic_string substring(size_t start, size_t count = base_type::npos) const;
 
 		// Trims leading whitespace, in place.
-		string& trim_left();
+		basic_string& trim_left() &;
 
 		// Copies this and trims leading whitespace
-		string trim_left() const;
+		basic_string trim_left() const &;
+
+		// Trims leading whitespace from this temporary, in place, and moves it out.
+		basic_string trim_left() &&;
 
 		// Trims leading occurences of the specified characters, in place.
-		string& trim_left(const char* chars);
+		basic_string& trim_left(const char* chars) &;
 
 		// Copies this and trims leading whitespace.
-		string trim_left(const char* chars) const;
+		basic_string trim_left(const char* chars) const &;
+
+		// Trims leading occurences of the specified characters from this temporary, and moves it out.
+		basic_string trim_left(const char* chars) &&;
 
 		// Trims following whitespace, in place.
-		string& trim_right();
+		basic_string& trim_right() &;
 
 		// Copies this and trims following whitespace.
-		string trim_right() const;
+		basic_string trim_right() const &;
+
+		// Trims following whitespace from this temporary, in place, and moves it out.
+		basic_string trim_right() &&;
 
 		// Trims following occurences of the specified characters, in place.
-		string& trim_right(const char* chars);
+		basic_string& trim_right(const char* chars) &;
 
 		// Copies this and trims following occurences of the specified characters.
-		string trim_right(const char* chars) const;
+		basic_string trim_right(const char* chars) const &;
+
+		// Trims following occurences of the specified characters from this temporary, and moves it out.
+		basic_string trim_right(const char* chars) &&;
 
 		// Trims all leading and following whitespace, in place.
-		string& trim();
+		basic_string& trim() &;
 
 		// Copies this and trims all leading and following whitespace.
-		string trim() const;
+		basic_string trim() const &;
+
+		// Trims all leading and following whitespace from this temporary, and moves it out.
+		basic_string trim() &&;
 
 		// Trims all leading and following occurences of the specified characters, in place.
-		string& trim(const char* chars);
+		basic_string& trim(const char* chars) &;
 
 		// Copies this and trims all leading and following occurences of the specified characters.
-		string trim(const char* chars) const;
+		basic_string trim(const char* chars) const &;
+
+		// Trims all leading and following occurences of the specified characters from this temporary, and moves it out.
+		basic_string trim(const char* chars) &&;
 
 		// Transforms this to upper-case, in place.
-		string& to_upper();
+		basic_string& to_upper() &;
 
 		// Copies this and transforms it to upper-case.
-		string to_upper() const;
+		basic_string to_upper() const &;
+
+		// Transforms this temporary to upper-case, in place, and moves it out.
+		basic_string to_upper() &&;
 
 		// Transforms this to lower-case, in place.
-		string& to_lower();
+		basic_string& to_lower() &;
 
 		// Copies this and transforms it to lower-case.
-		string to_lower() const;
+		basic_string to_lower() const &;
+
+		// Transforms this temporary to lower-case, in place, and moves it out.
+		basic_string to_lower() &&;
 
 		// Transforms this using the specified method, in place.
-		string& transform(char (*method)(char));
+		basic_string& transform(char (*method)(char)) &;
 
 		// Copies this and transforms it using the specified method.
-		string transform(char (*method)(char)) const;
+		basic_string transform(char (*method)(char)) const &;
+
+		// Transforms this temporary using the specified method, in place, and moves it out.
+		basic_string transform(char (*method)(char)) &&;
 
 		// Appends count generated characters to this by calling the specified method count times, 
 		// unless method returns '\0', in which case it stops.
 		// Returns this after the generation completes.
-		string& generate(size_t count, char (*method)(size_t index));
+		basic_string& generate(size_t count, char (*method)(size_t index));
 
 		// Reverses this, in place.
-		string& reverse();
+		basic_string& reverse() &;
 
 		// Copies this and reverses it.
-		string reverse() const;
+		basic_string reverse() const &;
+
+		// Reverses this temporary, in place, and moves it out.
+		basic_string reverse() &&;
 
 		// Takes the left-hand count of characters as a substring.
-		string left(size_t count) const;
+		basic_string left(size_t count) const;
 
 		// Takes the right-hand count of characters as a substring.
-		string right(size_t count) const;
+		basic_string right(size_t count) const;
 
 		// True if this is composed only of the given characters (excluding the terminating null).
 		bool consists_of(const char* chars) const;
@@ -354,130 +1994,277 @@ namespace super
 
 		// Finds the first index of value, from left to right, starting at the optional offset.
 		// Returns the index, or -1 if not found.
-		int index_of(char value, size_t start = std::string::npos) const;
+		int index_of(char value, size_t start = base_type::npos) const;
 
 		// Finds the last index of value, from right to left, starting at the optional offset from end.
 		// Returns the index, or -1 if not found.
-		int last_index_of(char value, size_t start = std::string::npos) const;
+		int last_index_of(char value, size_t start = base_type::npos) const;
+
+		// Finds the first index of the substring value, from left to right, starting at the
+		// optional offset. Returns the index, or -1 if not found.
+		int index_of(const string_view& value, size_t start = base_type::npos) const;
+
+		// Finds the last index of the substring value, from right to left, starting at the
+		// optional offset from end. Returns the index, or -1 if not found.
+		int last_index_of(const string_view& value, size_t start = base_type::npos) const;
+
+		// Finds the first offset of value at or after start. Unlike index_of, the offset is not
+		// narrowed to int. Returns the offset, or npos if not found.
+		size_t offset_of(char value, size_t start = 0) const;
+		size_t offset_of(const string_view& value, size_t start = 0) const;
+
+		// Finds the last offset of value which ends at least start characters from the end.
+		// Unlike last_index_of, the offset is not narrowed to int. Returns the offset, or npos
+		// if not found.
+		size_t last_offset_of(char value, size_t start = 0) const;
+		size_t last_offset_of(const string_view& value, size_t start = 0) const;
+
+		// Finds the first offset of the needle of searcher at or after start.
+		// Returns the offset, or npos if not found.
+		size_t offset_of(const searcher& value, size_t start = 0) const;
+
+		// True if this contains the substring value, or the needle of searcher.
+		bool contains(const string_view& value) const;
+		bool contains(const searcher& value) const;
+
+		// Counts the instances of the character value, or the characters which are in set, in this.
+		size_t count(char value) const;
+		size_t count(const char* set) const;
+
+		// Counts the non-overlapping instances of the substring value, or the needle of searcher,
+		// in this. A const char* is read as a set, so a literal substring is counted as in
+		// count(string_view("ab")); a super::string is counted as a substring.
+		size_t count(const string_view& value) const;
+		size_t count(const searcher& value) const;
+		template <typename A> inline size_t count(const basic_string<A>& value) const { return count(string_view(value)); }
+
+		// Appends the offsets of the non-overlapping instances of the substring value, or the
+		// needle of searcher, in this to offsets, which may be reused across calls.
+		// Returns the count appended.
+		size_t find_all(const string_view& value, std::vector<size_t>& offsets) const;
+		size_t find_all(const searcher& value, std::vector<size_t>& offsets) const;
 
 		// Replaces the first instance of value in this with substitute. 
 		// Returns this modified instance.
-		string& replace(const std::string& value, const std::string& substitute);
+		basic_string& replace(const std::string& value, const std::string& substitute) &;
 
 		// Copies and replaces the first instance of value in with substitute. 
 		// Returns the modified copy.
-		string replace(const std::string& value, const std::string& substitute) const;
+		basic_string replace(const std::string& value, const std::string& substitute) const &;
+
+		// Replaces the first instance of value in this temporary with substitute, and moves it out.
+		basic_string replace(const std::string& value, const std::string& substitute) &&;
 
 		// Replaces the first instance of value, in-place, with substitute. 
 		// Returns this modified instance.
-		string& replace(const char* value, const char* substitute);
+		basic_string& replace(const char* value, const char* substitute) &;
 
 		// Copies and replaces the first instance of value in with substitute. 
 		// Returns the modified copy.
-		string replace(const char* value, const char* substitute) const;
+		basic_string replace(const char* value, const char* substitute) const &;
 
-		// Replaces all instances of value in this with replacement. 
-		// Returns this modified instance.
-		string& replace_all(const std::string& value, const std::string& replacement);
+		// Replaces the first instance of value in this temporary with substitute, and moves it out.
+		basic_string replace(const char* value, const char* substitute) &&;
+
+		// Replaces all instances of value in this with replacement, in place if they have the
+		// same length, else in one pass over an output sized exactly for the instances counted.
+		// An empty value has no instances. Returns this modified instance.
+		basic_string& replace_all(const std::string& value, const std::string& replacement) &;
 
 		// Copies and replaces all instances of value in the copy with replacement. 
 		// Returns the modified copy.
-		string replace_all(const std::string& value, const std::string& replacement) const;
+		basic_string replace_all(const std::string& value, const std::string& replacement) const &;
+
+		// Replaces all instances of value in this temporary with replacement, and moves it out.
+		basic_string replace_all(const std::string& value, const std::string& replacement) &&;
 
 		// Replaces all instances of value in this with replacement. 
 		// Returns this modified instance.
-		string& replace_all(const char* value, const char* replacement);
+		basic_string& replace_all(const char* value, const char* replacement) &;
 
 		// Copies and replaces all instances of value in the copy with replacement. 
 		// Returns the modified copy.
-		string replace_all(const char* value, const char* replacement) const;
+		basic_string replace_all(const char* value, const char* replacement) const &;
+
+		// Replaces all instances of value in this temporary with replacement, and moves it out.
+		basic_string replace_all(const char* value, const char* replacement) &&;
+
+		// Replaces the first instance of the needle of value in this with substitute, or copies
+		// and replaces it in the copy, or replaces it in this temporary and moves it out.
+		basic_string& replace(const searcher& value, const char* substitute) &;
+		basic_string replace(const searcher& value, const char* substitute) const &;
+		basic_string replace(const searcher& value, const char* substitute) &&;
+
+		// Replaces all instances of the needle of value in this with replacement, or in a copy,
+		// or in this temporary, which is moved out, in one pass as with the literal replace_all.
+		basic_string& replace_all(const searcher& value, const char* replacement) &;
+		basic_string replace_all(const searcher& value, const char* replacement) const &;
+		basic_string replace_all(const searcher& value, const char* replacement) &&;
+
+		// Replaces the keys of replacements in this with their values, all in one pass over an
+		// output sized exactly. Returns the count of replacements made.
+		size_t replace_all(const replacer& replacements);
+
+		// Replaces the keys of replacements in this with their values, as with a replacer built
+		// from them. Returns the count of replacements made.
+		size_t replace_all(const std::vector<std::pair<std::string, std::string>>& replacements);
+
+		// Replaces each non-overlapping match of expression in this with replacement, in which, as
+		// for std::regex_replace, $n or $nn stands for group n, $& for the match, $` for the
+		// text since the previous match, $' for the text after it, and $$ for $. The result is
+		// built in one buffer, sized exactly before it is written. Returns the count of replacements.
+		size_t replace_all(const pattern& expression, const char* replacement);
+
+		// Replaces each non-overlapping match of expression in this with what callback returns
+		// for its match_range::match, as anything a string_view can be made from. The result is
+		// built in one buffer, reserved for the length of this. Returns the count of replacements.
+		template <typename Callback>
+		size_t replace_all(const pattern& expression, Callback callback);
 
 		// Appends the specified value to this instance, returning this.
-		string& append(const std::string& value);
-		string append(const char* value) const;
-		string append(const std::string& value) const;
-		string& append(char value);
-		string append(char value) const;
-		string& append(bool value);
-		string& append(unsigned char value);
-		string& append(short value);
-		string& append(unsigned short value);
-		string& append(int value);
-		string& append(unsigned int value);
-		string& append(long value);
-		string& append(unsigned long value);
-		string& append(long long value);
-		string& append(unsigned long long value);
-		string& append(float value);
-		string& append(double value);
-		string& append(long double value);
-
-		// Formats and appends to this using the specified format string, and optional arguments.
-		// Returns true if the operation succeeded, else false.
-		bool append(const char* format, ...);
+		basic_string& append(const char* value) &;
+		basic_string& append(const std::string& value) &;
+		basic_string append(const char* value) const &;
+		basic_string append(const char* value) &&;
+		basic_string append(const std::string& value) const &;
+		basic_string append(const std::string& value) &&;
+		basic_string& append(char value) &;
+		basic_string append(char value) const &;
+		basic_string append(char value) &&;
+		basic_string& append(bool value);
+		basic_string& append(unsigned char value);
+		basic_string& append(short value);
+		basic_string& append(unsigned short value);
+		basic_string& append(int value);
+		basic_string& append(unsigned int value);
+		basic_string& append(long value);
+		basic_string& append(unsigned long value);
+		basic_string& append(long long value);
+		basic_string& append(unsigned long long value);
+		basic_string& append(float value);
+		basic_string& append(double value);
+		basic_string& append(long double value);
+
+		// Formats and appends to this using the specified format string, and one or more arguments.
+		// Returns true if the operation succeeded, else false. With no arguments, append(value)
+		// above appends the text as it is, and keeps any % in it.
+		template <typename T, typename... Args>
+		bool append(const char* format, T first, Args... args) { return append_format(format, first, args...); }
 
 		// Prepends the specified value to this instance, returning this.
-		string& prepend(const char* value);
-		string& prepend(const std::string& value);
-		string prepend(const char* value) const;
-		string prepend(const std::string& value) const;
-		string& prepend(char value);
-		string prepend(char value) const;
+		basic_string& prepend(const char* value) &;
+		basic_string& prepend(const std::string& value) &;
+		basic_string prepend(const char* value) const &;
+		basic_string prepend(const char* value) &&;
+		basic_string prepend(const std::string& value) const &;
+		basic_string prepend(const std::string& value) &&;
+		basic_string& prepend(char value) &;
+		basic_string prepend(char value) const &;
+		basic_string prepend(char value) &&;
 
 		// Attempts to format this using the specified format string, and optional arguments.
 		// Overwrites any existing value with the formatted result.
 		// Returns true if the operation succeeded, else false.
 		bool format(const char* format, ...);
 
+	private:
+
+		// Formats and appends to this, for the template append above with its arguments.
+		bool append_format(const char* format, ...);
+
 	public:
 
 		// Tokenizes this using the single delimiter, and appends the tokens to result vector.
 		// Returns the count of tokens appended.
-		size_t split(char delimiter, std::vector<string>& result) const;
+		size_t split(char delimiter, std::vector<basic_string>& result) const;
+
+		// Tokenizes this using the single delimiter, and appends views of the tokens to result vector,
+		// without copying this. The views are valid until this is modified or destroyed.
+		// Returns the count of tokens appended.
+		size_t split(char delimiter, std::vector<string_view>& result) const;
 
 		// Tokenizes this using the single delimiter, and returns a vector of the tokens.
-		std::vector<string> split(char delimiter) const;
+		std::vector<basic_string> split(char delimiter) const;
 
 		// Tokenizes this using the delimiters, and appends the tokens to result vector.
 		// Returns the count of tokens appended.
-		size_t split(const char* delimiters, std::vector<string>& result) const;
+		size_t split(const char* delimiters, std::vector<basic_string>& result) const;
+
+		// Tokenizes this using the delimiters, and appends views of the tokens to result vector,
+		// without copying this. The views are valid until this is modified or destroyed.
+		// Returns the count of tokens appended.
+		size_t split(const char* delimiters, std::vector<string_view>& result) const;
 
 		// Tokenizes this using the delimiters, and appends the tokens to result vector.
 		// Returns the count of tokens appended.
-		size_t split(const std::string& delimiters, std::vector<string>& result) const;
+		size_t split(const std::string& delimiters, std::vector<basic_string>& result) const;
 
 		// Tokenizes this using the delimiters, and returns a vector of the tokens.
-		std::vector<string> split(const char* delimiters) const;
+		std::vector<basic_string> split(const char* delimiters) const;
 
 		// Tokenizes this using the delimiters, and returns a vector of the tokens.
-		std::vector<string> split(const std::string& delimiters) const;
+		std::vector<basic_string> split(const std::string& delimiters) const;
+
+		// Tokenizes this using the needle of delimiter, a multi-character delimiter, and appends
+		// the tokens, or views of them, to result vector. As with split on characters, leading
+		// delimiters are skipped, and adjacent or trailing ones give empty tokens. Returns the
+		// count of tokens appended.
+		size_t split(const searcher& delimiter, std::vector<basic_string>& result) const;
+		size_t split(const searcher& delimiter, std::vector<string_view>& result) const;
 
 		// Tokenizes this using the delimiters, and appends the tokens, and each encountered 
 		// delimiter as a separate string, to the result vector.
 		// Returns the count of tokens (including delimiters) captured.
-		size_t split_with(const char* delimiters, std::vector<string>& result, const char* omit = nullptr) const;
+		size_t split_with(const char* delimiters, std::vector<basic_string>& result, const char* omit = nullptr) const;
+
+		// Tokenizes this using the delimiters, and appends views of the tokens, and each encountered 
+		// delimiter as a separate view, to the result vector, without copying this.
+		// Returns the count of tokens (including delimiters) captured.
+		size_t split_with(const char* delimiters, std::vector<string_view>& result, const char* omit = nullptr) const;
 
 		// Tokenizes this using the delimiters, and appends the tokens, and each encountered 
 		// delimiter as a separate string, to the result vector.
 		// Returns the count of tokens (including delimiters) captured.
-		size_t split_with(const std::string& delimiters, std::vector<string>& result) const;
+		size_t split_with(const std::string& delimiters, std::vector<basic_string>& result) const;
 
 		// Tokenizes this using the delimiters, and returns a vector of the tokens, and each encountered 
 		// delimiter as a separate string, to the result vector.
-		std::vector<string> split_with(const char* delimiters, const char* omit = nullptr) const;
+		std::vector<basic_string> split_with(const char* delimiters, const char* omit = nullptr) const;
 
 		// Tokenizes this using the delimiters, and returns a vector of the tokens, and each encountered 
 		// delimiter as a separate string, to the result vector.
-		std::vector<string> split_with(const std::string& delimiters) const;
+		std::vector<basic_string> split_with(const std::string& delimiters) const;
 
 		// Tokenizes this using the single delimiter, and appends the tokens, and each encountered 
 		// delimiter as a separate string, to the result vector.
 		// Returns the count of tokens (including delimiters) captured.
-		size_t split_with(char delimiter, std::vector<string>& result) const;
+		size_t split_with(char delimiter, std::vector<basic_string>& result) const;
+
+		// Tokenizes this using the single delimiter, and appends views of the tokens, and each 
+		// encountered delimiter as a separate view, to the result vector, without copying this.
+		// Returns the count of tokens (including delimiters) captured.
+		size_t split_with(char delimiter, std::vector<string_view>& result) const;
 
 		// Tokenizes this using the single delimiter, and returns a vector of the tokens
 		// with each separate delimiter as a string, in order.
-		std::vector<string> split_with(char delimiter) const;
+		std::vector<basic_string> split_with(char delimiter) const;
+
+		// Tokenizes this as with split or split_with, and appends the tokens to the contiguous table.
+		// Returns the count of tokens appended.
+		size_t split(char delimiter, string_table& result) const;
+		size_t split(const char* delimiters, string_table& result) const;
+		size_t split_with(char delimiter, string_table& result) const;
+		size_t split_with(const char* delimiters, string_table& result, const char* omit = nullptr) const;
+
+		// Lazily tokenizes this using the single delimiter or the delimiters, as with split, 
+		// yielding views of one token per increment. Stopping early skips the remaining scan.
+		token_range tokens(char delimiter) const;
+		token_range tokens(const char* delimiters) const;
+
+		// Lazily tokenizes this using the single delimiter or the delimiters, also yielding each 
+		// encountered delimiter not in omit as a separate token, as with split_with.
+		token_range tokens_with(char delimiter) const;
+		token_range tokens_with(const char* delimiters, const char* omit = nullptr) const;
 
 	public:
 
@@ -504,16 +2291,22 @@ namespace super
 		};
 
 		// Escapes this string. Return *this.
-		string& escape(escaping value);
+		basic_string& escape(escaping value) &;
 
 		// Copies this and returns an escaped copy.
-		string escape(escaping value) const;
+		basic_string escape(escaping value) const &;
+
+		// Escapes this temporary, in place, and moves it out.
+		basic_string escape(escaping value) &&;
 
 		// Removes C-style escapes from this.
-		string& unescape(escaping value);
+		basic_string& unescape(escaping value) &;
 
 		// Copies then removes C-style escapes from this.
-		string unescape(escaping value) const;
+		basic_string unescape(escaping value) const &;
+
+		// Removes the specified escaping from this temporary, in place, and moves it out.
+		basic_string unescape(escaping value) &&;
 
 	public:
 
@@ -552,7 +2345,7 @@ namespace super
 
 		// Determines whether value can be converted to the given type without overflow.
 		template <typename T>
-		inline static bool is_strictly(const string& value)
+		inline static bool is_strictly(const string_view& value)
 		{
 			if (std::is_arithmetic<T>::value)
 			{
@@ -572,7 +2365,7 @@ namespace super
 							value.is_octal_integer() ||
 							value.is_binary_integer()) &&
 							value.parse_integer(v, n))
-							return v >= nl && v <= vh;
+							return n ? v <= static_cast<unsigned long long>(-(vl + 1)) + 1ULL : v <= static_cast<unsigned long long>(vh);
 						else return false;
 					}
 					else
@@ -592,8 +2385,8 @@ namespace super
 				else if (std::is_floating_point<T>::value)
 				{
 					long double v = 0.0;
-					const long double vl = long double(std::numeric_limits<T>::min());
-					const long double vh = long double(std::numeric_limits<T>::max());
+					const long double vl = static_cast<long double>(std::numeric_limits<T>::lowest());
+					const long double vh = static_cast<long double>(std::numeric_limits<T>::max());
 					if ((value.is_decimal_integer() ||
 						value.is_signed_decimal_integer() ||
 						value.is_unsigned_decimal_integer() ||
@@ -627,7 +2420,7 @@ namespace super
 				return !value.is_null();
 			else if (std::is_same<T, const char*>::value)
 				return true;
-			else if (std::is_same<T, string>::value)
+			else if (std::is_same<T, basic_string>::value)
 				return true;
 			else return false;
 		}
@@ -683,6 +2476,443 @@ namespace super
 		inline operator double() const { return to_double(); }
 		inline operator long double() const { return to_ldouble(); }
 	};
+
+	template <typename Alloc>
+	inline string_view::string_view(const basic_string<Alloc>& value) : _data(value.c_str()), _length(value.length()), _null(value.is_null()) { }
+
+#if __cplusplus > 201402L
+	namespace pmr
+	{
+		// A string allocating from a std::pmr::memory_resource, such as an arena.
+		typedef basic_string<std::pmr::polymorphic_allocator<char>> string;
+	}
+#endif
+
+	// A regular expression compiled once, for matching and parsing many strings. Unlike the string
+	// methods, it does not print compile errors: an invalid pattern reports is_valid() false and
+	// its error, and matches nothing. The match results are reused across calls, so a pattern
+	// should not be shared between threads without synchronization; copies are independent.
+	class pattern
+	{
+	private:
+
+		std::shared_ptr<const regex_cache::compiled> _regex;
+		std::regex_constants::error_type _error;
+		std::string _message;
+		std::cmatch _parts;
+
+	public:
+
+		// Compiles expression, using the same flags as parse by default.
+		explicit pattern(const char* expression, std::regex_constants::syntax_option_type flags = std::regex_constants::ECMAScript);
+
+		// True if the expression compiled.
+		inline bool is_valid() const { return _regex != nullptr; }
+
+		// Gets the compile error code; meaningful only if not valid and expression was not null.
+		inline std::regex_constants::error_type error() const { return _error; }
+
+		// Gets the compile error message, or an empty string if valid.
+		inline const char* message() const { return _message.c_str(); }
+
+		// Gets the number of capture groups, or zero if not valid.
+		size_t groups() const;
+
+		// Gets the compiled expression, or null if not valid.
+		inline const std::shared_ptr<const regex_cache::compiled>& compiled() const { return _regex; }
+
+		// Returns true if value contains a match.
+		bool matches(const string_view& value);
+
+		// Appends views of each non-overlapping match in value to result.
+		// Returns the count of matches appended.
+		size_t find_all(const string_view& value, std::vector<string_view>& result);
+
+		// Appends each non-overlapping match in value to result.
+		// Returns the count of matches appended.
+		size_t find_all(const string_view& value, string_table& result);
+
+		// Assigns the captured groups of the first match in value to the arguments in order, 
+		// as string::parse does. Returns the count of parameters converted.
+		template <typename T, typename... Args>
+		size_t parse(const string_view& value, T& first, Args&... args)
+		{
+			return search(value) ? collect(false, 1, first, args ...) : 0;
+		}
+
+		// As parse, but stops at the first group which cannot be converted to its argument 
+		// without loss (see string::is_strictly). Returns the count of parameters converted.
+		template <typename T, typename... Args>
+		size_t parse_strictly(const string_view& value, T& first, Args&... args)
+		{
+			return search(value) ? collect(true, 1, first, args ...) : 0;
+		}
+
+	private:
+
+		// Searches value into the reused match results.
+		bool search(const string_view& value);
+
+		size_t collect(bool, size_t index) const { return index - 1; }
+
+		// Converts the group at index into value, then the rest.
+		template <typename T, typename... Args>
+		size_t collect(bool strict, size_t index, T& value, Args&... args) const
+		{
+			if (index >= _parts.size())
+				return index - 1;
+			string str(string_view(_parts[index].first, size_t(_parts[index].second - _parts[index].first)));
+			if (strict && !string::is_strictly<T>(str))
+				return index - 1;
+			value = T(str);
+			return collect(strict, index + 1, args ...);
+		}
+	};
+
+	// Replaces each non-overlapping match of expression in this with what callback returns for it.
+	template <typename Alloc>
+	template <typename Callback>
+	size_t basic_string<Alloc>::replace_all(const pattern& expression, Callback callback)
+	{
+		if (!expression.is_valid() || is_empty())
+			return 0;
+
+		base_type output(base_type::get_allocator());
+		const char* copied = base_type::data();
+		size_t count = 0;
+
+		output.reserve(base_type::length());
+
+		for (const match_range::match& match : match_range(*this, expression.compiled()))
+		{
+			const auto& replacement = callback(match);
+			const string_view view(replacement);
+
+			output.append(copied, size_t(match.view().begin() - copied));
+			output.append(view.begin(), view.length());
+			copied = match.view().end();
+			++count;
+		}
+
+		if (count == 0)
+			return 0;
+
+		output.append(copied, size_t(base_type::data() + base_type::length() - copied));
+		base_type::swap(output);
+
+		return count;
+	}
+
+	// A set of literal keywords, compiled to an Aho-Corasick automaton, which finds occurrences of
+	// all of them in one pass over a text, in time linear in the text and the matches reported.
+	// Transitions are a dense table indexed by state and byte class, where the classes are the
+	// distinct bytes of the keywords and one for all other bytes, so that each text byte costs
+	// one lookup. If caseless, ASCII letters match either case. Empty keywords never match.
+	// A built set is immutable, and may be searched from several threads.
+	class keyword_set
+	{
+	public:
+
+		// An occurrence of a keyword: its index in the set, and the view of it in the text.
+		struct match
+		{
+			size_t keyword;
+			string_view view;
+		};
+
+	private:
+
+		static const uint32_t none = 0xFFFFFFFFU;
+		static const uint32_t reports = 0x80000000U;
+
+		std::vector<std::string> _keywords;
+		bool _caseless;
+		unsigned char _classes[256];
+		size_t _class_count;
+		std::vector<uint32_t> _next;
+		std::vector<uint32_t> _output;
+		std::vector<uint32_t> _suffix;
+		std::vector<uint32_t> _same;
+
+	public:
+
+		// An empty set, which matches nothing.
+		keyword_set();
+
+		// Compiles the keywords, matched ignoring ASCII case if caseless.
+		explicit keyword_set(const std::vector<std::string>& keywords, bool caseless = false);
+		keyword_set(std::initializer_list<const char*> keywords, bool caseless = false);
+
+		// Gets the count of keywords.
+		inline size_t size() const { return _keywords.size(); }
+
+		// Gets the keyword at index.
+		inline const std::string& operator[](size_t index) const { return _keywords[index]; }
+
+		// True if keywords match ignoring ASCII case.
+		inline bool is_caseless() const { return _caseless; }
+
+		// Gets the count of automaton states, one per distinct keyword prefix.
+		inline size_t states() const { return _output.size(); }
+
+		// Finds the occurrence which ends first in text, the longest of those ending together.
+		// Returns false if no keyword occurs.
+		bool find_first(const string_view& text, match& result) const;
+
+		// Appends every occurrence of every keyword in text to result, including overlapping ones,
+		// ordered by where they end, longest first. Returns the count appended.
+		size_t find_all(const string_view& text, std::vector<match>& result) const;
+
+		// Sets mask, resized to hold a bit per keyword, so that bit i % 64 of mask[i / 64] tells
+		// whether keyword i occurs in text. Returns the count of distinct keywords found.
+		size_t find_mask(const string_view& text, std::vector<uint64_t>& mask) const;
+
+	private:
+
+		// Builds the automaton from _keywords.
+		void compile();
+
+		// Runs the automaton over text, calling emit(keyword, end) for each occurrence, until
+		// emit returns false.
+		template <typename Emit>
+		void scan(const string_view& text, Emit emit) const;
+	};
+
+	// A dictionary of literal replacements, compiled once into a keyword_set, which finds all the
+	// keys in a text in one pass. Where occurrences overlap, the leftmost wins, and of those
+	// starting together the longest, then the first listed. Empty keys never match. A built
+	// replacer is immutable, and may be used from several threads.
+	class replacer
+	{
+	private:
+
+		keyword_set _keys;
+		std::vector<std::string> _values;
+
+	public:
+
+		// Compiles the keys of replacements, matched ignoring ASCII case if caseless.
+		explicit replacer(const std::vector<std::pair<std::string, std::string>>& replacements, bool caseless = false);
+		replacer(std::initializer_list<std::pair<const char*, const char*>> replacements, bool caseless = false);
+
+		// Gets the count of replacements.
+		inline size_t size() const { return _values.size(); }
+
+		// Gets the key at index.
+		inline const std::string& key(size_t index) const { return _keys[index]; }
+
+		// Gets the value which replaces the key at index.
+		inline const std::string& value(size_t index) const { return _values[index]; }
+
+		// Appends the occurrences of keys in text which are replaced to result, in order and not
+		// overlapping. Returns the count appended.
+		size_t find(const string_view& text, std::vector<keyword_set::match>& result) const;
+	};
+
+	// A shell-style wildcard pattern, compiled once and matched without backtracking. * matches
+	// any run of characters, ? any one character, and [set] one character of a set of characters
+	// and ranges, negated by a leading ! or ^. A \ makes the next character literal, inside a
+	// set or out, and a [ with no closing ] is literal. If caseless, ASCII letters match either
+	// case. The pieces between stars are placed leftmost in turn, which never needs revisiting,
+	// so matching does not backtrack, and pieces with literal characters are found by a SIMD
+	// filter on two of them. A built glob is immutable, and may be matched from several threads.
+	class glob
+	{
+	private:
+
+		// A run of tokens between stars, from first for count tokens. The SIMD filter tests the
+		// first and last literal tokens, at offsets head and tail, which are npos if there are none.
+		struct piece
+		{
+			size_t first;
+			size_t count;
+			size_t head;
+			size_t tail;
+		};
+
+		// A token is a literal byte, lowered if caseless, or any, or -2 less the index of a set.
+		static const int any = -1;
+
+		std::string _pattern;
+		bool _caseless;
+		bool _anchored_start;
+		bool _anchored_end;
+		size_t _min_length;
+		std::vector<int> _tokens;
+		std::vector<uint64_t> _sets;
+		std::vector<piece> _pieces;
+
+	public:
+
+		// Compiles pattern, matched ignoring ASCII case if caseless. A null pattern matches nothing.
+		explicit glob(const char* pattern, bool caseless = false);
+
+		// Gets the source pattern.
+		inline const char* pattern() const { return _pattern.c_str(); }
+
+		// True if letters match ignoring ASCII case.
+		inline bool is_caseless() const { return _caseless; }
+
+		// Returns true if the whole of value matches. A null value matches nothing.
+		bool matches(const string_view& value) const;
+
+		// Appends to result the indexes of the values which match. Values may be of any type a
+		// string_view can be made from. Returns the count appended.
+		template <typename T>
+		size_t filter(const std::vector<T>& values, std::vector<size_t>& result) const
+		{
+			const size_t count = result.size();
+
+			for (size_t i = 0; i < values.size(); ++i)
+				if (matches(string_view(values[i])))
+					result.push_back(i);
+
+			return result.size() - count;
+		}
+
+	private:
+
+		// Returns true if the tokens of part match at p, which has room for them.
+		bool matches_at(const piece& part, const char* p) const;
+
+		// Finds the first place in [first, last) where part matches whole, or null if none.
+		const char* find(const piece& part, const char* first, const char* last) const;
+	};
+
+	// A substring searcher, built once for a needle and used on many haystacks. It picks its
+	// algorithm from the needle: memchr for one character; for up to pair_limit characters, the
+	// SIMD packed-pair filter on the needle's two rarest bytes, by a frequency ranking of typical
+	// text; for longer needles, Boyer-Moore-Horspool, whose shifts are long on a large alphabet,
+	// or Two-Way, which runs in linear time and constant space, where few distinct bytes would
+	// keep the shifts short. A built searcher is immutable, and may be used from several threads.
+	class searcher
+	{
+	public:
+
+		enum class algorithm { empty, byte, pair, horspool, two_way };
+
+		// The longest needle searched with the packed-pair filter.
+		static const size_t pair_limit = 32;
+
+	private:
+
+		std::string _needle;
+		algorithm _algorithm;
+		size_t _head;
+		size_t _tail;
+		size_t _suffix;
+		size_t _period;
+		bool _periodic;
+		std::vector<size_t> _shifts;
+
+	public:
+
+		// Builds a searcher for needle. A null needle is empty.
+		explicit searcher(const string_view& needle);
+
+		// Gets the needle.
+		inline const std::string& needle() const { return _needle; }
+
+		// Gets the length of the needle.
+		inline size_t length() const { return _needle.length(); }
+
+		// Gets the algorithm chosen for the needle.
+		inline algorithm chosen() const { return _algorithm; }
+
+		// Finds the first instance of the needle in [first, last), or last if none. An empty
+		// needle is found at first.
+		const char* find(const char* first, const char* last) const;
+
+		// Finds the first offset of the needle in haystack at or after start, or npos if none.
+		size_t find(const string_view& haystack, size_t start = 0) const;
+
+	private:
+
+		// Finds the first instance in [first, last) by Two-Way, or last if none.
+		const char* find_two_way(const char* first, const char* last) const;
+	};
+
+	// A compact, owning string for storing large numbers of values, such as in-memory indexes.
+	// It occupies 16 bytes, against 40 for string: values of up to 15 characters are stored
+	// inline, longer values on the heap, and the null state is encoded in the tag byte rather
+	// than in a separate flag. It has the same null semantics as string, and is read through
+	// string_view.
+	class compact_string
+	{
+	private:
+
+		// The last byte is the tag. For inline values the tag is 15 less the length, so that a
+		// 15-character value is terminated by its own tag. Heap values hold the pointer and the
+		// length in the leading bytes.
+		char _bytes[16];
+
+		static const unsigned char heap_tag = 0x80;
+		static const unsigned char null_tag = 0xFF;
+
+		inline unsigned char tag() const { return (unsigned char)_bytes[15]; }
+		inline bool is_heap() const { return tag() == heap_tag; }
+
+		inline const char* heap_data() const { char* p; std::memcpy(&p, _bytes, sizeof(p)); return p; }
+		size_t heap_length() const;
+
+	public:
+
+		compact_string();
+		compact_string(const compact_string& value);
+		compact_string(compact_string&& value);
+		explicit compact_string(const char* value);
+		explicit compact_string(const std::string& value);
+		explicit compact_string(const string_view& value);
+		~compact_string();
+
+	public:
+
+		// Simple assignment.
+		compact_string& assign(const string_view& value);
+
+		compact_string& operator=(const compact_string& value);
+		compact_string& operator=(compact_string&& value);
+		compact_string& operator=(const char* value);
+		compact_string& operator=(const string_view& value);
+
+		// Nullifies this instance.
+		compact_string& nullify();
+
+		// Clears this, returning this.
+		compact_string& clear();
+
+	public:
+
+		// True if the string is marked as null.
+		inline bool is_null() const { return tag() == null_tag; }
+
+		// True if the string is null or zero-length.
+		inline bool is_empty() const { return length() == 0; }
+
+		// True if the string is not null and not zero-length.
+		inline bool non_empty() const { return length() > 0; }
+
+		// Gets the length of this instance in characters, or zero if null.
+		inline size_t length() const { return tag() < 16 ? size_t(15 - tag()) : is_heap() ? heap_length() : 0; }
+
+		// Gets the null-terminated characters; an empty string if null.
+		inline const char* c_str() const { return is_heap() ? heap_data() : _bytes; }
+
+		// Gets the characters, or nullptr if null, as with string.
+		inline operator const char*() const { return is_null() ? nullptr : c_str(); }
+
+		// Gets a view of this, preserving null.
+		inline string_view view() const { return is_null() ? string_view(nullptr) : string_view(c_str(), length()); }
+		inline operator string_view() const { return view(); }
+
+		// Copies this into a new string, preserving null.
+		string to_string() const;
+
+	private:
+
+		// Releases any heap storage, leaving the tag unchanged.
+		void release();
+	};
 };
 
 
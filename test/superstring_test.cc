@@ -0,0 +1,1207 @@
+// superstring_test.cc - Differential checks of the superstring regex, split and count paths.
+// @kwegner
+
+/*
+MIT License
+
+Copyright (c) 2018 Kristen Wegner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+// Usage: superstring_test
+//
+// Checks the prefiltered and cached regex paths against plain std::regex, including the order in
+// which the DFA paths pick among matches from one start, match_all in chunks against the
+// sequential match_all, split against the original strtok-style tokenizer, index_of, searcher,
+// substring count and replace_all against std::string::find, the validators, escape and unescape
+// by fixed cases and round trips, keyword_set and replacer against trying every key at every
+// offset, glob against fnmatch where there is one, the allocations of a replace_all chain and
+// of a regex cache hit, and with C++20, parse<expression> against parse, over fixed edge cases
+// and generated inputs, printing each disagreement. Exits non-zero if there are any.
+
+
+#include <cstdio>
+#include <cstdint>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include <new>
+#include <string>
+#include <vector>
+#include <regex>
+#include <algorithm>
+
+#include "superstring.hh"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fnmatch.h>
+#define SUPERSTRING_TEST_FNMATCH
+#endif
+
+
+// The count of allocations made through the global operator new, to check how often a call allocates.
+static size_t allocations_ = 0;
+
+void* operator new(size_t size)
+{
+	++allocations_;
+
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+
+namespace
+{
+	// The count of failed checks.
+	size_t failures_ = 0;
+
+	// Records a failed check unless condition holds.
+	// Argument is the expression or delimiters the check was made with.
+	void check(bool condition, const char* what, const std::string& argument, const std::string& input)
+	{
+		if (condition)
+			return;
+
+		++failures_;
+		std::fprintf(stderr, "FAIL %s: argument \"%s\", input \"%s\"\n", what, argument.c_str(), input.c_str());
+	}
+
+	// Gets the next value of a deterministic generator.
+	uint32_t next(uint32_t& state)
+	{
+		state = state * 1664525U + 1013904223U;
+		return state >> 8;
+	}
+
+	// Checks string::match, which searches with the extended syntax through the cache and its
+	// prefilter, against std::regex_search. An invalid expression must throw from both, except
+	// for an empty input, which match rules out before compiling.
+	void check_match(const std::string& expression, const std::string& input)
+	{
+		bool expected = false, actual = false, expected_error = false, actual_error = false;
+
+		if (!input.empty())
+		{
+			try { expected = std::regex_search(input, std::regex(expression, std::regex_constants::extended | std::regex_constants::nosubs)); }
+			catch (const std::regex_error&) { expected_error = true; }
+		}
+
+		try { actual = super::string(input.c_str()).match(expression.c_str()); }
+		catch (const std::regex_error&) { actual_error = true; }
+
+		check(expected_error == actual_error && expected == actual, "match", expression, input);
+	}
+
+	// Bracket expressions, whose members the prefilter reads to rule out inputs.
+	void test_match_brackets()
+	{
+		static const char* const expressions[] =
+		{
+			"[\\]|c]xyz", "[\\]xyz", "[a\\]b", "[\\\\]", "[!-\\]x", "[\\-a]", "[]a]x", "[^]a]x", "[]|c]xyz",
+			"[a-]x", "[-a]x", "[[:alpha:]]x", "[[.a.]]x", "[\\n]x", "[^\\]x", "x[\\]|y", "([\\]|c)xyz",
+		};
+
+		static const char* const inputs[] =
+		{
+			"", "\\", "c", "xyz", "\\xyz", "cxyz", "]xyz", "|xyz", "a", "b", "ab", "\\b", "-", "-x", "ax",
+			"]x", "^x", "nx", "\\x", "y", "x\\", "x]", "zx", "[x",
+		};
+
+		for (const char* expression : expressions)
+			for (const char* input : inputs)
+				check_match(expression, input);
+
+		// Generated expressions over the characters that bracket parsing treats specially.
+		static const char alphabet[] = "[]\\^-|abcx(.)*+?:";
+
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 4000; ++i)
+		{
+			std::string expression(1, '[');
+
+			for (size_t n = next(state) % 5; n != 0; --n)
+				expression.push_back(alphabet[next(state) % (sizeof(alphabet) - 1)]);
+
+			expression.push_back(']');
+
+			for (size_t n = next(state) % 6; n != 0; --n)
+				expression.push_back(alphabet[next(state) % (sizeof(alphabet) - 1)]);
+
+			for (size_t j = 0; j < 8; ++j)
+			{
+				std::string input;
+
+				for (size_t n = next(state) % 6; n != 0; --n)
+					input.push_back(alphabet[next(state) % (sizeof(alphabet) - 1)]);
+
+				check_match(expression, input);
+			}
+		}
+	}
+
+	// Checks the positions of match_each over source, which may start within a larger buffer,
+	// against std::cregex_iterator over the same characters.
+	void check_match_each(const std::string& expression, const super::string_view& source)
+	{
+		const std::regex regex(expression, std::regex_constants::extended);
+		std::vector<size_t> expected, actual;
+
+		for (std::cregex_iterator i(source.begin(), source.end(), regex), end; i != end; ++i)
+			expected.push_back(size_t(i->position(0)));
+
+		for (const super::match_range::match& match : source.match_each(expression.c_str()))
+			actual.push_back(match.position());
+
+		check(expected == actual, "match_each position", expression, std::string(source.begin(), source.length()));
+	}
+
+	// Match positions, which are from the start of the source, not of each search.
+	void test_match_each_positions()
+	{
+		const super::string text("xx ab yy ab");
+		std::vector<size_t> positions;
+
+		for (const super::match_range::match& match : text.match_each("ab"))
+			positions.push_back(match.position());
+
+		check(positions == std::vector<size_t>({ 3, 9 }), "match_each position", "ab", "xx ab yy ab");
+
+		static const char* const expressions[] = { "ab", "a[b]", "[a-c]+", "b|ab", "x+y", "(a|x)b*" };
+		static const char alphabet[] = "abcxy ";
+
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 500; ++i)
+		{
+			std::string source;
+
+			for (size_t n = next(state) % 40; n != 0; --n)
+				source.push_back(alphabet[next(state) % (sizeof(alphabet) - 1)]);
+
+			const size_t start = source.empty() ? 0 : next(state) % source.length();
+
+			for (const char* expression : expressions)
+				check_match_each(expression, super::string_view(source.c_str()).substring(start));
+		}
+	}
+
+	// Splits input as the original strtok-style tokenize did: leading delimiters are skipped,
+	// then each delimiter ends a token, so adjacent and trailing ones give empty tokens.
+	std::vector<std::string> reference_split(const std::string& input, const char* delimiters)
+	{
+		std::vector<std::string> result;
+
+		if (input.empty())
+			return result;
+
+		size_t p = input.find_first_not_of(delimiters);
+
+		if (p == std::string::npos)
+			p = input.length();
+
+		for (;;)
+		{
+			const size_t q = std::min(input.find_first_of(delimiters, p), input.length());
+
+			result.push_back(input.substr(p, q - p));
+
+			if (q == input.length())
+				break;
+
+			p = q + 1;
+		}
+
+		return result;
+	}
+
+	// Checks each form of split, and tokens, against the reference.
+	void check_split(const std::string& input, const char* delimiters)
+	{
+		const std::vector<std::string> expected = reference_split(input, delimiters);
+		const super::string text(input.c_str());
+		std::vector<std::string> actual;
+
+		for (const super::string& token : text.split(delimiters))
+			actual.push_back(token.c_str());
+
+		check(expected == actual, "split(const char*)", delimiters, input);
+
+		if (delimiters[1] == '\0')
+		{
+			actual.clear();
+
+			for (const super::string& token : text.split(delimiters[0]))
+				actual.push_back(token.c_str());
+
+			check(expected == actual, "split(char)", delimiters, input);
+		}
+
+		std::vector<super::string_view> views;
+		super::string_view(input.c_str()).split(delimiters, views);
+		actual.clear();
+
+		for (const super::string_view& view : views)
+			actual.push_back(std::string(view.begin(), view.length()));
+
+		check(expected == actual, "string_view::split", delimiters, input);
+
+		super::string_table table;
+		text.split(delimiters, table);
+		actual.clear();
+
+		for (size_t i = 0; i < table.size(); ++i)
+			actual.push_back(std::string(table[i].begin(), table[i].length()));
+
+		check(expected == actual, "split(string_table&)", delimiters, input);
+
+		actual.clear();
+
+		for (const super::string_view& token : text.tokens(delimiters))
+			actual.push_back(std::string(token.begin(), token.length()));
+
+		check(expected == actual, "tokens", delimiters, input);
+	}
+
+	// Splits input on the needle as reference_split does on characters.
+	std::vector<std::string> reference_split_needle(const std::string& input, const std::string& needle)
+	{
+		std::vector<std::string> result;
+
+		if (input.empty())
+			return result;
+
+		size_t p = 0;
+
+		while (input.compare(p, needle.length(), needle) == 0)
+			p += needle.length();
+
+		for (;;)
+		{
+			const size_t q = std::min(input.find(needle, p), input.length());
+
+			result.push_back(input.substr(p, q - p));
+
+			if (q == input.length())
+				break;
+
+			p = q + needle.length();
+		}
+
+		return result;
+	}
+
+	// Checks split on a searcher against the reference.
+	void check_split_needle(const std::string& input, const std::string& needle)
+	{
+		std::vector<super::string_view> views;
+		std::vector<std::string> actual;
+
+		super::string_view(input.c_str()).split(super::searcher(super::string_view(needle.c_str())), views);
+
+		for (const super::string_view& view : views)
+			actual.push_back(std::string(view.begin(), view.length()));
+
+		check(reference_split_needle(input, needle) == actual, "split(const searcher&)", needle, input);
+	}
+
+	// Split keeps interior and trailing empty tokens, and skips only leading delimiters.
+	void test_split()
+	{
+		static const char* const inputs[] = { "", ",", ",,,", "a", "a,,b", "a,", ",a", ",,a,,", "a, b ,c", " ,a" };
+		static const char* const delimiters[] = { ",", ", " };
+
+		for (const char* input : inputs)
+		{
+			for (const char* set : delimiters)
+				check_split(input, set);
+
+			check_split_needle(input, ", ");
+		}
+
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 2000; ++i)
+		{
+			std::string input;
+
+			for (size_t n = next(state) % 20; n != 0; --n)
+				input.push_back("ab, "[next(state) % 4]);
+
+			check_split(input, delimiters[i % 2]);
+			check_split_needle(input, i % 2 == 0 ? ", " : "a");
+			check_split_needle(input, "aa");
+		}
+	}
+
+	// Counts the non-overlapping instances of needle in input, from the left.
+	size_t reference_count(const std::string& input, const std::string& needle)
+	{
+		size_t result = 0;
+
+		if (needle.empty())
+			return 0;
+
+		for (size_t p = input.find(needle); p != std::string::npos; p = input.find(needle, p + needle.length()))
+			++result;
+
+		return result;
+	}
+
+	// Checks count of a substring, given as a view, a super::string and a searcher, on both
+	// string and string_view, against the reference.
+	void check_count(const std::string& input, const std::string& needle)
+	{
+		const size_t expected = reference_count(input, needle);
+		const super::string text(input.c_str());
+		const super::string value(needle.c_str());
+		const super::string_view view(input.c_str());
+
+		check(text.count(value) == expected, "string::count(const string&)", needle, input);
+		check(text.count(super::string_view(needle.c_str())) == expected, "string::count(const string_view&)", needle, input);
+		check(text.count(super::searcher(value)) == expected, "string::count(const searcher&)", needle, input);
+		check(view.count(value) == expected, "string_view::count(const string&)", needle, input);
+		check(view.count(super::string_view(needle.c_str())) == expected, "string_view::count(const string_view&)", needle, input);
+	}
+
+	// Count of a substring, as opposed to a set, which a const char* is read as.
+	void test_count()
+	{
+		const super::string text("ab,abab,aab");
+
+		check(text.count("ab") == 9, "string::count(const char*)", "ab", "ab,abab,aab");
+		check(text.count(super::string_view("ab")) == 4, "string::count(const string_view&)", "ab", "ab,abab,aab");
+
+		static const char* const needles[] = { "a", "ab", "aa", "aba", ", " };
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 1000; ++i)
+		{
+			std::string input;
+
+			for (size_t n = next(state) % 48; n != 0; --n)
+				input.push_back("ab, "[next(state) % 4]);
+
+			for (const char* needle : needles)
+				check_count(input, needle);
+		}
+	}
+
+	// A field ends at its following literal text, which must be found, as with the equivalent
+	// regex parse.
+	void test_parse_format()
+	{
+		const super::string text("5 apples");
+		int x = -1, y = -1;
+
+		check(text.parse_format("{} pears", x) == 0 && x == -1, "parse_format", "{} pears", "5 apples");
+		check(text.parse("([0-9]+) pears", y) == 0, "parse", "([0-9]+) pears", "5 apples");
+		check(text.parse_format("{} apples!", x) == 0 && x == -1, "parse_format", "{} apples!", "5 apples");
+		check(text.parse_format("{} apples", x) == 1 && x == 5, "parse_format", "{} apples", "5 apples");
+		check(text.parse_format("{}", x) == 1, "parse_format", "{}", "5 apples");
+
+		const super::string pairs("a=1,b=2");
+		int a = 0, b = 0;
+
+		check(pairs.parse_format("a={},b={}", a, b) == 2 && a == 1 && b == 2, "parse_format", "a={},b={}", "a=1,b=2");
+		check(pairs.parse_format("a={};b={}", a, b) == 0, "parse_format", "a={};b={}", "a=1,b=2");
+	}
+
+#ifdef SUPERSTRING_STATIC_REGEX
+	// Checks parse<Expression>, compiled when compiling, against parse with the same expression
+	// at run time, for an expression with one capture group.
+	template <super::fixed_string Expression>
+	void check_static_parse(const std::string& input)
+	{
+		const super::string text(input.c_str());
+		std::string expected = "-", actual = "-";
+		const size_t expected_count = text.parse(Expression.value, expected);
+		const size_t actual_count = text.parse<Expression>(actual);
+
+		check(actual_count == expected_count && actual == expected, "parse<expression>", Expression.value, input);
+	}
+
+	// The static expressions, over generated inputs, including ones that match only at the end.
+	void test_static_parse()
+	{
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 500; ++i)
+		{
+			std::string input;
+
+			for (size_t n = next(state) % 8; n != 0; --n)
+				input.push_back("abcxy"[next(state) % 5]);
+
+			check_static_parse<"$(a*)">(input);
+			check_static_parse<"$(a)?">(input);
+			check_static_parse<"(a*)">(input);
+			check_static_parse<"(a*)$">(input);
+			check_static_parse<"^(b+)">(input);
+			check_static_parse<"(ab|a)b*">(input);
+			check_static_parse<"x?(a+?)b">(input);
+			check_static_parse<"([ab]{1,2})c">(input);
+			check_static_parse<"(.)$">(input);
+			check_static_parse<"y(b*)$">(input);
+			check_static_parse<"(?:ab)+(c?)">(input);
+			check_static_parse<"(c|)x">(input);
+		}
+	}
+#endif
+
+	// Checks match_all in chunks, on several threads, against the sequential match_all, with
+	// chunks smaller than the matches, and overlaps too short for them, including none.
+	void test_match_all_chunks()
+	{
+		static const char* const expressions[] = { "[a-z]+", "a[^x]*b", "(ab|a)*", "b+$", "^a+", "x*", "[ab]{2,5}", "(a|b)+x" };
+		static const size_t sizes[] = { 1, 3, 16 };
+		static const size_t overlaps[] = { 0, 2, 4096 };
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 200; ++i)
+		{
+			std::string input;
+
+			for (size_t n = next(state) % 64; n != 0; --n)
+				input.push_back("aab x,"[next(state) % 6]);
+
+			const super::string text(input.c_str());
+
+			for (const char* expression : expressions)
+			{
+				std::vector<super::string_view> expected, actual;
+
+				text.match_all(expression, expected);
+
+				for (size_t size : sizes)
+				{
+					for (size_t overlap : overlaps)
+					{
+						super::chunking chunks;
+
+						chunks.size = size;
+						chunks.overlap = overlap;
+						chunks.threads = 3;
+						actual.clear();
+						text.match_all(expression, actual, chunks);
+
+						bool same = actual.size() == expected.size();
+
+						for (size_t j = 0; same && j < actual.size(); ++j)
+							same = actual[j].begin() == expected[j].begin() && actual[j].length() == expected[j].length();
+
+						check(same, "match_all(chunking)", expression, input);
+					}
+				}
+			}
+
+#if __cplusplus > 201402L
+			// A multiline expression has no DFA, and is scanned sequentially.
+			std::vector<super::string_view> expected, actual;
+			super::chunking chunks;
+
+			chunks.size = 3;
+			chunks.overlap = 0;
+			chunks.threads = 3;
+			text.match_all("a+$", expected, false, true);
+			text.match_all("a+$", actual, chunks, false, true);
+			check(actual.size() == expected.size() && std::equal(actual.begin(), actual.end(), expected.begin(), [](const super::string_view& a, const super::string_view& b) { return a.begin() == b.begin() && a.length() == b.length(); }), "match_all(chunking, multiline)", "a+$", input);
+#endif
+		}
+	}
+
+	// A cache hit allocates nothing, even for an expression too long for a short string, and a
+	// capacity of zero caches nothing.
+	void test_regex_cache()
+	{
+		const char* const expression = "([a-z]+)@([a-z]+)\\.example\\.com";
+		const size_t capacity = super::regex_cache::capacity();
+
+		super::regex_cache::get(expression);
+
+		size_t before = allocations_;
+		const bool hit = super::regex_cache::get(expression) != nullptr;
+		const size_t count = allocations_ - before;
+
+		check(hit && count == 0, "allocations of regex_cache::get hit", expression, "");
+
+		super::regex_cache::capacity(0);
+
+		const size_t size = super::regex_cache::stats().size;
+		const bool distinct = super::regex_cache::get(expression) != super::regex_cache::get(expression);
+
+		check(size == 0 && distinct && super::regex_cache::stats().size == 0, "regex_cache::capacity(0)", expression, "");
+		super::regex_cache::capacity(capacity);
+	}
+
+	// Replaces all non-overlapping instances of needle in input with replacement, by std::string::find.
+	std::string reference_replace_all(std::string input, const std::string& needle, const std::string& replacement)
+	{
+		for (size_t p = input.find(needle); !needle.empty() && p != std::string::npos; p = input.find(needle, p + replacement.length()))
+			input.replace(p, needle.length(), replacement);
+
+		return input;
+	}
+
+	// Checks replace_all, in place, on a copy and with a searcher, against the reference, and
+	// that a chain through replace_all allocates once for the copy, and once more for a result
+	// of another length, whatever the count of instances.
+	void test_replace_all()
+	{
+		static const char* const needles[] = { "a", "ab", "aba", "ab, ab, ab, ab, ab, ab", "ab, ab, ab, ab, ab, ab, ab, ab, ab, ab, ab" };
+		static const char* const replacements[] = { "", "x", "xy", "xyz" };
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 500; ++i)
+		{
+			std::string input;
+
+			for (size_t n = next(state) % 200; n != 0; --n)
+				input.push_back("ab, "[next(state) % 4]);
+
+			for (const char* needle : needles)
+			{
+				for (const char* replacement : replacements)
+				{
+					const std::string expected = reference_replace_all(input, needle, replacement);
+					const super::string text(input.c_str());
+					super::string value(input.c_str()), other(input.c_str());
+
+					value.replace_all(needle, replacement);
+					other.replace_all(super::searcher(needle), replacement);
+
+					check(value == expected.c_str(), "string::replace_all(const char*, const char*) &", needle, input);
+					check(text.replace_all(needle, replacement) == expected.c_str(), "string::replace_all(const char*, const char*) const &", needle, input);
+					check(other == expected.c_str(), "string::replace_all(const searcher&, const char*) &", needle, input);
+					check(text.replace_all(std::string(needle), std::string(replacement)) == expected.c_str(), "string::replace_all(const std::string&, const std::string&) const &", needle, input);
+				}
+			}
+		}
+
+		// The counts are taken before check, whose arguments allocate.
+		const super::string cs("  The Quick Brown Fox And A Lazy Dog Ate A Banana.  ");
+		const super::string many(std::string(100, 'a').c_str());
+		size_t counts[4], lengths[4];
+		size_t before = allocations_;
+
+		lengths[0] = cs.trim().to_lower().replace_all("a", "b").length();
+		counts[0] = allocations_ - before;
+		before = allocations_;
+		lengths[1] = cs.trim().to_lower().replace_all("a", "xy").length();
+		counts[1] = allocations_ - before;
+		before = allocations_;
+		lengths[2] = many.replace_all("a", "xy").length();
+		counts[2] = allocations_ - before;
+		before = allocations_;
+		lengths[3] = cs.to_lower().replace_all("quick brown fox and", "x").length();
+		counts[3] = allocations_ - before;
+
+		check(lengths[0] == 48 && counts[0] == 1, "allocations of trim().to_lower().replace_all", "a", cs.c_str());
+		check(lengths[1] == 56 && counts[1] == 2, "allocations of trim().to_lower().replace_all", "a", cs.c_str());
+		check(lengths[2] == 200 && counts[2] == 1, "allocations of replace_all", "a", many.c_str());
+		check(lengths[3] == 34 && counts[3] == 2, "allocations of to_lower().replace_all", "quick brown fox and", cs.c_str());
+	}
+
+	// Describes each match of a regex_iterator-style search, as the offset and length of each
+	// group, or "-" for one that did not take part.
+	std::string describe(const std::vector<std::vector<super::string_view>>& matches, const char* source)
+	{
+		std::string result;
+
+		for (const std::vector<super::string_view>& groups : matches)
+		{
+			for (const super::string_view& group : groups)
+				result += group.is_null() ? std::string("-") : std::to_string(group.begin() - source) + "+" + std::to_string(group.length());
+
+			result += ';';
+		}
+
+		return result;
+	}
+
+	// Checks match_all, match_each with its groups, pattern::find_all and replace_all with a
+	// pattern, which scan with the DFA where the expression has one, against std::regex, whose
+	// backtracking picks among matches from the same start by the order of its alternatives.
+	void check_match_order(const std::string& expression, const std::string& input)
+	{
+		std::regex regex;
+
+		try { regex = std::regex(expression, std::regex_constants::extended); }
+		catch (const std::regex_error&) { return; }
+
+		const super::string text(input.c_str());
+		const char* source = text.c_str();
+		std::vector<std::vector<super::string_view>> expected, each, all, found;
+
+		for (std::cregex_iterator i(source, source + text.length(), regex), end; i != end; ++i)
+		{
+			expected.emplace_back();
+
+			for (size_t j = 0; j < i->size(); ++j)
+				expected.back().push_back((*i)[j].matched ? super::string_view((*i)[j].first, size_t((*i)[j].length())) : super::string_view(nullptr));
+		}
+
+		for (const super::match_range::match& match : text.match_each(expression.c_str()))
+		{
+			each.emplace_back();
+
+			for (size_t j = 0; j < match.size(); ++j)
+				each.back().push_back(match.group(j));
+		}
+
+		std::vector<super::string_view> views;
+
+		text.match_all(expression.c_str(), views);
+
+		for (const super::string_view& view : views)
+			all.push_back({ view });
+
+		super::pattern compiled(expression.c_str(), std::regex_constants::extended);
+
+		views.clear();
+		compiled.find_all(text, views);
+
+		for (const super::string_view& view : views)
+			found.push_back({ view });
+
+		std::vector<std::vector<super::string_view>> wholes;
+
+		for (const std::vector<super::string_view>& groups : expected)
+			wholes.push_back({ groups[0] });
+
+		super::string replaced(text);
+
+		replaced.replace_all(compiled, "<$&|$1>");
+
+		check(describe(each, source) == describe(expected, source), "match_each order", expression, input);
+		check(describe(all, source) == describe(wholes, source), "match_all order", expression, input);
+		check(describe(found, source) == describe(wholes, source), "pattern::find_all order", expression, input);
+		check(replaced == std::regex_replace(input, regex, "<$&|$1>").c_str(), "replace_all(pattern) order", expression, input);
+	}
+
+	// Appends a generated extended expression over a few atoms, with up to depth more levels
+	// of groups and alternatives.
+	void generate_expression(uint32_t& state, size_t depth, std::string& expression)
+	{
+		static const char* const atoms[] = { "a", "b", "A", "x", ".", "[[:alpha:]]", "[^a]", "[ab]", "^", "$" };
+		static const char* const repeats[] = { "", "", "", "?", "*", "+", "{1,2}", "{2}" };
+
+		for (size_t n = 1 + next(state) % 3; n != 0; --n)
+		{
+			if (depth != 0 && next(state) % 5 == 0)
+			{
+				expression.push_back('(');
+				generate_expression(state, depth - 1, expression);
+				expression.push_back(')');
+			}
+			else expression += atoms[next(state) % (sizeof(atoms) / sizeof(atoms[0]))];
+
+			expression += repeats[next(state) % (sizeof(repeats) / sizeof(repeats[0]))];
+		}
+
+		if (depth != 0 && next(state) % 4 == 0)
+		{
+			expression.push_back('|');
+			generate_expression(state, depth - 1, expression);
+		}
+	}
+
+	// Matches where the longest from a start is not the one std::regex picks, an expression on
+	// which std::regex backtracks without end from every position it searches, and inputs long
+	// enough that match_each scans them in several windows, with matches across their ends.
+	void test_match_order()
+	{
+		check_match_order("[[:alpha:]]b?([^a]{2}A)?", "xbabbA");
+		check_match_order("([[:alpha:]][[:alpha:]]{1,2})+", "cabayAy");
+		check_match_order("(a|ab)(c|bcd)", "abcd");
+
+		const super::string text("abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz");
+		std::vector<size_t> lengths;
+
+		for (const super::match_range::match& match : text.match_each("(.*)+^"))
+			lengths.push_back(match.view().length());
+
+		check(lengths == std::vector<size_t>({ 0 }), "match_each", "(.*)+^", text.c_str());
+
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 1500; ++i)
+		{
+			std::string expression;
+
+			generate_expression(state, 2, expression);
+
+			for (size_t j = 0; j < 4; ++j)
+			{
+				std::string input;
+
+				for (size_t n = 1 + next(state) % 12; n != 0; --n)
+					input.push_back("abAx,"[next(state) % 5]);
+
+				check_match_order(expression, input);
+			}
+		}
+
+		static const char* const expressions[] =
+		{
+			"[ab]+x?", "a|ab", "(x|xA)[^,]*,", "b*", "[^,]*", "(a|b)*A", "[[:alpha:]]b?([^a]{2}A)?", "x[^x]*,", "$", "^a*",
+			"(a|ab)(b|bx)?", "[^x]{100,}",
+		};
+
+		for (size_t i = 0; i < 20; ++i)
+		{
+			const char* const alphabet = i % 2 == 0 ? "aaaaaabbbbAx," : "abAx,";
+			const size_t size = std::strlen(alphabet);
+			std::string input;
+
+			for (size_t n = 200 + next(state) % 3000; n != 0; --n)
+				input.push_back(alphabet[next(state) % size]);
+
+			for (const char* expression : expressions)
+				check_match_order(expression, input);
+		}
+	}
+
+	// Checks index_of and last_index_of, of a character and of a substring, on a string and a
+	// view, from the default and from every explicit offset, against std::string::find and
+	// rfind. The offset of last_index_of is counted from the end.
+	void check_index_of(const std::string& input, const std::string& needle)
+	{
+		const super::string text(input.c_str());
+		const super::string_view view(input);
+		const size_t length = input.length(), n = needle.length();
+		const size_t npos = super::string_view::npos;
+		const char c = needle.empty() ? 'a' : needle[0];
+		const auto index = [](size_t offset) { return offset == std::string::npos ? -1 : int(offset); };
+
+		for (size_t start = 0; start <= length + 1; ++start)
+		{
+			const size_t from = start == length + 1 ? npos : start;
+			const size_t offset = from == npos ? 0 : from;
+
+			const int first_char = index(input.find(c, offset));
+			const int last_char = offset >= length ? -1 : index(input.rfind(c, length - offset - 1));
+			const int first = index(input.find(needle, offset));
+			const int last = offset > length || length - offset < n ? -1 : index(input.rfind(needle, length - offset - n));
+
+			check(view.index_of(c, from) == first_char && text.index_of(c, from) == first_char, "index_of(char)", needle, input);
+			check(view.last_index_of(c, from) == last_char && text.last_index_of(c, from) == last_char, "last_index_of(char)", needle, input);
+			check(view.index_of(super::string_view(needle), from) == first && text.index_of(super::string_view(needle), from) == first, "index_of(const string_view&)", needle, input);
+			check(view.last_index_of(super::string_view(needle), from) == last && text.last_index_of(super::string_view(needle), from) == last, "last_index_of(const string_view&)", needle, input);
+		}
+	}
+
+	// Offsets, which are from the start of this, not of the search, and matches at either end.
+	void test_index_of()
+	{
+		const super::string text("abcabc");
+
+		check(text.index_of('b') == 1 && text.index_of('b', 2) == 4 && text.index_of('b', 5) == -1, "index_of(char)", "b", "abcabc");
+		check(text.last_index_of('a') == 3 && text.last_index_of('a', 3) == 0 && text.last_index_of('c', 1) == 2, "last_index_of(char)", "a", "abcabc");
+
+		static const char* const needles[] = { "", "a", "b", "ab", "ba", "aab", "abab" };
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 300; ++i)
+		{
+			std::string input;
+
+			for (size_t n = next(state) % 12; n != 0; --n)
+				input.push_back("ab"[next(state) % 2]);
+
+			for (const char* needle : needles)
+				check_index_of(input, needle);
+		}
+	}
+
+	// The validators and conversions corrected with the string_view port: a null string is not
+	// a character, an unsigned integer keeps its first digit, a float may have a whole part of
+	// 0, and is_strictly takes negative values down to the least of the type.
+	void test_validators()
+	{
+		const super::string null;
+
+		check(super::string("a").is_char() && !super::string("ab").is_char() && !super::string("").is_char() && !null.is_char(), "is_char", "", "a");
+		check(super::string_view("a").is_char() && !super::string_view("").is_char(), "string_view::is_char", "", "a");
+
+		check(super::string("7").is_unsigned_decimal_integer() && super::string("123").is_unsigned_decimal_integer(), "is_unsigned_decimal_integer", "", "7");
+		check(!super::string("x12").is_unsigned_decimal_integer() && !super::string("-12").is_unsigned_decimal_integer(), "is_unsigned_decimal_integer", "", "x12");
+
+		check(super::string("0.5").is_decimal_float() && super::string("3.14159").is_decimal_float(), "is_decimal_float", "", "0.5");
+		check(super::string("3.14159").to_double() == 3.14159 && super::string("3.14159").to_int() == 3, "to_double", "", "3.14159");
+
+		check(super::string::is_strictly<signed char>("-128") && !super::string::is_strictly<signed char>("-129"), "is_strictly<signed char>", "", "-128");
+		check(super::string::is_strictly<signed char>("127") && !super::string::is_strictly<signed char>("128"), "is_strictly<signed char>", "", "127");
+		check(super::string::is_strictly<int>("-2147483648") && !super::string::is_strictly<int>("-2147483649"), "is_strictly<int>", "", "-2147483648");
+		check(super::string::is_strictly<long long>("-9223372036854775808"), "is_strictly<long long>", "", "-9223372036854775808");
+		check(super::string::is_strictly<float>("-1.5") && super::string::is_strictly<double>("-0.5"), "is_strictly<float>", "", "-1.5");
+
+		const std::string large = "1" + std::string(40, '0') + ".0";
+
+		check(!super::string::is_strictly<float>(("-" + large).c_str()) && super::string::is_strictly<double>(("-" + large).c_str()), "is_strictly<float>", "", "-" + large);
+	}
+
+	// Escapes and unescapes: fixed cases for each corrected path, and round trips of generated
+	// bytes through JSON and URL escaping, which unescape restores exactly.
+	void test_escape()
+	{
+		typedef super::string::escaping escaping;
+
+		check(super::string("a\"b\\c\n\x01").escape(escaping::json) == "a\\\"b\\\\c\\n\\u0001", "escape(json)", "", "a\"b\\c\n\x01");
+		check(super::string("\\\"\\/\\47\\x41").unescape(escaping::json) == "\"/'A", "unescape(json)", "", "\\\"\\/\\47\\x41");
+		check(super::string("\\u0041\\u00e9\\u20ac").unescape(escaping::json) == "A\xC3\xA9\xE2\x82\xAC", "unescape(json) \\u", "", "\\u0041\\u00e9\\u20ac");
+		check(super::string("a b\x1F\xAB").escape(escaping::url) == "a+b%1F%AB", "escape(url)", "", "a b\x1F\xAB");
+		check(super::string("a b\xAB").escape(escaping::rfc3986) == "a%20b%AB", "escape(rfc3986)", "", "a b\xAB");
+		check(super::string("<a&b>\xE9").escape(escaping::entities) == "&lt;a&amp;b&gt;&eacute;", "escape(entities)", "", "<a&b>\xE9");
+
+		std::string bytes;
+
+		for (int c = 1; c < 256; ++c)
+			bytes.push_back(char(c));
+
+		check(super::string(bytes.c_str()).escape(escaping::entities).length() > bytes.length(), "escape(entities) of every byte", "", "");
+
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 2000; ++i)
+		{
+			std::string input;
+
+			for (size_t n = next(state) % 24; n != 0; --n)
+				input.push_back(char(1 + next(state) % 255));
+
+			const super::string text(input.c_str());
+
+			check(text.escape(escaping::json).unescape(escaping::json) == text, "unescape(escape(json))", "", input);
+			check(text.escape(escaping::url).unescape(escaping::url) == text, "unescape(escape(url))", "", input);
+			check(text.escape(escaping::rfc3986).unescape(escaping::url) == text, "unescape(escape(rfc3986))", "", input);
+		}
+	}
+
+	// Checks searcher::find from every start of haystack against std::string::find.
+	void check_searcher(const std::string& needle, const std::string& haystack)
+	{
+		const super::searcher searcher{ super::string_view(needle) };
+		const super::string_view view(haystack);
+
+		for (size_t start = 0; start <= haystack.length() + 1; ++start)
+		{
+			const size_t expected = haystack.find(needle, start);
+			const size_t actual = searcher.find(view, start);
+
+			check(actual == (expected == std::string::npos ? super::string_view::npos : expected), "searcher::find", needle, haystack);
+		}
+	}
+
+	// Needles for each of the searcher's algorithms: empty, one byte, up to pair_limit bytes for
+	// the packed-pair filter, and longer, with more than 8 distinct bytes for Horspool and fewer
+	// for Two-Way, including periodic ones. Many are cut from the haystack, so as to be found.
+	void test_searcher()
+	{
+		static const char* const alphabets[] = { "ab", "aab", "abc", "abcdefghijklmnopqrstuvwxyz" };
+		size_t chosen[5] = { 0 };
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 3000; ++i)
+		{
+			const char* const alphabet = alphabets[i % 4];
+			const size_t size = std::strlen(alphabet);
+			std::string haystack, needle;
+
+			for (size_t n = next(state) % 200; n != 0; --n)
+				haystack.push_back(alphabet[next(state) % size]);
+
+			const size_t length = next(state) % 4 == 0 ? next(state) % 4 : next(state) % 80;
+
+			if (next(state) % 2 == 0 && length <= haystack.length())
+				needle = haystack.substr(next(state) % (haystack.length() - length + 1), length);
+			else
+			{
+				for (size_t n = length; n != 0; --n)
+					needle.push_back(alphabet[next(state) % size]);
+			}
+
+			++chosen[size_t(super::searcher(super::string_view(needle)).chosen())];
+			check_searcher(needle, haystack);
+		}
+
+		for (size_t count : chosen)
+			check(count != 0, "searcher algorithm coverage", "", "");
+	}
+
+	// True if key occurs in text at offset, ignoring ASCII case if caseless.
+	bool occurs(const std::string& text, size_t offset, const std::string& key, bool caseless)
+	{
+		if (offset + key.length() > text.length())
+			return false;
+
+		for (size_t i = 0; i < key.length(); ++i)
+		{
+			const char a = text[offset + i], b = key[i];
+
+			if (a != b && !(caseless && std::tolower((unsigned char)a) == std::tolower((unsigned char)b)))
+				return false;
+		}
+
+		return true;
+	}
+
+	// Describes keyword_set matches as the keyword index, offset and length of each.
+	std::string describe(const std::vector<super::keyword_set::match>& matches, const char* text)
+	{
+		std::string result;
+
+		for (const super::keyword_set::match& match : matches)
+			result += std::to_string(match.keyword) + "@" + std::to_string(match.view.begin() - text) + "+" + std::to_string(match.view.length()) + ";";
+
+		return result;
+	}
+
+	// Checks keyword_set and replacer against trying every key at every offset of text.
+	void check_keywords(const std::vector<std::string>& keys, const std::string& text, bool caseless)
+	{
+		std::vector<std::pair<std::string, std::string>> replacements;
+		std::string argument;
+
+		for (size_t i = 0; i < keys.size(); ++i)
+		{
+			replacements.emplace_back(keys[i], "<" + std::to_string(i) + ">");
+			argument += keys[i] + "|";
+		}
+
+		const super::keyword_set set(keys, caseless);
+		const super::replacer replacer(replacements, caseless);
+		const super::string_view view(text);
+
+		// Every occurrence, by where it ends, then the longest, then the first listed.
+		std::vector<super::keyword_set::match> expected, actual;
+		std::vector<uint64_t> expected_mask((keys.size() + 63) / 64, 0), actual_mask;
+
+		for (size_t end = 1; end <= text.length(); ++end)
+			for (size_t length = end; length != 0; --length)
+				for (size_t i = 0; i < keys.size(); ++i)
+					if (keys[i].length() == length && occurs(text, end - length, keys[i], caseless))
+					{
+						expected.push_back({ i, view.substring(end - length, length) });
+						expected_mask[i / 64] |= uint64_t(1) << (i % 64);
+					}
+
+		set.find_all(view, actual);
+
+		// Occurrences of equal keys may come in either order, but not out of order otherwise.
+		const auto order = [](const super::keyword_set::match& a, const super::keyword_set::match& b)
+		{
+			return a.view.end() != b.view.end() ? a.view.end() < b.view.end() : a.view.length() > b.view.length();
+		};
+
+		check(std::is_sorted(actual.begin(), actual.end(), order), "keyword_set::find_all order", argument, text);
+
+		std::stable_sort(actual.begin(), actual.end(), [](const super::keyword_set::match& a, const super::keyword_set::match& b)
+		{
+			return a.view.end() != b.view.end() ? a.view.end() < b.view.end() : a.view.length() != b.view.length() ? a.view.length() > b.view.length() : a.keyword < b.keyword;
+		});
+
+		check(describe(actual, text.c_str()) == describe(expected, text.c_str()), "keyword_set::find_all", argument, text);
+
+		super::keyword_set::match first = { 0, super::string_view(nullptr) };
+		const bool found = set.find_first(view, first);
+
+		check(found == !expected.empty() && (!found || (first.view.begin() == expected[0].view.begin() && first.view.length() == expected[0].view.length())), "keyword_set::find_first", argument, text);
+
+		const size_t distinct = set.find_mask(view, actual_mask);
+		size_t expected_distinct = 0;
+
+		for (uint64_t word : expected_mask)
+			for (; word != 0; word &= word - 1)
+				++expected_distinct;
+
+		check(actual_mask == expected_mask && distinct == expected_distinct, "keyword_set::find_mask", argument, text);
+
+		// The leftmost occurrence, then the longest, then the first listed, replaced in turn.
+		std::vector<super::keyword_set::match> replaced, found_replaced;
+		std::string output;
+
+		for (size_t at = 0; at < text.length(); )
+		{
+			size_t best = keys.size();
+
+			for (size_t i = 0; i < keys.size(); ++i)
+				if (!keys[i].empty() && occurs(text, at, keys[i], caseless) && (best == keys.size() || keys[i].length() > keys[best].length()))
+					best = i;
+
+			if (best == keys.size())
+			{
+				output.push_back(text[at++]);
+				continue;
+			}
+
+			replaced.push_back({ best, view.substring(at, keys[best].length()) });
+			output += replacements[best].second;
+			at += keys[best].length();
+		}
+
+		replacer.find(view, found_replaced);
+
+		super::string value(text.c_str());
+		const size_t count = value.replace_all(replacer);
+
+		check(describe(found_replaced, text.c_str()) == describe(replaced, text.c_str()), "replacer::find", argument, text);
+		check(count == replaced.size() && value == output.c_str(), "replace_all(replacer)", argument, text);
+	}
+
+	// Generated key sets over a few letters, with empty, repeated and nested keys, exact and
+	// caseless, over texts with both cases.
+	void test_keyword_set()
+	{
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 2000; ++i)
+		{
+			const bool caseless = i % 2 != 0;
+			std::vector<std::string> keys(1 + next(state) % 8);
+			std::string text;
+
+			for (std::string& key : keys)
+				for (size_t n = next(state) % 5; n != 0; --n)
+					key.push_back("abcA"[next(state) % 4]);
+
+			for (size_t n = next(state) % 40; n != 0; --n)
+				text.push_back("abcAB"[next(state) % 5]);
+
+			check_keywords(keys, text, caseless);
+		}
+	}
+
+#ifdef SUPERSTRING_TEST_FNMATCH
+	// Checks glob::matches against fnmatch, with FNM_CASEFOLD if caseless.
+	void check_glob(const std::string& pattern, const std::string& value, bool caseless)
+	{
+		const bool expected = fnmatch(pattern.c_str(), value.c_str(), caseless ? FNM_CASEFOLD : 0) == 0;
+
+		check(super::glob(pattern.c_str(), caseless).matches(value.c_str()) == expected, caseless ? "glob::matches caseless" : "glob::matches", pattern, value);
+	}
+
+	// Generated patterns over the characters glob treats specially, including brackets left
+	// open, which are literal, and short values, then patterns of literals and stars over long
+	// values, whose pieces the SIMD filter finds. fnmatch rejects a pattern ending in a lone \,
+	// which glob takes as literal, so none is generated; and where FNM_CASEFOLD folds a range by
+	// its bounds, glob takes the other case of each letter in it, so caseless patterns have none.
+	void test_glob()
+	{
+		static const char alphabet[] = "abAB*?[]!^-\\";
+		uint32_t state = 0x2545F491U;
+
+		for (size_t i = 0; i < 20000; ++i)
+		{
+			const bool caseless = i % 2 != 0;
+			std::string pattern;
+
+			for (size_t n = next(state) % 8; n != 0; --n)
+			{
+				const char c = alphabet[next(state) % (sizeof(alphabet) - 1)];
+
+				pattern.push_back(caseless && c == '-' ? 'a' : c);
+			}
+
+			if (!pattern.empty() && pattern.back() == '\\')
+				pattern.push_back('a');
+
+			for (size_t j = 0; j < 4; ++j)
+			{
+				std::string value;
+
+				for (size_t n = next(state) % 8; n != 0; --n)
+					value.push_back("abAB-]![\\"[next(state) % 9]);
+
+				check_glob(pattern, value, caseless);
+			}
+		}
+
+		for (size_t i = 0; i < 2000; ++i)
+		{
+			const bool caseless = i % 2 != 0;
+			std::string pattern, value;
+
+			for (size_t n = next(state) % 12; n != 0; --n)
+				pattern.push_back("aabB**?"[next(state) % 7]);
+
+			for (size_t n = next(state) % 80; n != 0; --n)
+				value.push_back("aab"[next(state) % 3]);
+
+			check_glob(pattern, value, caseless);
+		}
+	}
+#endif
+
+	// append(const char*) chains on a temporary like prepend, and formats only with arguments.
+	void test_append_chain()
+	{
+		const super::string text("a-b");
+		super::string value("a-b");
+
+		check(super::string(text).replace("-", "+").append("x").prepend("y") == "ya+bx", "append(const char*) &&", "x", "a-b");
+		check(text.append("x") == "a-bx" && text == "a-b", "append(const char*) const &", "x", "a-b");
+		check(&value.append("%d") == &value && value == "a-b%d", "append(const char*) &", "%d", "a-b");
+		check(value.append("%d", 5) && value == "a-b%d5", "append(const char*, ...)", "%d", "a-b%d");
+	}
+}
+
+
+int main()
+{
+	test_match_brackets();
+	test_match_each_positions();
+	test_match_order();
+	test_split();
+	test_count();
+	test_index_of();
+	test_validators();
+	test_escape();
+	test_searcher();
+	test_keyword_set();
+#ifdef SUPERSTRING_TEST_FNMATCH
+	test_glob();
+#endif
+	test_parse_format();
+	test_match_all_chunks();
+	test_regex_cache();
+	test_replace_all();
+	test_append_chain();
+#ifdef SUPERSTRING_STATIC_REGEX
+	test_static_parse();
+#endif
+
+	if (failures_ != 0)
+	{
+		std::fprintf(stderr, "%zu checks failed\n", failures_);
+		return 1;
+	}
+
+	std::printf("All checks passed\n");
+	return 0;
+}